@@ -8,21 +8,293 @@
 // -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
 // -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
 
+
 #include "TBBBenchmark.h"
-#include <Windows.h>
 
-// benchmark data
-LARGE_INTEGER StartTime, StopTime;
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <sstream>
+
+// RunBenchmark
+// each run is timed on its own, so that a single slow run shows up in p95 and stddev instead of inflating an average
+
+BenchmarkStatistics RunBenchmark(const std::function<void()> &Function, const BenchmarkOptions &Options)
+{
+	for (int i = 0; i < Options.WarmupRuns; i++)
+		Function();
+	std::vector<double> SamplesNs;
+	SamplesNs.reserve(Options.Repetitions);
+	for (int i = 0; i < Options.Repetitions; i++)
+	{
+		BenchmarkTimer Timer;
+		Function();
+		SamplesNs.push_back(Timer.GetElapsedNs());
+	}
+	return ComputeBenchmarkStatistics(SamplesNs);
+}
+
+// ComputeBenchmarkStatistics
+// the samples are taken by value as they get sorted
+
+BenchmarkStatistics ComputeBenchmarkStatistics(std::vector<double> SamplesNs)
+{
+	BenchmarkStatistics Statistics = { 0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	const int Count = (int)SamplesNs.size();
+	if (Count == 0)
+		return Statistics;
+	std::sort(SamplesNs.begin(), SamplesNs.end());
+	Statistics.Repetitions = Count;
+	Statistics.MinNs = SamplesNs[0];
+	Statistics.MedianNs = (Count % 2) ? SamplesNs[Count / 2] : (SamplesNs[Count / 2 - 1] + SamplesNs[Count / 2]) / 2.0;
+	Statistics.P95Ns = GetPercentile(SamplesNs, 95.0);
+	double Sum = 0.0;
+	for (int i = 0; i < Count; i++)
+		Sum += SamplesNs[i];
+	Statistics.MeanNs = Sum / Count;
+	if (Count > 1)
+	{
+		double SquaredDeviations = 0.0;
+		for (int i = 0; i < Count; i++)
+			SquaredDeviations += (SamplesNs[i] - Statistics.MeanNs) * (SamplesNs[i] - Statistics.MeanNs);
+		Statistics.StdDevNs = std::sqrt(SquaredDeviations / (Count - 1));
+	}
+	return Statistics;
+}
+
+// GetPercentile
+// the smallest sample such that at least Percentile % of the samples are not greater than it
+
+double GetPercentile(const std::vector<double> &SortedSamples, double Percentile)
+{
+	const int Count = (int)SortedSamples.size();
+	if (Count == 0)
+		return 0.0;
+	const int Rank = (int)std::ceil(Percentile / 100.0 * Count);
+	return SortedSamples[std::min(std::max(Rank, 1), Count) - 1];
+}
+
+// FillRandomImage
+// the top byte of each minstd_rand output, its low bits are less random
+
+void FillRandomImage(unsigned char *Image, size_t Size, unsigned int Seed)
+{
+	std::minstd_rand Generator(Seed);
+	for (size_t i = 0; i < Size; i++)
+		Image[i] = (unsigned char)(Generator() >> 23);
+}
+
+std::vector<unsigned char> CreateRandomImage(size_t Size, unsigned int Seed)
+{
+	std::vector<unsigned char> Image(Size);
+	if (Size > 0)
+		FillRandomImage(&Image[0], Size, Seed);
+	return Image;
+}
+
+double GetMegapixelsPerSecond(const BenchmarkResult &Result)
+{
+	if (Result.Statistics.MedianNs <= 0.0)
+		return 0.0;
+	return ((double)Result.ImageWidth * Result.ImageHeight) / Result.Statistics.MedianNs * 1e3;
+}
+
+double GetGBPerSecond(const BenchmarkResult &Result)
+{
+	if (Result.Statistics.MedianNs <= 0.0)
+		return 0.0;
+	return Result.BytesPerRun / Result.Statistics.MedianNs;
+}
+
+// QuoteJSON
+// implementation names are plain text, only quotes, backslashes and control characters need escaping
+
+static std::string QuoteJSON(const std::string &Text)
+{
+	std::string Quoted = "\"";
+	for (size_t i = 0; i < Text.length(); i++)
+	{
+		unsigned char Character = (unsigned char)Text[i];
+		if ((Character == '"') || (Character == '\\'))
+		{
+			Quoted += '\\';
+			Quoted += Text[i];
+		}
+		else if (Character < 0x20)
+		{
+			static const char HexDigits[] = "0123456789abcdef";
+			Quoted += "\\u00";
+			Quoted += HexDigits[Character >> 4];
+			Quoted += HexDigits[Character & 15];
+		}
+		else
+			Quoted += Text[i];
+	}
+	return Quoted + "\"";
+}
 
-void StartBenchmark()
+// QuoteCSV
+// fields are quoted only when they contain a separator, a quote or a line break
+
+static std::string QuoteCSV(const std::string &Text)
 {
-	QueryPerformanceCounter(&StartTime);
+	if (Text.find_first_of(",\"\r\n") == std::string::npos)
+		return Text;
+	std::string Quoted = "\"";
+	for (size_t i = 0; i < Text.length(); i++)
+	{
+		if (Text[i] == '"')
+			Quoted += '"';
+		Quoted += Text[i];
+	}
+	return Quoted + "\"";
 }
 
-void StopBenchmark(std::string Description)
+BenchmarkReport::BenchmarkReport(std::ostream &Stream, BenchmarkFormat Format) : Stream(Stream), Format(Format), ResultCount(0)
 {
-	QueryPerformanceCounter(&StopTime);
-	std::cout << " Elapsed time of " << Description;
-	std::cout.width(max(0, 20 - Description.length()));
-	std::cout << (int)(StopTime.QuadPart - StartTime.QuadPart) << std::endl;
-}
\ No newline at end of file
+	switch (Format)
+	{
+	case BENCHMARK_FORMAT_CSV:
+		Stream << "implementation,width,height,repetitions,min_ns,median_ns,p95_ns,mean_ns,stddev_ns,mpixels_per_s,gb_per_s" << std::endl;
+		break;
+	case BENCHMARK_FORMAT_JSON:
+		Stream << "[";
+		break;
+	default:
+		Stream << std::left << std::setw(20) << "Implementation" << std::right << std::setw(12) << "Size"
+			   << std::setw(14) << "min ns" << std::setw(14) << "median ns" << std::setw(14) << "p95 ns"
+			   << std::setw(10) << "stddev %" << std::setw(12) << "Mpixels/s" << std::setw(10) << "GB/s" << std::endl;
+		break;
+	}
+}
+
+BenchmarkReport::~BenchmarkReport()
+{
+	if (Format == BENCHMARK_FORMAT_JSON)
+		Stream << (ResultCount ? "\n]" : "]") << std::endl;
+}
+
+void BenchmarkReport::Add(const BenchmarkResult &Result)
+{
+	const BenchmarkStatistics &Statistics = Result.Statistics;
+	std::ios::fmtflags Flags = Stream.flags();
+	std::streamsize Precision = Stream.precision();
+	switch (Format)
+	{
+	case BENCHMARK_FORMAT_CSV:
+		Stream << QuoteCSV(Result.Implementation) << "," << Result.ImageWidth << "," << Result.ImageHeight << ","
+			   << Statistics.Repetitions << "," << std::fixed << std::setprecision(0) << Statistics.MinNs << ","
+			   << Statistics.MedianNs << "," << Statistics.P95Ns << "," << Statistics.MeanNs << "," << Statistics.StdDevNs << ","
+			   << std::setprecision(3) << GetMegapixelsPerSecond(Result) << "," << GetGBPerSecond(Result) << std::endl;
+		break;
+	case BENCHMARK_FORMAT_JSON:
+		Stream << (ResultCount ? ",\n  {" : "\n  {") << "\"implementation\": " << QuoteJSON(Result.Implementation)
+			   << ", \"width\": " << Result.ImageWidth << ", \"height\": " << Result.ImageHeight
+			   << ", \"repetitions\": " << Statistics.Repetitions << std::fixed << std::setprecision(0)
+			   << ", \"min_ns\": " << Statistics.MinNs << ", \"median_ns\": " << Statistics.MedianNs
+			   << ", \"p95_ns\": " << Statistics.P95Ns << ", \"mean_ns\": " << Statistics.MeanNs
+			   << ", \"stddev_ns\": " << Statistics.StdDevNs << std::setprecision(3)
+			   << ", \"mpixels_per_s\": " << GetMegapixelsPerSecond(Result) << ", \"gb_per_s\": " << GetGBPerSecond(Result) << "}";
+		Stream.flush();
+		break;
+	default:
+		{
+			std::string Size = std::to_string((long long)Result.ImageWidth) + "x" + std::to_string((long long)Result.ImageHeight);
+			double RelativeStdDev = (Statistics.MeanNs > 0.0) ? Statistics.StdDevNs / Statistics.MeanNs * 100.0 : 0.0;
+			Stream << std::left << std::setw(20) << Result.Implementation << std::right << std::setw(12) << Size
+				   << std::fixed << std::setprecision(0) << std::setw(14) << Statistics.MinNs << std::setw(14) << Statistics.MedianNs
+				   << std::setw(14) << Statistics.P95Ns << std::setprecision(1) << std::setw(10) << RelativeStdDev
+				   << std::setw(12) << GetMegapixelsPerSecond(Result) << std::setprecision(2) << std::setw(10) << GetGBPerSecond(Result)
+				   << std::endl;
+		}
+		break;
+	}
+	Stream.flags(Flags);
+	Stream.precision(Precision);
+	ResultCount++;
+}
+
+// version of the baseline file layout, a file with another version is ignored
+const int BENCHMARK_BASELINE_VERSION = 1;
+
+// GetBaselineKey
+
+static std::string GetBaselineKey(const BenchmarkResult &Result)
+{
+	return std::to_string((long long)Result.ImageWidth) + "x" + std::to_string((long long)Result.ImageHeight) + " " + Result.Implementation;
+}
+
+// BenchmarkBaseline::Load
+// the file starts with the machine and the version, followed by a line per implementation and image size:
+// <Mpixels/s> <width>x<height> <implementation name>
+
+bool BenchmarkBaseline::Load(const std::string &FileName)
+{
+	std::ifstream File(FileName.c_str());
+	if (!File)
+		return false;
+	std::string Line, Header;
+	const std::string ExpectedHeader = "machine " + Machine + "\nversion " + std::to_string((long long)BENCHMARK_BASELINE_VERSION) + "\n";
+	for (int i = 0; (i < 2) && std::getline(File, Line); i++)
+		Header += Line + "\n";
+	if (Header != ExpectedHeader)
+		return false;
+
+	std::map<std::string, double> LoadedEntries;
+	while (std::getline(File, Line))
+	{
+		std::istringstream Fields(Line);
+		double MegapixelsPerSecond = 0.0;
+		std::string Key;
+		if (!(Fields >> MegapixelsPerSecond) || (MegapixelsPerSecond <= 0.0) || !(Fields >> std::ws) || !std::getline(Fields, Key))
+			return false;
+		LoadedEntries[Key] = MegapixelsPerSecond;
+	}
+	Entries.swap(LoadedEntries);
+	return true;
+}
+
+bool BenchmarkBaseline::Save(const std::string &FileName) const
+{
+	std::ofstream File(FileName.c_str());
+	if (!File)
+		return false;
+	File << "machine " << Machine << "\nversion " << BENCHMARK_BASELINE_VERSION << "\n" << std::fixed << std::setprecision(3);
+	for (auto EntriesPtr = Entries.begin(); EntriesPtr != Entries.end(); EntriesPtr++)
+		File << EntriesPtr->second << " " << EntriesPtr->first << "\n";
+	return (bool)File;
+}
+
+void BenchmarkBaseline::Add(const BenchmarkResult &Result)
+{
+	Entries[GetBaselineKey(Result)] = ::GetMegapixelsPerSecond(Result);
+}
+
+double BenchmarkBaseline::GetMegapixelsPerSecond(const BenchmarkResult &Result) const
+{
+	auto EntriesPtr = Entries.find(GetBaselineKey(Result));
+	return (EntriesPtr != Entries.end()) ? EntriesPtr->second : 0.0;
+}
+
+std::vector<std::string> BenchmarkBaseline::GetMissingEntries(const std::vector<BenchmarkResult> &Results) const
+{
+	std::set<std::string> Sizes, Keys;
+	for (auto ResultsPtr = Results.begin(); ResultsPtr != Results.end(); ResultsPtr++)
+	{
+		Sizes.insert(std::to_string((long long)ResultsPtr->ImageWidth) + "x" + std::to_string((long long)ResultsPtr->ImageHeight));
+		Keys.insert(GetBaselineKey(*ResultsPtr));
+	}
+	std::vector<std::string> MissingEntries;
+	for (auto EntriesPtr = Entries.begin(); EntriesPtr != Entries.end(); EntriesPtr++)
+		if (Sizes.count(EntriesPtr->first.substr(0, EntriesPtr->first.find(' '))) && !Keys.count(EntriesPtr->first))
+			MissingEntries.push_back(EntriesPtr->first);
+	return MissingEntries;
+}
+
+void BenchmarkBaseline::RemoveEntry(const std::string &Entry)
+{
+	Entries.erase(Entry);
+}
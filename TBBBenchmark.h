@@ -8,8 +8,114 @@
 // -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
 // -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
 
-#include <string>
+
+#pragma once
+
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// BenchmarkTimer
+// measures the time elapsed since it was created or restarted on the monotonic steady_clock, every measurement owns
+// its timer so they can be nested and used from several threads
+class BenchmarkTimer {
+public:
+	BenchmarkTimer() : StartTime(std::chrono::steady_clock::now()) {}
+	void Restart() { StartTime = std::chrono::steady_clock::now(); }
+	double GetElapsedNs() const
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - StartTime).count();
+	}
+private:
+	std::chrono::steady_clock::time_point StartTime;
+};
+
+struct BenchmarkOptions {
+	int WarmupRuns;				//< runs discarded before measuring, they fault in the pages and warm up the caches
+	int Repetitions;			//< measured runs
+};
+
+// statistics of the measured runs, in nanoseconds per run
+struct BenchmarkStatistics {
+	int Repetitions;
+	double MinNs;
+	double MedianNs;
+	double P95Ns;				//< nearest-rank 95th percentile
+	double MeanNs;
+	double StdDevNs;			//< sample standard deviation
+};
+
+// runs Function WarmupRuns + Repetitions times and times each of the measured runs separately
+BenchmarkStatistics RunBenchmark(const std::function<void()> &Function, const BenchmarkOptions &Options);
+// statistics of a set of samples, expressed in nanoseconds
+BenchmarkStatistics ComputeBenchmarkStatistics(std::vector<double> SamplesNs);
+// nearest-rank percentile, between 0 and 100, of samples sorted in increasing order, 0 when there are no samples
+double GetPercentile(const std::vector<double> &SortedSamples, double Percentile);
+
+// FillRandomImage, CreateRandomImage
+// input images of the benchmarks and of the checks, filled with pseudo-random bytes that depend only on Seed, so
+// that every mode and every run converts the same data; they do not touch the state of rand(), so they can be
+// called from any thread
+void FillRandomImage(unsigned char *Image, size_t Size, unsigned int Seed = 0x5555);
+std::vector<unsigned char> CreateRandomImage(size_t Size, unsigned int Seed = 0x5555);
+
+struct BenchmarkResult {
+	std::string Implementation;
+	int ImageWidth;
+	int ImageHeight;
+	double BytesPerRun;			//< bytes read plus bytes written by one run
+	BenchmarkStatistics Statistics;
+};
+
+// throughput computed from the median time, which is less sensitive than the mean to the occasional preempted run
+double GetMegapixelsPerSecond(const BenchmarkResult &Result);
+double GetGBPerSecond(const BenchmarkResult &Result);
+
+enum BenchmarkFormat {
+	BENCHMARK_FORMAT_TABLE,		//< aligned columns for the console
+	BENCHMARK_FORMAT_CSV,
+	BENCHMARK_FORMAT_JSON
+};
+
+// BenchmarkReport
+// writes results as soon as they are added, so that long runs show their progress; the JSON array is closed when
+// the report is destroyed
+class BenchmarkReport {
+public:
+	BenchmarkReport(std::ostream &Stream, BenchmarkFormat Format);
+	~BenchmarkReport();
+	void Add(const BenchmarkResult &Result);
+private:
+	BenchmarkReport(const BenchmarkReport &);
+	BenchmarkReport &operator=(const BenchmarkReport &);
+
+	std::ostream &Stream;
+	BenchmarkFormat Format;
+	int ResultCount;
+};
+
+// BenchmarkBaseline
+// median throughputs of a previous run, keyed by implementation and image size, stored in a text file together with
+// a description of the machine they were measured on, as they can be compared only with runs on the same machine
+class BenchmarkBaseline {
+public:
+	explicit BenchmarkBaseline(const std::string &Machine) : Machine(Machine) {}
+
+	// returns false when the file is missing or invalid, or was recorded on another machine
+	bool Load(const std::string &FileName);
+	bool Save(const std::string &FileName) const;
+	void Add(const BenchmarkResult &Result);
+	// Mpixels/s recorded for the implementation and image size of Result, 0 when the baseline does not have them
+	double GetMegapixelsPerSecond(const BenchmarkResult &Result) const;
+	// entries for the image sizes of Results that none of them matches, e.g. kernels that were dropped or renamed,
+	// as "<width>x<height> <implementation>"
+	std::vector<std::string> GetMissingEntries(const std::vector<BenchmarkResult> &Results) const;
+	void RemoveEntry(const std::string &Entry);
 
-void StartBenchmark();
-void StopBenchmark(std::string Description);
+private:
+	std::string Machine;
+	std::map<std::string, double> Entries;		//< keyed by "<width>x<height> <implementation>"
+};
@@ -13,39 +13,206 @@
 
 #include "stdafx.h"
 
-#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <functional>
+#include <limits.h>
+#include <math.h>
+#include <map>
+#include <iomanip>
 #include <iostream>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 using namespace std;
 #include "TBBBenchmark.h"
+#include "TBBDemoAllocator.h"
+#include "TBBDemoAsync.h"
+#include "TBBDemoBackends.h"
+#include "TBBDemoBatch.h"
+#include "TBBDemoCounters.h"
+#include "TBBDemoCPU.h"
+#include "TBBDemoHighBitDepth.h"
+#include "TBBDemoIncremental.h"
+#include "TBBDemoMappedFile.h"
+#include "TBBDemoNUMA.h"
+#include "TBBDemoPipeline.h"
+#include "TBBDemoRealTime.h"
+#include "TBBDemoRoofline.h"
 #include "TBBDemoRoutines.h"
+#include "TBBDemoStatistics.h"
+#include "TBBDemoSweep.h"
+#include "TBBDemoTiling.h"
+#include "TBBDemoTuner.h"
+#include "TBBDemoVerify.h"
+#include "TBBDemoYUV.h"
 #include "TBBDemoAMP.h"
 
+// Intel TBB library
+#include <task_arena.h>
+#include <tick_count.h>
+using namespace tbb;
+
 typedef void (*TBBDemoFunction)(void *, void *, int, int, int);
-typedef std::pair<TBBDemoFunction, std::string> TBBDemoImplementation;
 
-int _tmain(int argc, _TCHAR* argv[])
+struct TBBDemoImplementation {
+	TBBDemoFunction Function;
+	std::string Name;
+	PixelFormat SourceFormat;	//< format of the pixels read, the benchmark passes the same RGBA image to every kernel
+	int SourcePixelSize;		//< bytes read for each pixel, used for the bandwidth
+	int MaxError;				//< largest difference from the serial results, 0 except for the reduced precision kernels
+	LumaCoefficients Coefficients;
+
+	TBBDemoImplementation(TBBDemoFunction Function, const std::string &Name, PixelFormat SourceFormat = PIXEL_FORMAT_RGBA32,
+						  int MaxError = 0, LumaCoefficients Coefficients = LUMA_BT601) :
+		Function(Function), Name(Name), SourceFormat(SourceFormat), SourcePixelSize(GetPixelSize(SourceFormat)), MaxError(MaxError),
+		Coefficients(Coefficients) {}
+};
+
+// RunConvertMode
+// TBBDemo --convert <input RGBA file> <output luma file> <width> <height> [--cached]
+// converts a single raw RGBA image mapped in memory straight into the mapped output file, without intermediate buffers
+// the luma plane is written with non-temporal stores unless --cached is given, so that it does not evict the source
+// pixels from the cache; the bandwidth is compared with a memcpy of the input image, the best a pass over it can do
+
+static int RunConvertMode(int argc, _TCHAR* argv[])
 {
-	const int DEFAULT_IMAGE_WIDTH = 8 * 1024;
-	const int DEFAULT_IMAGE_HEIGHT = 8 * 1024;
-	const int DEFAULT_IMAGE_SIZE = (DEFAULT_IMAGE_WIDTH * DEFAULT_IMAGE_HEIGHT);
 	const int RGBA_PIXEL_SIZE = 4;
 
-	cout << "Intel TBB Demo by Stefano Tommesani (www.tommesani.com)" << endl;
+	bool NonTemporal = true;
+	if ((argc == 7) && (_tcscmp(argv[6], _T("--cached")) == 0))
+	{
+		NonTemporal = false;
+		argc--;
+	}
+	if (argc != 6)
+	{
+		cout << "Usage: TBBDemo --convert <input RGBA file> <output luma file> <width> <height> [--cached]" << endl;
+		return 1;
+	}
+	int ImageWidth = _ttoi(argv[4]);
+	int ImageHeight = _ttoi(argv[5]);
+	if ((ImageWidth <= 0) || (ImageHeight <= 0))
+	{
+		cout << "Width and height must be positive" << endl;
+		return 1;
+	}
+	const size_t ImageSize = (size_t)ImageWidth * ImageHeight;
 
-	// create input image
-	unsigned char *RGBAImage = new unsigned char[DEFAULT_IMAGE_SIZE * RGBA_PIXEL_SIZE];
-	// fill RGBA image with random data
-	srand(0x5555);
-	for (int j = 0; j < (DEFAULT_IMAGE_SIZE * RGBA_PIXEL_SIZE); j++)
-		RGBAImage[j] = rand() % 256;
-	// create output image
-	unsigned char *GrayImage = new unsigned char[DEFAULT_IMAGE_SIZE];
+	MappedFile InputFile, OutputFile;
+	if (!OpenMappedFile(argv[2], InputFile))
+	{
+		cout << "Cannot map the input file" << endl;
+		return 1;
+	}
+	if (InputFile.Size < ImageSize * RGBA_PIXEL_SIZE)
+	{
+		cout << "The input file is smaller than a " << ImageWidth << "x" << ImageHeight << " RGBA image" << endl;
+		CloseMappedFile(InputFile);
+		return 1;
+	}
+	if (!CreateMappedFile(argv[3], ImageSize, OutputFile))
+	{
+		cout << "Cannot create the output file" << endl;
+		CloseMappedFile(InputFile);
+		return 1;
+	}
 
-	// checks for correctness have been moved to unit testing project
+	LumaFunction Kernel = GetLumaFunction(PIXEL_FORMAT_RGBA32, LUMA_BT601, false, LUMA_ISA_BEST, true, NonTemporal);
+	tick_count StartTime = tick_count::now();
+	Kernel(InputFile.Data, OutputFile.Data, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+	double ConvertSeconds = (tick_count::now() - StartTime).seconds();
 
-	// check performance
+	// the copy reads the same pages, now resident, into a buffer that is touched beforehand to leave page faults out
+	// both calls go through volatile pointers, otherwise the compiler removes them as the buffer is never read
+	void *(*volatile SetFunction)(void *, int, size_t) = &memset;
+	void *(*volatile CopyFunction)(void *, const void *, size_t) = &memcpy;
+	unsigned char *CopyImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+	SetFunction(CopyImage, 0, ImageSize * RGBA_PIXEL_SIZE);
+	StartTime = tick_count::now();
+	CopyFunction(CopyImage, InputFile.Data, ImageSize * RGBA_PIXEL_SIZE);
+	double CopySeconds = (tick_count::now() - StartTime).seconds();
+	delete[] CopyImage;
+
+	CloseMappedFile(OutputFile);
+	CloseMappedFile(InputFile);
+
+	double ConvertBandwidth = (double)ImageSize * (RGBA_PIXEL_SIZE + 1) / ConvertSeconds / 1e9;
+	double CopyBandwidth = (double)ImageSize * RGBA_PIXEL_SIZE * 2 / CopySeconds / 1e9;
+	cout << "Conversion (" << (NonTemporal ? "non-temporal" : "cached") << " stores): " << ConvertSeconds * 1000.0 << " ms, "
+		 << ConvertBandwidth << " GB/s" << endl;
+	cout << "memcpy of the input: " << CopySeconds * 1000.0 << " ms, " << CopyBandwidth << " GB/s" << endl;
+	cout << "Conversion reaches " << (ConvertBandwidth / CopyBandwidth) * 100.0 << "% of the memcpy bandwidth" << endl;
+	return 0;
+}
+
+// RunPipelineMode
+// TBBDemo --pipeline <input RGBA file> <output luma file> <width> <height> [<frames in flight>]
+// converts a sequence of raw RGBA frames stored back to back, the output file holds the luma planes in the same order
+
+static int RunPipelineMode(int argc, _TCHAR* argv[])
+{
+	const int DEFAULT_BUFFERS_IN_FLIGHT = 8;
+
+	if ((argc < 6) || (argc > 7))
+	{
+		cout << "Usage: TBBDemo --pipeline <input RGBA file> <output luma file> <width> <height> [<frames in flight>]" << endl;
+		return 1;
+	}
+	int ImageWidth = _ttoi(argv[4]);
+	int ImageHeight = _ttoi(argv[5]);
+	int BuffersInFlight = (argc == 7) ? _ttoi(argv[6]) : DEFAULT_BUFFERS_IN_FLIGHT;
+	if ((ImageWidth <= 0) || (ImageHeight <= 0) || (BuffersInFlight <= 0))
+	{
+		cout << "Width, height and frames in flight must be positive" << endl;
+		return 1;
+	}
+	FILE *InputFile = _tfopen(argv[2], _T("rb"));
+	if (InputFile == 0)
+	{
+		cout << "Cannot open the input file" << endl;
+		return 1;
+	}
+	FILE *OutputFile = _tfopen(argv[3], _T("wb"));
+	if (OutputFile == 0)
+	{
+		cout << "Cannot create the output file" << endl;
+		fclose(InputFile);
+		return 1;
+	}
+
+	PipelineStatistics Statistics;
+	bool Succeeded = RunConversionPipeline(InputFile, OutputFile, ImageWidth, ImageHeight, BuffersInFlight,
+										   &ProcessRGBTBBSIMDAuto, Statistics);
+	fclose(InputFile);
+	if (fclose(OutputFile) != 0)
+		Succeeded = false;
+	if (!Succeeded)
+	{
+		cout << "Conversion failed after " << Statistics.Frames << " frames" << endl;
+		return 1;
+	}
+	cout << Statistics.Frames << " frames of " << ImageWidth << "x" << ImageHeight << " in " << Statistics.Seconds << " s: "
+		 << Statistics.FramesPerSecond << " frames/s, " << Statistics.GBPerSecond << " GB/s" << endl;
+	return 0;
+}
+
+// PrintBanner
+
+static void PrintBanner()
+{
+	cout << "Intel TBB Demo by Stefano Tommesani (www.tommesani.com)" << endl;
+	cout << "Widest instruction set supported: " << GetCPUBestISAName() << endl;
+}
+
+// GetImplementations
+// the kernels supported by the CPU, in the order they are benchmarked
+
+static std::vector<TBBDemoImplementation> GetImplementations()
+{
 	std::vector<TBBDemoImplementation> Implementations;
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSerial, "Serial"));
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBTBB1, "TBB1"));
@@ -53,28 +220,1997 @@ int _tmain(int argc, _TCHAR* argv[])
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBTBB3, "TBB3"));
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMD, "SIMD1"));
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMD2, "SIMD2"));
-	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMD3, "SIMD3"));
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMD3, "SIMD3", PIXEL_FORMAT_RGBA32, TRUNCATED_SCALES_MAX_ERROR));
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBTBBSIMD, "TBB SIMD"));
+	const CPUFeatures &Features = GetCPUFeatures();
+	// the RGBA input image is large enough to be read as any of the other formats too
+	if (Features.SSSE3)
+	{
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGB24SSSE3, "RGB24 SSSE3", PIXEL_FORMAT_RGB24));
+		Implementations.push_back(TBBDemoImplementation(&ProcessBGR24SSSE3, "BGR24 SSSE3", PIXEL_FORMAT_BGR24));
+		Implementations.push_back(TBBDemoImplementation(&ProcessBGRA32SSSE3, "BGRA32 SSSE3", PIXEL_FORMAT_BGRA32));
+		Implementations.push_back(TBBDemoImplementation(&ProcessARGB32SSSE3, "ARGB32 SSSE3", PIXEL_FORMAT_ARGB32));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBSSSE3FastRounded, "SSSE3 Fast Rounded", PIXEL_FORMAT_RGBA32, ROUNDED_SCALES_MAX_ERROR));
+	}
+	if (Features.AVX2)
+	{
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBAVX2, "AVX2"));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBAVX2Fast, "AVX2 Fast", PIXEL_FORMAT_RGBA32, TRUNCATED_SCALES_MAX_ERROR));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBAVX2FastRounded, "AVX2 Fast Rounded", PIXEL_FORMAT_RGBA32, ROUNDED_SCALES_MAX_ERROR));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBTBBAVX2, "TBB AVX2"));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGB24AVX2, "RGB24 AVX2", PIXEL_FORMAT_RGB24));
+		Implementations.push_back(TBBDemoImplementation(&ProcessBGR24AVX2, "BGR24 AVX2", PIXEL_FORMAT_BGR24));
+		Implementations.push_back(TBBDemoImplementation(&ProcessBGRA32AVX2, "BGRA32 AVX2", PIXEL_FORMAT_BGRA32));
+		Implementations.push_back(TBBDemoImplementation(&ProcessARGB32AVX2, "ARGB32 AVX2", PIXEL_FORMAT_ARGB32));
+	}
+	if (Features.AVX512BW)
+	{
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBAVX512, "AVX-512"));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBAVX512Fast, "AVX-512 Fast", PIXEL_FORMAT_RGBA32, TRUNCATED_SCALES_MAX_ERROR));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBAVX512FastRounded, "AVX-512 Fast Rounded", PIXEL_FORMAT_RGBA32, ROUNDED_SCALES_MAX_ERROR));
+		Implementations.push_back(TBBDemoImplementation(&ProcessRGBTBBAVX512, "TBB AVX-512"));
+	}
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMDAuto, "SIMD Auto"));
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMDFastAuto, "SIMD Fast Auto", PIXEL_FORMAT_RGBA32, TRUNCATED_SCALES_MAX_ERROR));
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBSIMDFastRoundedAuto, "SIMD Fast Rounded Auto", PIXEL_FORMAT_RGBA32, ROUNDED_SCALES_MAX_ERROR));
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBTBBSIMDAuto, "TBB SIMD Auto"));
+	Implementations.push_back(TBBDemoImplementation(GetLumaFunction(PIXEL_FORMAT_RGBA32, LUMA_BT709, false, LUMA_ISA_BEST, true), "TBB SIMD BT.709",
+		PIXEL_FORMAT_RGBA32, 0, LUMA_BT709));
+	Implementations.push_back(TBBDemoImplementation(GetLumaFunction(PIXEL_FORMAT_RGBA32, LUMA_BT2020, false, LUMA_ISA_BEST, true), "TBB SIMD BT.2020",
+		PIXEL_FORMAT_RGBA32, 0, LUMA_BT2020));
+	Implementations.push_back(TBBDemoImplementation(GetLumaFunction(PIXEL_FORMAT_RGBA32, LUMA_BT601, true, LUMA_ISA_BEST, true), "TBB SIMD Fast Rounded",
+		PIXEL_FORMAT_RGBA32, ROUNDED_SCALES_MAX_ERROR));
+#if defined(HAS_OPENMP_BACKEND)
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBOpenMPSIMDAuto, "OpenMP SIMD Auto"));
+#endif
+#if defined(HAS_PARALLEL_STL_BACKEND)
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBParallelSTLSIMDAuto, "par_unseq SIMD Auto"));
+#endif
+	Implementations.push_back(TBBDemoImplementation(&ProcessRGBThreadPoolSIMDAuto, "Pool SIMD Auto"));
+#if defined(HAS_CPP_AMP)
 	Implementations.push_back(TBBDemoImplementation(&ProcessRGBAMP, "AMP GPGPU"));
+#endif
+	return Implementations;
+}
+
+// settings of the benchmark and sweep modes
+struct BenchmarkSettings {
+	BenchmarkOptions Options;
+	std::vector<std::string> ImplementationFilters;		//< an implementation runs if its name contains any of them
+	std::vector<std::pair<int, int> > ImageSizes;
+	BenchmarkFormat Format;
+	// sweep mode only
+	std::vector<int> ThreadCounts;
+	std::vector<int> GrainSizes;
+	std::vector<SweepPartitioner> Partitioners;
+};
+
+// ToString
+// command line arguments are ASCII, so they are narrowed character by character also when _TCHAR is wchar_t
+
+static std::string ToString(const _TCHAR *Argument)
+{
+	std::string Text;
+	for (; *Argument; Argument++)
+		Text += (char)*Argument;
+	return Text;
+}
+
+// ToLower
+
+static std::string ToLower(const _TCHAR *Argument)
+{
+	std::string Text;
+	for (; *Argument; Argument++)
+		Text += (char)tolower((int)*Argument);
+	return Text;
+}
+
+static std::string ToLower(const std::string &Text)
+{
+	std::string LowerText;
+	for (size_t i = 0; i < Text.length(); i++)
+		LowerText += (char)tolower((unsigned char)Text[i]);
+	return LowerText;
+}
+
+// SplitList
+// splits a comma separated list, empty items are skipped
+
+static std::vector<std::string> SplitList(const std::string &List)
+{
+	std::vector<std::string> Items;
+	size_t Start = 0;
+	while (Start <= List.length())
+	{
+		size_t Stop = List.find(',', Start);
+		if (Stop == std::string::npos)
+			Stop = List.length();
+		if (Stop > Start)
+			Items.push_back(List.substr(Start, Stop - Start));
+		Start = Stop + 1;
+	}
+	return Items;
+}
+
+// ParseIntegerList
+// parses a comma separated list of positive integers
+
+static bool ParseIntegerList(const std::string &List, std::vector<int> &Values)
+{
+	std::vector<std::string> Items = SplitList(List);
+	Values.clear();
+	for (size_t i = 0; i < Items.size(); i++)
+	{
+		int Value = atoi(Items[i].c_str());
+		if (Value <= 0)
+			return false;
+		Values.push_back(Value);
+	}
+	return !Values.empty();
+}
+
+// ParseBenchmarkSettings
+// TBBDemo [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...]
+//         [--format table|csv|json]
+// the sweep mode also accepts [--threads <count>,...] [--grains <pixels>,...] [--partitioners simple|auto|static|affinity,...]
+// and does not support JSON
+// without --sizes the image sizes are DefaultImageSizes, or a single 8192x8192 image when it is NULL
+// returns false on unknown options or invalid values
+
+static bool ParseBenchmarkSettings(int argc, _TCHAR* argv[], bool Sweep, BenchmarkSettings &Settings,
+								   const std::vector<std::pair<int, int> > *DefaultImageSizes = NULL)
+{
+	const int DEFAULT_IMAGE_WIDTH = 8 * 1024;
+	const int DEFAULT_IMAGE_HEIGHT = 8 * 1024;
+
+	Settings.Options.WarmupRuns = 2;
+	Settings.Options.Repetitions = 10;
+	Settings.ImplementationFilters.clear();
+	Settings.ImageSizes.clear();
+	Settings.Format = BENCHMARK_FORMAT_TABLE;
+	Settings.ThreadCounts = GetDefaultSweepThreadCounts();
+	Settings.GrainSizes.clear();
+	for (int GrainSize = 1024; GrainSize <= 256 * 1024; GrainSize *= 4)
+		Settings.GrainSizes.push_back(GrainSize);
+	Settings.Partitioners.clear();
+	Settings.Partitioners.push_back(SWEEP_PARTITIONER_SIMPLE);
+	Settings.Partitioners.push_back(SWEEP_PARTITIONER_AUTO);
+	Settings.Partitioners.push_back(SWEEP_PARTITIONER_STATIC);
+	Settings.Partitioners.push_back(SWEEP_PARTITIONER_AFFINITY);
+	for (int i = 1; i < argc; i += 2)
+	{
+		if (i + 1 >= argc)
+			return false;
+		std::string Option = ToLower(argv[i]);
+		std::string Value = ToLower(argv[i + 1]);
+		if (Option == "--warmup")
+		{
+			Settings.Options.WarmupRuns = atoi(Value.c_str());
+			if (Settings.Options.WarmupRuns < 0)
+				return false;
+		}
+		else if (Option == "--repetitions")
+		{
+			Settings.Options.Repetitions = atoi(Value.c_str());
+			if (Settings.Options.Repetitions <= 0)
+				return false;
+		}
+		else if (Option == "--implementations")
+			Settings.ImplementationFilters = SplitList(Value);
+		else if (Option == "--sizes")
+		{
+			std::vector<std::string> Sizes = SplitList(Value);
+			for (size_t j = 0; j < Sizes.size(); j++)
+			{
+				int ImageWidth = 0, ImageHeight = 0;
+				if ((sscanf(Sizes[j].c_str(), "%dx%d", &ImageWidth, &ImageHeight) != 2) || (ImageWidth <= 0) || (ImageHeight <= 0) ||
+					((long long)ImageWidth * ImageHeight * 4 > INT_MAX))
+					return false;
+				Settings.ImageSizes.push_back(std::make_pair(ImageWidth, ImageHeight));
+			}
+		}
+		else if (Option == "--format")
+		{
+			if (Value == "table")
+				Settings.Format = BENCHMARK_FORMAT_TABLE;
+			else if (Value == "csv")
+				Settings.Format = BENCHMARK_FORMAT_CSV;
+			else if (Value == "json")
+				Settings.Format = BENCHMARK_FORMAT_JSON;
+			else
+				return false;
+		}
+		else if (Sweep && (Option == "--threads"))
+		{
+			if (!ParseIntegerList(Value, Settings.ThreadCounts))
+				return false;
+		}
+		else if (Sweep && (Option == "--grains"))
+		{
+			if (!ParseIntegerList(Value, Settings.GrainSizes))
+				return false;
+		}
+		else if (Sweep && (Option == "--partitioners"))
+		{
+			std::vector<std::string> Names = SplitList(Value);
+			Settings.Partitioners.clear();
+			for (size_t j = 0; j < Names.size(); j++)
+			{
+				int Partitioner = SWEEP_PARTITIONER_SIMPLE;
+				while ((Partitioner <= SWEEP_PARTITIONER_AFFINITY) && (Names[j] != GetPartitionerName((SweepPartitioner)Partitioner)))
+					Partitioner++;
+				if (Partitioner > SWEEP_PARTITIONER_AFFINITY)
+					return false;
+				Settings.Partitioners.push_back((SweepPartitioner)Partitioner);
+			}
+			if (Settings.Partitioners.empty())
+				return false;
+		}
+		else
+			return false;
+	}
+	if (Sweep && (Settings.Format == BENCHMARK_FORMAT_JSON))
+		return false;
+	if (Settings.ImageSizes.empty() && DefaultImageSizes)
+		Settings.ImageSizes = *DefaultImageSizes;
+	if (Settings.ImageSizes.empty())
+		Settings.ImageSizes.push_back(std::make_pair(DEFAULT_IMAGE_WIDTH, DEFAULT_IMAGE_HEIGHT));
+	return true;
+}
+
+// IsImplementationSelected
+// names are matched case-insensitively, so that "avx2" selects every AVX2 kernel and "tbb simd auto" just one
+
+static bool IsImplementationSelected(const std::string &Name, const std::vector<std::string> &Filters)
+{
+	if (Filters.empty())
+		return true;
+	std::string LowerName = ToLower(Name);
+	for (size_t i = 0; i < Filters.size(); i++)
+		if (LowerName.find(Filters[i]) != std::string::npos)
+			return true;
+	return false;
+}
+
+// BenchmarkImplementations
+// times every selected implementation on every image size and passes each result to Consumer, together with a
+// function that runs the implementation once more on the same images
+
+typedef std::function<void(const BenchmarkResult &Result, const std::function<void()> &Run)> BenchmarkConsumer;
+
+static void BenchmarkImplementations(const BenchmarkSettings &Settings, const BenchmarkConsumer &Consumer)
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	std::vector<TBBDemoImplementation> AllImplementations = GetImplementations();
+	std::vector<TBBDemoImplementation> Implementations;
+	for (auto ImplementationsPtr = AllImplementations.begin(); ImplementationsPtr != AllImplementations.end(); ImplementationsPtr++)
+		if (IsImplementationSelected(ImplementationsPtr->Name, Settings.ImplementationFilters))
+			Implementations.push_back(*ImplementationsPtr);
+
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+
+		// create input image
+		unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+		FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+		// create output image
+		unsigned char *GrayImage = new unsigned char[ImageSize];
+
+		for (auto ImplementationsPtr = Implementations.begin(); ImplementationsPtr != Implementations.end(); ImplementationsPtr++)
+		{
+			TBBDemoFunction Function = ImplementationsPtr->Function;
+			BenchmarkResult Result;
+			Result.Implementation = ImplementationsPtr->Name;
+			Result.ImageWidth = ImageWidth;
+			Result.ImageHeight = ImageHeight;
+			Result.BytesPerRun = (double)ImageSize * (ImplementationsPtr->SourcePixelSize + 1);
+			const std::function<void()> Run = [=]() {
+				Function(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+			};
+			Result.Statistics = RunBenchmark(Run, Settings.Options);
+			Consumer(Result, Run);
+		}
 
-	const int PERFORMANCE_LOOPS = 5;  //< multiple loops to minimize benchmarking errors
-	for (int i = 1; i <= PERFORMANCE_LOOPS; i++)
+		// free images
+		delete[] RGBAImage;
+		delete[] GrayImage;
+	}
+}
+
+// RunBenchmarkMode
+// times every selected implementation on every image size, the table format is meant for the console and CSV
+// and JSON for tracking results over time, so the banner is printed only with the former
+
+static int RunBenchmarkMode(int argc, _TCHAR* argv[])
+{
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc, argv, false, Settings))
+	{
+		cout << "Usage: TBBDemo [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "               [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		cout << "       TBBDemo --sweep [--threads <count>,...] [--grains <pixels>,...] [--partitioners <name>,...]" << endl;
+		cout << "               [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "               [--sizes <width>x<height>,...] [--format table|csv]" << endl;
+		cout << "       TBBDemo --pipeline <input RGBA file> <output luma file> <width> <height> [<frames in flight>]" << endl;
+		cout << "       TBBDemo --convert <input RGBA file> <output luma file> <width> <height> [--cached]" << endl;
+		cout << "       TBBDemo --numa [<options>]" << endl;
+		cout << "       TBBDemo --allocation [<options>]" << endl;
+		cout << "       TBBDemo --statistics [<options>]" << endl;
+		cout << "       TBBDemo --yuv [<options>]" << endl;
+		cout << "       TBBDemo --highbitdepth [<options>]" << endl;
+		cout << "       TBBDemo --batch [<options>]" << endl;
+		cout << "       TBBDemo --async [<options>]" << endl;
+		cout << "       TBBDemo --tiling [<options>]" << endl;
+		cout << "       TBBDemo --incremental [<options>]" << endl;
+		cout << "       TBBDemo --tune [--retune] [<options>]" << endl;
+		cout << "       TBBDemo --verify [--cases <count>] [--seed <value>] [--implementations <name>,...]" << endl;
+		cout << "       TBBDemo --exhaustive [--implementations <name>,...]" << endl;
+		cout << "       TBBDemo --regression <baseline file> [--update] [--allow-missing] [--margin <percent>] [<options>]" << endl;
+		cout << "       TBBDemo --roofline [<options>]" << endl;
+		cout << "       TBBDemo --realtime [--fps <frames/s>] [--frames <count>] [--ring <frames>] [--concurrency <frames>]" << endl;
+		cout << "               [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		cout << "<options> are the ones of the first form" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	BenchmarkReport Report(cout, Settings.Format);
+	BenchmarkImplementations(Settings, [&](const BenchmarkResult &Result, const std::function<void()> &) { Report.Add(Result); });
+	return 0;
+}
+
+// RunSweepMode
+// TBBDemo --sweep [<options>], see ParseBenchmarkSettings
+// every thread count is run in its own task_arena, results are printed once an implementation has been swept
+// on an image size, as the speedups need the run with 1 thread
+
+static int RunSweepMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	// skip --sweep, so that the options start at argv[1] as in the benchmark mode
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, true, Settings))
 	{
-		cout << "---- Iteration " << i << " ---- " << endl;
+		cout << "Usage: TBBDemo --sweep [--threads <count>,...] [--grains <pixels>,...] [--partitioners simple|auto|static|affinity,...]" << endl;
+		cout << "               [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "               [--sizes <width>x<height>,...] [--format table|csv]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	SweepSettings Sweep;
+	Sweep.ThreadCounts = Settings.ThreadCounts;
+	Sweep.GrainSizes = Settings.GrainSizes;
+	Sweep.Partitioners = Settings.Partitioners;
+	Sweep.Options = Settings.Options;
+	std::vector<SweepImplementation> Implementations = GetSweepImplementations();
+
+	std::vector<SweepResult> AllResults;
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+
+		unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+		FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+		unsigned char *GrayImage = new unsigned char[ImageSize];
+
 		for (auto ImplementationsPtr = Implementations.begin(); ImplementationsPtr != Implementations.end(); ImplementationsPtr++)
 		{
-			StartBenchmark();
-			ImplementationsPtr->first(RGBAImage, GrayImage, DEFAULT_IMAGE_WIDTH, DEFAULT_IMAGE_HEIGHT, RGBA_PIXEL_SIZE);
-			StopBenchmark(ImplementationsPtr->second);
+			if (!IsImplementationSelected(ImplementationsPtr->Name, Settings.ImplementationFilters))
+				continue;
+			std::vector<SweepResult> Results = RunScalingSweep(*ImplementationsPtr, Sweep, RGBAImage, GrayImage, ImageWidth, ImageHeight);
+			if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+				WriteSweepTables(cout, Results);
+			AllResults.insert(AllResults.end(), Results.begin(), Results.end());
+		}
+
+		delete[] RGBAImage;
+		delete[] GrayImage;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_CSV)
+		WriteSweepCSV(cout, AllResults);
+	return 0;
+}
+
+// RunNUMAMode
+// TBBDemo --numa [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]
+// compares the benchmark setup, an image filled by a single thread and converted by ProcessRGBTBBSIMDAuto in the
+// default arena, with slices placed and converted by the arena of each NUMA node
+
+static int RunNUMAMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings))
+	{
+		cout << "Usage: TBBDemo --numa [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+	{
+		NUMAConverter Topology(1, 1);
+		const std::vector<NUMASlice> &Slices = Topology.GetSlices();
+		for (size_t i = 0; i < Slices.size(); i++)
+			cout << "NUMA node " << Slices[i].NodeId << ": " << Slices[i].Threads << " threads" << endl;
+	}
+
+	LumaFunction SliceKernel = GetLumaFunction(PIXEL_FORMAT_RGBA32, LUMA_BT601, false, LUMA_ISA_BEST, false);
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+		BenchmarkResult Result;
+		Result.ImageWidth = ImageWidth;
+		Result.ImageHeight = ImageHeight;
+		Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+
+		// single arena, pages first touched by the thread that fills the image
+		{
+			unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+			FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+			unsigned char *GrayImage = new unsigned char[ImageSize];
+			Result.Implementation = "Single arena";
+			Result.Statistics = RunBenchmark([=]() {
+					ProcessRGBTBBSIMDAuto(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+				}, Settings.Options);
+			Report.Add(Result);
+			delete[] RGBAImage;
+			delete[] GrayImage;
+		}
+
+		// one arena per node, each slice first touched and converted by the threads of its node
+		{
+			NUMAConverter Converter(ImageWidth, ImageHeight);
+			unsigned char *RGBAImage = NUMAConverter::AllocateImage(ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+			unsigned char *GrayImage = NUMAConverter::AllocateImage(ImageWidth, ImageHeight, 1);
+			Converter.FillImages(RGBAImage, GrayImage);
+			Result.Implementation = "Per-node arenas";
+			Result.Statistics = RunBenchmark([&]() {
+					Converter.Convert(SliceKernel, RGBAImage, GrayImage);
+				}, Settings.Options);
+			Report.Add(Result);
+			NUMAConverter::FreeImage(RGBAImage);
+			NUMAConverter::FreeImage(GrayImage);
+		}
+	}
+	return 0;
+}
+
+// allocation strategy compared by the allocation mode
+struct AllocationStrategy {
+	std::string Name;
+	std::function<unsigned char *(size_t)> Allocate;
+	std::function<void (unsigned char *, size_t)> Free;
+};
+
+// RunAllocationMode
+// TBBDemo --allocation [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]
+// each run allocates the RGBA and luma images, copies a frame in the former, converts it with ProcessRGBTBBSIMDAuto
+// and frees both; the first run of each strategy is reported on its own, as it is the one that pays for the page
+// faults when buffers are pooled
+
+static int RunAllocationMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings))
+	{
+		cout << "Usage: TBBDemo --allocation [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	ImageBufferPool Pool(IMAGE_MEMORY_HUGE_PAGES);
+	std::vector<AllocationStrategy> Strategies(4);
+	Strategies[0].Name = "new[]";
+	Strategies[0].Allocate = [](size_t Size) { return new unsigned char[Size]; };
+	Strategies[0].Free = [](unsigned char *Buffer, size_t) { delete[] Buffer; };
+	Strategies[1].Name = "Aligned";
+	Strategies[1].Allocate = [](size_t Size) { return (unsigned char *)AllocateImageMemory(Size, IMAGE_MEMORY_ALIGNED); };
+	Strategies[1].Free = [](unsigned char *Buffer, size_t Size) { FreeImageMemory(Buffer, Size, IMAGE_MEMORY_ALIGNED); };
+	Strategies[2].Name = "Huge pages";
+	Strategies[2].Allocate = [](size_t Size) { return (unsigned char *)AllocateImageMemory(Size, IMAGE_MEMORY_HUGE_PAGES); };
+	Strategies[2].Free = [](unsigned char *Buffer, size_t Size) { FreeImageMemory(Buffer, Size, IMAGE_MEMORY_HUGE_PAGES); };
+	Strategies[3].Name = "Pool";
+	Strategies[3].Allocate = [&Pool](size_t Size) { return Pool.Acquire(Size); };
+	Strategies[3].Free = [&Pool](unsigned char *Buffer, size_t) { Pool.Release(Buffer); };
+
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const size_t ImageSize = (size_t)ImageWidth * ImageHeight;
+
+		// the frame copied in the input image at each run, as if it had been read from a file or a camera
+		const std::vector<unsigned char> Frame = CreateRandomImage(ImageSize * RGBA_PIXEL_SIZE);
+
+		for (auto StrategiesPtr = Strategies.begin(); StrategiesPtr != Strategies.end(); StrategiesPtr++)
+		{
+			const AllocationStrategy &Strategy = *StrategiesPtr;
+			auto Run = [&]() {
+				unsigned char *RGBAImage = Strategy.Allocate(ImageSize * RGBA_PIXEL_SIZE);
+				unsigned char *GrayImage = Strategy.Allocate(ImageSize);
+				memcpy(RGBAImage, &Frame[0], ImageSize * RGBA_PIXEL_SIZE);
+				ProcessRGBTBBSIMDAuto(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+				Strategy.Free(GrayImage, ImageSize);
+				Strategy.Free(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+			};
+
+			BenchmarkResult Result;
+			Result.ImageWidth = ImageWidth;
+			Result.ImageHeight = ImageHeight;
+			Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+			BenchmarkTimer Timer;
+			Run();
+			Result.Implementation = Strategy.Name + " first";
+			Result.Statistics = ComputeBenchmarkStatistics(std::vector<double>(1, Timer.GetElapsedNs()));
+			Report.Add(Result);
+			Result.Implementation = Strategy.Name + " steady";
+			Result.Statistics = RunBenchmark(Run, Settings.Options);
+			Report.Add(Result);
+		}
+		Pool.Trim();
+	}
+	return 0;
+}
+
+// RunStatisticsMode
+// TBBDemo --statistics [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]
+// compares the conversion followed by a second pass that computes the luma statistics with the fused conversion,
+// after checking that the latter matches the serial two-pass reference on RGB24 and RGBA32 pixels; the bandwidth of
+// each row is computed from the memory traffic of its approach, 6 bytes per pixel for two passes and 5 for the fused one
+
+static int RunStatisticsMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings))
+	{
+		cout << "Usage: TBBDemo --statistics [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	int ExitCode = 0;
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+
+		unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+		FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+		unsigned char *GrayImage = new unsigned char[ImageSize];
+
+		// the RGBA image is large enough to be read as an RGB24 one too
+		for (int PixelOffset = 3; PixelOffset <= RGBA_PIXEL_SIZE; PixelOffset++)
+		{
+			LumaStatistics ReferenceStatistics, FusedStatistics;
+			ProcessRGBSerial(RGBAImage, GrayImage, ImageWidth, ImageHeight, PixelOffset);
+			ComputeLumaStatistics(GrayImage, ImageSize, ReferenceStatistics);
+			ProcessRGBTBBSIMDStatistics(RGBAImage, GrayImage, ImageWidth, ImageHeight, PixelOffset, FusedStatistics);
+			if (!AreLumaStatisticsEqual(ReferenceStatistics, FusedStatistics))
+			{
+				cerr << "Fused statistics of " << ImageWidth << "x" << ImageHeight << " with " << PixelOffset
+					 << " bytes per pixel do not match the serial two-pass reference" << endl;
+				ExitCode = 1;
+			}
+		}
+
+		BenchmarkResult Result;
+		Result.ImageWidth = ImageWidth;
+		Result.ImageHeight = ImageHeight;
+		Result.Implementation = "Two passes";
+		Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 2);
+		Result.Statistics = RunBenchmark([=]() {
+				LumaStatistics Statistics;
+				ProcessRGBTBBSIMDAuto(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+				ComputeLumaStatisticsTBB(GrayImage, ImageSize, Statistics);
+			}, Settings.Options);
+		Report.Add(Result);
+		Result.Implementation = "Fused";
+		Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+		Result.Statistics = RunBenchmark([=]() {
+				LumaStatistics Statistics;
+				ProcessRGBTBBSIMDStatistics(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE, Statistics);
+			}, Settings.Options);
+		Report.Add(Result);
+
+		delete[] RGBAImage;
+		delete[] GrayImage;
+	}
+	return ExitCode;
+}
+
+// RunYUVMode
+// TBBDemo --yuv [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...] [--format table|csv|json]
+// checks the multi-threaded 4:2:0 conversion against the scalar reference for every source layout, output format,
+// matrix and range, on each image size and on an odd sized one, then times both for RGBA and RGB sources with the
+// BT.601 limited range matrix, since the matrix does not change the amount of work
+
+static int RunYUVMode(int argc, _TCHAR* argv[])
+{
+	const PixelFormat SourceFormats[] = { PIXEL_FORMAT_RGBA32, PIXEL_FORMAT_RGB24, PIXEL_FORMAT_BGRA32, PIXEL_FORMAT_BGR24, PIXEL_FORMAT_ARGB32 };
+	const YUVFormat OutputFormats[] = { YUV_FORMAT_I420, YUV_FORMAT_NV12 };
+
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings))
+	{
+		cout << "Usage: TBBDemo --yuv [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                     [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	std::vector<std::pair<int, int> > CheckSizes = Settings.ImageSizes;
+	CheckSizes.push_back(std::make_pair(333, 77));
+	int ExitCode = 0;
+	for (auto SizesPtr = CheckSizes.begin(); SizesPtr != CheckSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		unsigned char *RGBImage = new unsigned char[ImageWidth * ImageHeight * 4];
+		FillRandomImage(RGBImage, ImageWidth * ImageHeight * 4);
+		std::vector<unsigned char> ReferenceImage(GetYUV420Size(ImageWidth, ImageHeight));
+		std::vector<unsigned char> YUVBuffer(ReferenceImage.size());
+
+		for (int i = 0; i < (int)(sizeof(SourceFormats) / sizeof(SourceFormats[0])); i++)
+			for (int j = 0; j < (int)(sizeof(OutputFormats) / sizeof(OutputFormats[0])); j++)
+				for (int Matrix = YUV_MATRIX_BT601; Matrix <= YUV_MATRIX_BT709; Matrix++)
+					for (int Range = YUV_RANGE_FULL; Range <= YUV_RANGE_LIMITED; Range++)
+					{
+						ImageDescriptor Source = MakeImageDescriptor(RGBImage, ImageWidth, ImageHeight, SourceFormats[i]);
+						const bool Converted =
+							ConvertToYUV420Reference(Source, MakeYUVImage(&ReferenceImage[0], ImageWidth, ImageHeight, OutputFormats[j]),
+													 (YUVMatrix)Matrix, (YUVRange)Range) &&
+							ConvertToYUV420(Source, MakeYUVImage(&YUVBuffer[0], ImageWidth, ImageHeight, OutputFormats[j]),
+											(YUVMatrix)Matrix, (YUVRange)Range);
+						if (!Converted || (YUVBuffer != ReferenceImage))
+						{
+							cerr << GetYUVFormatName(OutputFormats[j]) << " " << GetYUVMatrixName((YUVMatrix)Matrix) << " "
+								 << GetYUVRangeName((YUVRange)Range) << " conversion of " << ImageWidth << "x" << ImageHeight
+								 << " pixels of " << GetPixelSize(SourceFormats[i]) << " bytes does not match the scalar reference" << endl;
+							ExitCode = 1;
+						}
+					}
+		delete[] RGBImage;
+	}
+
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+		unsigned char *RGBImage = new unsigned char[ImageSize * 4];
+		FillRandomImage(RGBImage, ImageSize * 4);
+		unsigned char *YUVBuffer = new unsigned char[GetYUV420Size(ImageWidth, ImageHeight)];
+
+		for (int i = 0; i < 2; i++)
+			for (int j = 0; j < (int)(sizeof(OutputFormats) / sizeof(OutputFormats[0])); j++)
+				for (int Parallel = 0; Parallel < 2; Parallel++)
+				{
+					const ImageDescriptor Source = MakeImageDescriptor(RGBImage, ImageWidth, ImageHeight, SourceFormats[i]);
+					const YUVImage Destination = MakeYUVImage(YUVBuffer, ImageWidth, ImageHeight, OutputFormats[j]);
+					BenchmarkResult Result;
+					Result.Implementation = std::string((i == 0) ? "RGBA " : "RGB ") + GetYUVFormatName(OutputFormats[j]) +
+						(Parallel ? " TBB" : " Reference");
+					if (!IsImplementationSelected(Result.Implementation, Settings.ImplementationFilters))
+						continue;
+					Result.ImageWidth = ImageWidth;
+					Result.ImageHeight = ImageHeight;
+					Result.BytesPerRun = (double)ImageSize * GetPixelSize(SourceFormats[i]) + (double)GetYUV420Size(ImageWidth, ImageHeight);
+					if (Parallel)
+						Result.Statistics = RunBenchmark([=]() { ConvertToYUV420(Source, Destination, YUV_MATRIX_BT601, YUV_RANGE_LIMITED); }, Settings.Options);
+					else
+						Result.Statistics = RunBenchmark([=]() { ConvertToYUV420Reference(Source, Destination, YUV_MATRIX_BT601, YUV_RANGE_LIMITED); }, Settings.Options);
+					Report.Add(Result);
+				}
+
+		delete[] RGBImage;
+		delete[] YUVBuffer;
+	}
+	return ExitCode;
+}
+
+// sources of the high bit depth mode, BitDepth is ignored for RGBA64F
+
+struct HighBitDepthSource {
+	const char *Name;
+	PixelFormat Format;
+	int BitDepth;
+};
+
+// FillHighBitDepthImage
+// random channels in the range of the bit depth, half floats mostly between -0.15 and 1.15 with a special value
+// every 61 channels, so that each one lands on every channel of a pixel
+// each channel takes two bytes of a random 8-bit image
+
+static void FillHighBitDepthImage(std::vector<unsigned short> &Image, const HighBitDepthSource &Source)
+{
+	const float SpecialValues[] = { 0.0f, -0.0f, 1.0f, 65504.0f, -65504.0f, 1e-7f, -1e-7f, HUGE_VALF, -HUGE_VALF, NAN };
+	const std::vector<unsigned char> RandomBytes = CreateRandomImage(Image.size() * 2);
+	for (size_t i = 0; i < Image.size(); i++)
+	{
+		const int RandomValue = (RandomBytes[2 * i + 1] << 8) | RandomBytes[2 * i];
+		if (Source.Format == PIXEL_FORMAT_RGBA64)
+			Image[i] = (unsigned short)(RandomValue & ((1 << Source.BitDepth) - 1));
+		else if ((i % 61) == 0)
+			Image[i] = FloatToHalf(SpecialValues[(i / 61) % (sizeof(SpecialValues) / sizeof(SpecialValues[0]))]);
+		else
+			Image[i] = FloatToHalf((RandomValue % 13001) / 10000.0f - 0.15f);
+	}
+}
+
+// RunHighBitDepthMode
+// TBBDemo --highbitdepth [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...] [--format table|csv|json]
+// checks the software half precision conversions on all the 65536 halves, then compares the scalar and AVX2
+// kernels, serial and multi-threaded, with the double precision reference for 10, 12 and 16-bit and half float
+// sources, both outputs and every coefficient set, on each image size and on an odd sized one; the largest error
+// and the share of pixels that differ from the reference are printed for each source and output
+// the half float images include values outside 0.0..1.0, subnormals, infinities and NaN
+// then times the kernels with BT.601 coefficients
+
+static int RunHighBitDepthMode(int argc, _TCHAR* argv[])
+{
+	const HighBitDepthSource Sources[] = {
+		{ "RGBA64 10-bit", PIXEL_FORMAT_RGBA64, 10 },
+		{ "RGBA64 12-bit", PIXEL_FORMAT_RGBA64, 12 },
+		{ "RGBA64 16-bit", PIXEL_FORMAT_RGBA64, 16 },
+		{ "RGBA64F", PIXEL_FORMAT_RGBA64F, 16 }
+	};
+	const int SourceCount = (int)(sizeof(Sources) / sizeof(Sources[0]));
+	const PixelFormat OutputFormats[] = { PIXEL_FORMAT_Y8, PIXEL_FORMAT_Y16 };
+
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings))
+	{
+		cout << "Usage: TBBDemo --highbitdepth [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                              [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	int ExitCode = 0;
+	for (int i = 0; i < 0x10000; i++)
+	{
+		const float Value = HalfToFloat((unsigned short)i);
+		if ((Value == Value) && (FloatToHalf(Value) != i))
+		{
+			cerr << "half precision value 0x" << hex << i << dec << " does not survive the conversion to float and back" << endl;
+			ExitCode = 1;
+			break;
+		}
+	}
+
+	std::vector<std::pair<int, int> > CheckSizes = Settings.ImageSizes;
+	CheckSizes.push_back(std::make_pair(333, 77));
+	int MaxErrors[SourceCount][2] = {};
+	double DifferentPixels[SourceCount][2] = {};
+	double CheckedPixels[SourceCount][2] = {};
+	for (auto SizesPtr = CheckSizes.begin(); SizesPtr != CheckSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+		std::vector<unsigned short> SourceImage(ImageSize * 4);
+		std::vector<unsigned short> ReferenceImage(ImageSize);
+		std::vector<unsigned short> YImage(ImageSize);
+
+		for (int i = 0; i < SourceCount; i++)
+		{
+			FillHighBitDepthImage(SourceImage, Sources[i]);
+			const ImageDescriptor Source = MakeImageDescriptor(&SourceImage[0], ImageWidth, ImageHeight, Sources[i].Format);
+			for (int j = 0; j < 2; j++)
+				for (int Coefficients = LUMA_BT601; Coefficients <= LUMA_BT2020; Coefficients++)
+				{
+					const ImageDescriptor Reference = MakeImageDescriptor(&ReferenceImage[0], ImageWidth, ImageHeight, OutputFormats[j]);
+					const ImageDescriptor Destination = MakeImageDescriptor(&YImage[0], ImageWidth, ImageHeight, OutputFormats[j]);
+					ConvertToLumaHighBitDepthReference(Source, Reference, Sources[i].BitDepth, (LumaCoefficients)Coefficients);
+					for (int Variant = 0; Variant < 4; Variant++)
+					{
+						const LumaISA ISA = (Variant & 1) ? LUMA_ISA_BEST : LUMA_ISA_SCALAR;
+						const bool Parallel = (Variant & 2) != 0;
+						ConvertToLumaHighBitDepth(Source, Destination, Sources[i].BitDepth, (LumaCoefficients)Coefficients, ISA, Parallel);
+						int MaxError = 0;
+						for (int k = 0; k < ImageSize; k++)
+						{
+							const int Error = (OutputFormats[j] == PIXEL_FORMAT_Y8) ?
+								abs((int)((unsigned char *)&YImage[0])[k] - (int)((unsigned char *)&ReferenceImage[0])[k]) :
+								abs((int)YImage[k] - (int)ReferenceImage[k]);
+							MaxError = std::max(MaxError, Error);
+							DifferentPixels[i][j] += (Error != 0);
+						}
+						CheckedPixels[i][j] += ImageSize;
+						MaxErrors[i][j] = std::max(MaxErrors[i][j], MaxError);
+						if (MaxError > HIGH_BIT_DEPTH_MAX_ERROR)
+						{
+							cerr << Sources[i].Name << " to " << GetPixelFormatName(OutputFormats[j]) << " conversion of " << ImageWidth << "x"
+								 << ImageHeight << " pixels with " << ((ISA == LUMA_ISA_SCALAR) ? "scalar" : "SIMD") << (Parallel ? " TBB" : "")
+								 << " code differs by " << MaxError << " from the reference" << endl;
+							ExitCode = 1;
+						}
+					}
+				}
+		}
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+	{
+		cout << left << setw(20) << "Source" << setw(8) << "Output" << right << setw(12) << "max error" << setw(12) << "% inexact" << endl;
+		for (int i = 0; i < SourceCount; i++)
+			for (int j = 0; j < 2; j++)
+				cout << left << setw(20) << Sources[i].Name << setw(8) << GetPixelFormatName(OutputFormats[j]) << right << setw(12) << MaxErrors[i][j]
+					 << fixed << setprecision(4) << setw(12) << DifferentPixels[i][j] / CheckedPixels[i][j] * 100.0 << endl;
+		cout << "allowed error " << HIGH_BIT_DEPTH_MAX_ERROR << ", SIMD kernel " << ((GetCPUFeatures().AVX2 && GetCPUFeatures().F16C) ? "AVX2 + F16C" : "not supported") << endl << endl;
+	}
+
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+		std::vector<unsigned short> SourceImage(ImageSize * 4);
+		std::vector<unsigned short> YImage(ImageSize);
+
+		// one integer bit depth is enough, the kernels do not depend on it
+		for (int i = 1; i < SourceCount; i += 2)
+		{
+			FillHighBitDepthImage(SourceImage, Sources[i]);
+			for (int j = 0; j < 2; j++)
+				for (int Variant = 0; Variant < 3; Variant++)
+				{
+					const ImageDescriptor Source = MakeImageDescriptor(&SourceImage[0], ImageWidth, ImageHeight, Sources[i].Format);
+					const ImageDescriptor Destination = MakeImageDescriptor(&YImage[0], ImageWidth, ImageHeight, OutputFormats[j]);
+					const char *VariantNames[] = { " Scalar", " SIMD", " TBB" };
+					BenchmarkResult Result;
+					Result.Implementation = std::string(GetPixelFormatName(Sources[i].Format)) + " " + GetPixelFormatName(OutputFormats[j]) + VariantNames[Variant];
+					if (!IsImplementationSelected(Result.Implementation, Settings.ImplementationFilters))
+						continue;
+					Result.ImageWidth = ImageWidth;
+					Result.ImageHeight = ImageHeight;
+					Result.BytesPerRun = (double)ImageSize * (GetPixelSize(Sources[i].Format) + GetPixelSize(OutputFormats[j]));
+					const int BitDepth = Sources[i].BitDepth;
+					const LumaISA ISA = (Variant == 0) ? LUMA_ISA_SCALAR : LUMA_ISA_BEST;
+					const bool Parallel = (Variant == 2);
+					Result.Statistics = RunBenchmark([=]() { ConvertToLumaHighBitDepth(Source, Destination, BitDepth, LUMA_BT601, ISA, Parallel); }, Settings.Options);
+					Report.Add(Result);
+				}
+		}
+	}
+	return ExitCode;
+}
+
+// RunBatchMode
+// TBBDemo --batch [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...] [--format table|csv|json]
+// converts a batch of BATCH_IMAGE_COUNT RGBA images whose sizes cycle through the given ones, thumbnail sizes by
+// default, with a loop that calls an existing function once per image and with ConvertToLumaBatch, after checking
+// that the latter matches the serial kernel; the whole batch is reported as a single row of all its pixels
+
+static int RunBatchMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const int BATCH_IMAGE_COUNT = 1000;
+
+	std::vector<std::pair<int, int> > ThumbnailSizes;
+	ThumbnailSizes.push_back(std::make_pair(64, 64));
+	ThumbnailSizes.push_back(std::make_pair(96, 96));
+	ThumbnailSizes.push_back(std::make_pair(128, 128));
+	ThumbnailSizes.push_back(std::make_pair(160, 120));
+	ThumbnailSizes.push_back(std::make_pair(256, 256));
+	ThumbnailSizes.push_back(std::make_pair(320, 240));
+	ThumbnailSizes.push_back(std::make_pair(512, 384));
+	ThumbnailSizes.push_back(std::make_pair(512, 512));
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings, &ThumbnailSizes))
+	{
+		cout << "Usage: TBBDemo --batch [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                       [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	std::vector<ImageDescriptor> Sources, YImages, ReferenceImages;
+	long long TotalPixels = 0;
+	for (int i = 0; i < BATCH_IMAGE_COUNT; i++)
+	{
+		const std::pair<int, int> &Size = Settings.ImageSizes[i % Settings.ImageSizes.size()];
+		const int ImageSize = Size.first * Size.second;
+		unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+		// a seed per image, so that images of the same size differ
+		FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE, 0x5555 + i);
+		Sources.push_back(MakeImageDescriptor(RGBAImage, Size.first, Size.second, PIXEL_FORMAT_RGBA32));
+		YImages.push_back(MakeImageDescriptor(new unsigned char[ImageSize], Size.first, Size.second, PIXEL_FORMAT_Y8));
+		ReferenceImages.push_back(MakeImageDescriptor(new unsigned char[ImageSize], Size.first, Size.second, PIXEL_FORMAT_Y8));
+		TotalPixels += ImageSize;
+	}
+
+	int ExitCode = 0;
+	if (!ConvertToLumaBatch(&Sources[0], &YImages[0], BATCH_IMAGE_COUNT))
+	{
+		cerr << "Batch conversion failed" << endl;
+		ExitCode = 1;
+	}
+	for (int i = 0; i < BATCH_IMAGE_COUNT; i++)
+	{
+		ProcessRGBSerial(Sources[i], ReferenceImages[i]);
+		if (memcmp(YImages[i].Data, ReferenceImages[i].Data, YImages[i].Width * YImages[i].Height) != 0)
+		{
+			cerr << "Batch conversion of image " << i << " does not match the serial kernel" << endl;
+			ExitCode = 1;
+		}
+	}
+
+	const struct {
+		const char *Name;
+		ImageFunction Function;
+	} PerImageFunctions[] = {
+		{ "Per-image TBB2", &ProcessRGBTBB2 },
+		{ "Per-image TBB SIMD", &ProcessRGBTBBSIMDAuto },
+		{ "Per-image SIMD", &ProcessRGBSIMDAuto }
+	};
+	BenchmarkReport Report(cout, Settings.Format);
+	BenchmarkResult Result;
+	Result.ImageWidth = (int)TotalPixels;
+	Result.ImageHeight = 1;
+	Result.BytesPerRun = (double)TotalPixels * (RGBA_PIXEL_SIZE + 1);
+	for (int i = 0; i < (int)(sizeof(PerImageFunctions) / sizeof(PerImageFunctions[0])); i++)
+	{
+		Result.Implementation = PerImageFunctions[i].Name;
+		if (!IsImplementationSelected(Result.Implementation, Settings.ImplementationFilters))
+			continue;
+		ImageFunction Function = PerImageFunctions[i].Function;
+		Result.Statistics = RunBenchmark([&]() {
+				for (int j = 0; j < BATCH_IMAGE_COUNT; j++)
+					Function(Sources[j], YImages[j]);
+			}, Settings.Options);
+		Report.Add(Result);
+	}
+	Result.Implementation = "Batch";
+	if (IsImplementationSelected(Result.Implementation, Settings.ImplementationFilters))
+	{
+		Result.Statistics = RunBenchmark([&]() { ConvertToLumaBatch(&Sources[0], &YImages[0], BATCH_IMAGE_COUNT); }, Settings.Options);
+		Report.Add(Result);
+	}
+
+	for (int i = 0; i < BATCH_IMAGE_COUNT; i++)
+	{
+		delete[] Sources[i].Data;
+		delete[] YImages[i].Data;
+		delete[] ReferenceImages[i].Data;
+	}
+	return ExitCode;
+}
+
+// RunAsyncMode
+// TBBDemo --async [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]
+// checks that an asynchronous conversion matches the serial kernel and runs its continuation, times it against the
+// blocking TBB SIMD function, then measures how long Cancel takes to stop a conversion that has just started: the time
+// from the call to Cancel to the return of Wait, which is printed after the table
+
+static int RunAsyncMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings) || !Settings.ImplementationFilters.empty())
+	{
+		cout << "Usage: TBBDemo --async [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	int ExitCode = 0;
+	std::vector<std::string> CancellationSummaries;
+	{
+		BenchmarkReport Report(cout, Settings.Format);
+		for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+		{
+			const int ImageWidth = SizesPtr->first;
+			const int ImageHeight = SizesPtr->second;
+			const int ImageSize = ImageWidth * ImageHeight;
+
+			unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+			FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+			unsigned char *GrayImage = new unsigned char[ImageSize];
+			unsigned char *ReferenceImage = new unsigned char[ImageSize];
+			const ImageDescriptor Source = MakeImageDescriptor(RGBAImage, ImageWidth, ImageHeight, PIXEL_FORMAT_RGBA32);
+			const ImageDescriptor YImage = MakeImageDescriptor(GrayImage, ImageWidth, ImageHeight, PIXEL_FORMAT_Y8);
+
+			ProcessRGBSerial(RGBAImage, ReferenceImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+			std::atomic<int> ContinuationStatus(-1);
+			ConversionHandle Handle = ConvertToLumaAsync(Source, YImage);
+			Handle.SetContinuation([&ContinuationStatus](ConversionStatus Status) { ContinuationStatus = Status; });
+			if ((Handle.Wait() != CONVERSION_COMPLETED) || (memcmp(GrayImage, ReferenceImage, ImageSize) != 0))
+			{
+				cerr << "Asynchronous conversion of " << ImageWidth << "x" << ImageHeight << " does not match the serial kernel" << endl;
+				ExitCode = 1;
+			}
+			// the continuation runs after the waiting threads are woken up
+			while (ContinuationStatus.load() == -1)
+				std::this_thread::yield();
+			if (ContinuationStatus.load() != CONVERSION_COMPLETED)
+			{
+				cerr << "Continuation of " << ImageWidth << "x" << ImageHeight << " did not receive the completed status" << endl;
+				ExitCode = 1;
+			}
+
+			BenchmarkResult Result;
+			Result.ImageWidth = ImageWidth;
+			Result.ImageHeight = ImageHeight;
+			Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+			Result.Implementation = "Blocking TBB SIMD";
+			Result.Statistics = RunBenchmark([=]() { ProcessRGBTBBSIMDAuto(Source, YImage); }, Settings.Options);
+			Report.Add(Result);
+			Result.Implementation = "Async and Wait";
+			Result.Statistics = RunBenchmark([=]() { ConvertToLumaAsync(Source, YImage).Wait(); }, Settings.Options);
+			Report.Add(Result);
+
+			std::vector<double> CancelLatencies;
+			double Progress = 0.0;
+			for (int i = 0; i < Settings.Options.Repetitions; i++)
+			{
+				ConversionHandle CancelledHandle = ConvertToLumaAsync(Source, YImage);
+				while ((CancelledHandle.GetProgress() == 0.0) && (CancelledHandle.GetStatus() == CONVERSION_RUNNING))
+					std::this_thread::yield();
+				BenchmarkTimer Timer;
+				CancelledHandle.Cancel();
+				CancelledHandle.Wait();
+				CancelLatencies.push_back(Timer.GetElapsedNs());
+				Progress += CancelledHandle.GetProgress();
+			}
+			BenchmarkStatistics CancelStatistics = ComputeBenchmarkStatistics(CancelLatencies);
+			CancellationSummaries.push_back("Cancellation of " + std::to_string((long long)ImageWidth) + "x" + std::to_string((long long)ImageHeight) +
+				": median " + std::to_string((long long)(CancelStatistics.MedianNs / 1000.0)) + " us, p95 " +
+				std::to_string((long long)(CancelStatistics.P95Ns / 1000.0)) + " us, " +
+				std::to_string((long long)(Progress / Settings.Options.Repetitions * 100.0)) + "% of the image converted on average");
+
+			delete[] RGBAImage;
+			delete[] GrayImage;
+			delete[] ReferenceImage;
+		}
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		for (size_t i = 0; i < CancellationSummaries.size(); i++)
+			cout << CancellationSummaries[i] << endl;
+	return ExitCode;
+}
+
+// RunTilingMode
+// TBBDemo --tiling [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...] [--format table|csv|json]
+// compares the 1D ranges of the TBB SIMD functions with the tiled conversion, to a linear and to a tiled luma image,
+// on widths that are not all powers of two, after checking the tiled results against the serial kernel
+
+static int RunTilingMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	std::vector<std::pair<int, int> > DefaultSizes;
+	DefaultSizes.push_back(std::make_pair(1920, 1080));
+	DefaultSizes.push_back(std::make_pair(2048, 2048));
+	DefaultSizes.push_back(std::make_pair(3000, 2000));
+	DefaultSizes.push_back(std::make_pair(4096, 4096));
+	DefaultSizes.push_back(std::make_pair(5000, 5000));
+	DefaultSizes.push_back(std::make_pair(8192, 8192));
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings, &DefaultSizes))
+	{
+		cout << "Usage: TBBDemo --tiling [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                        [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+	{
+		PrintBanner();
+		const CPUCacheSizes &CacheSizes = GetCPUCacheSizes();
+		cout << "L1 data cache " << CacheSizes.L1Data / 1024 << " KB, L2 cache " << CacheSizes.L2 / 1024 << " KB, L3 cache "
+			 << CacheSizes.L3 / 1024 << " KB" << endl;
+	}
+
+	int ExitCode = 0;
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+		const TileSettings Tiles = GetDefaultTileSettings(PIXEL_FORMAT_RGBA32, ImageWidth);
+
+		unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+		FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+		unsigned char *GrayImage = new unsigned char[ImageSize];
+		unsigned char *ReferenceImage = new unsigned char[ImageSize];
+		unsigned char *TiledBuffer = new unsigned char[GetTiledImageSize(ImageWidth, ImageHeight, Tiles)];
+		const ImageDescriptor Source = MakeImageDescriptor(RGBAImage, ImageWidth, ImageHeight, PIXEL_FORMAT_RGBA32);
+		const ImageDescriptor YImage = MakeImageDescriptor(GrayImage, ImageWidth, ImageHeight, PIXEL_FORMAT_Y8);
+		const TiledImage TiledYImage = MakeTiledImage(TiledBuffer, ImageWidth, ImageHeight, Tiles);
+
+		ProcessRGBSerial(RGBAImage, ReferenceImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+		bool Matches = ConvertToLumaTiled(Source, YImage, Tiles) && (memcmp(GrayImage, ReferenceImage, ImageSize) == 0);
+		memset(GrayImage, 0, ImageSize);
+		Matches = ConvertToLumaTiled(Source, TiledYImage) && Matches;
+		UntileImage(TiledYImage, YImage);
+		if (!Matches || (memcmp(GrayImage, ReferenceImage, ImageSize) != 0))
+		{
+			cerr << "Tiled conversion of " << ImageWidth << "x" << ImageHeight << " does not match the serial kernel" << endl;
+			ExitCode = 1;
+		}
+
+		const struct {
+			const char *Name;
+			std::function<void()> Function;
+		} Implementations[] = {
+			{ "TBB SIMD", [=]() { ProcessRGBTBBSIMD(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE); } },
+			{ "TBB SIMD Auto", [=]() { ProcessRGBTBBSIMDAuto(RGBAImage, GrayImage, ImageWidth, ImageHeight, RGBA_PIXEL_SIZE); } },
+			{ "Tiled", [=]() { ConvertToLumaTiled(Source, YImage, Tiles); } },
+			{ "Tiled layout", [=]() { ConvertToLumaTiled(Source, TiledYImage); } }
+		};
+		for (int i = 0; i < (int)(sizeof(Implementations) / sizeof(Implementations[0])); i++)
+		{
+			if (!IsImplementationSelected(Implementations[i].Name, Settings.ImplementationFilters))
+				continue;
+			BenchmarkResult Result;
+			Result.Implementation = Implementations[i].Name;
+			Result.ImageWidth = ImageWidth;
+			Result.ImageHeight = ImageHeight;
+			Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+			Result.Statistics = RunBenchmark(Implementations[i].Function, Settings.Options);
+			Report.Add(Result);
+		}
+
+		delete[] RGBAImage;
+		delete[] GrayImage;
+		delete[] ReferenceImage;
+		delete[] TiledBuffer;
+	}
+	return ExitCode;
+}
+
+// RunIncrementalMode
+// TBBDemo --incremental [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...] [--format table|csv|json]
+// alternates between two frames that differ by one pixel in a given share of the tiles, and compares the full
+// frame ProcessRGBTBBSIMD with the incremental conversion, fingerprinting every tile or given the dirty rectangles
+// of the changed pixels; a single pixel is the hardest change to detect and costs as much to convert as a full tile
+// throughput is counted on the pixels and bytes of the whole frame, so that it is comparable with the full conversion
+// the luma image is checked against the serial kernel after each measurement
+
+static int RunIncrementalMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const int ChangePercentages[] = { 0, 1, 5, 25, 100 };
+
+	std::vector<std::pair<int, int> > DefaultSizes;
+	DefaultSizes.push_back(std::make_pair(1920, 1080));
+	DefaultSizes.push_back(std::make_pair(3840, 2160));
+	DefaultSizes.push_back(std::make_pair(7680, 4320));
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings, &DefaultSizes))
+	{
+		cout << "Usage: TBBDemo --incremental [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                             [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+	{
+		PrintBanner();
+		const TileSettings Tiles = GetDefaultIncrementalTileSettings();
+		cout << "Tiles of " << Tiles.TileWidth << "x" << Tiles.TileHeight << " pixels" << endl << endl;
+	}
+
+	int ExitCode = 0;
+	BenchmarkReport Report(cout, Settings.Format);
+	for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+	{
+		const int ImageWidth = SizesPtr->first;
+		const int ImageHeight = SizesPtr->second;
+		const int ImageSize = ImageWidth * ImageHeight;
+
+		std::vector<unsigned char> Frames[2];
+		std::vector<unsigned char> References[2];
+		Frames[0] = CreateRandomImage(ImageSize * RGBA_PIXEL_SIZE);
+		// seeds the positions of the changed pixels below
+		srand(0x5555);
+		std::vector<unsigned char> GrayImage(ImageSize);
+		const ImageDescriptor YImage = MakeImageDescriptor(&GrayImage[0], ImageWidth, ImageHeight, PIXEL_FORMAT_Y8);
+
+		BenchmarkResult Result;
+		Result.ImageWidth = ImageWidth;
+		Result.ImageHeight = ImageHeight;
+		Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+		Result.Implementation = "Full TBB SIMD";
+		if (IsImplementationSelected(Result.Implementation, Settings.ImplementationFilters))
+		{
+			const ImageDescriptor Source = MakeImageDescriptor(&Frames[0][0], ImageWidth, ImageHeight, PIXEL_FORMAT_RGBA32);
+			Result.Statistics = RunBenchmark([=]() { ProcessRGBTBBSIMD(Source, YImage); }, Settings.Options);
+			Report.Add(Result);
+		}
+
+		for (int i = 0; i < (int)(sizeof(ChangePercentages) / sizeof(ChangePercentages[0])); i++)
+		{
+			IncrementalConverter Converter(ImageWidth, ImageHeight, PIXEL_FORMAT_RGBA32);
+			const TileSettings Tiles = GetDefaultIncrementalTileSettings();
+			const int TileColumns = (ImageWidth + Tiles.TileWidth - 1) / Tiles.TileWidth;
+			const int ChangedTiles = (int)((long long)Converter.GetTileCount() * ChangePercentages[i] / 100);
+
+			// one pixel changed at a random position of each of the first ChangedTiles tiles of a random permutation
+			std::vector<int> TileOrder(Converter.GetTileCount());
+			for (int j = 0; j < (int)TileOrder.size(); j++)
+				TileOrder[j] = j;
+			for (int j = (int)TileOrder.size() - 1; j > 0; j--)
+				std::swap(TileOrder[j], TileOrder[rand() % (j + 1)]);
+			Frames[1] = Frames[0];
+			std::vector<DirtyRect> Rects;
+			for (int j = 0; j < ChangedTiles; j++)
+			{
+				DirtyRect Rect;
+				Rect.X = std::min((TileOrder[j] % TileColumns) * Tiles.TileWidth + rand() % Tiles.TileWidth, ImageWidth - 1);
+				Rect.Y = std::min((TileOrder[j] / TileColumns) * Tiles.TileHeight + rand() % Tiles.TileHeight, ImageHeight - 1);
+				Rect.Width = 1;
+				Rect.Height = 1;
+				Frames[1][((long long)Rect.Y * ImageWidth + Rect.X) * RGBA_PIXEL_SIZE + rand() % 3] ^= 0x80;
+				Rects.push_back(Rect);
+			}
+			ImageDescriptor Sources[2];
+			for (int j = 0; j < 2; j++)
+			{
+				Sources[j] = MakeImageDescriptor(&Frames[j][0], ImageWidth, ImageHeight, PIXEL_FORMAT_RGBA32);
+				References[j].resize(ImageSize);
+				ProcessRGBSerial(&Frames[j][0], &References[j][0], ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+			}
+
+			for (int UseRects = 0; UseRects < 2; UseRects++)
+			{
+				Result.Implementation = std::string(UseRects ? "Dirty rects " : "Incremental ") + std::to_string((long long)ChangePercentages[i]) + "%";
+				if (!IsImplementationSelected(Result.Implementation, Settings.ImplementationFilters))
+					continue;
+				Converter.Reset();
+				Converter.Convert(Sources[0], YImage);
+				int Frame = 0;
+				Result.Statistics = RunBenchmark([&]() {
+						Frame ^= 1;
+						if (UseRects)
+							Converter.Convert(Sources[Frame], YImage, Rects.empty() ? NULL : &Rects[0], (int)Rects.size());
+						else
+							Converter.Convert(Sources[Frame], YImage);
+					}, Settings.Options);
+				Report.Add(Result);
+				if (GrayImage != References[Frame])
+				{
+					cerr << Result.Implementation << " conversion of " << ImageWidth << "x" << ImageHeight << " does not match the serial kernel" << endl;
+					ExitCode = 1;
+				}
+			}
+		}
+	}
+	return ExitCode;
+}
+
+// RunTuneMode
+// TBBDemo --tune [--retune] [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...] [--format table|csv|json]
+// loads the choices of the tuner from its cache file, or tunes it and writes the file when the cache cannot be used
+// or --retune is given, then times the tuned conversion against the TBB SIMD function on RGBA images; the table
+// format ends with the backend chosen for each pixel format and size class
+
+static int RunTuneMode(int argc, _TCHAR* argv[])
+{
+	const int RGBA_PIXEL_SIZE = 4;
+
+	const bool Retune = (argc >= 3) && (_tcscmp(argv[2], _T("--retune")) == 0);
+	const int FirstOption = Retune ? 2 : 1;
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - FirstOption, argv + FirstOption, false, Settings) || !Settings.ImplementationFilters.empty())
+	{
+		cout << "Usage: TBBDemo --tune [--retune] [--warmup <runs>] [--repetitions <runs>] [--sizes <width>x<height>,...]" << endl;
+		cout << "                      [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	int ExitCode = 0;
+	ConversionTuner Tuner;
+	const bool Loaded = !Retune && Tuner.LoadCache(GetDefaultTunerCacheName());
+	if (Loaded && (Settings.Format == BENCHMARK_FORMAT_TABLE))
+		cout << "Tuning loaded from " << GetDefaultTunerCacheName() << endl;
+	{
+		BenchmarkReport Report(cout, Settings.Format);
+		if (!Loaded)
+		{
+			std::vector<TunerMeasurement> Measurements;
+			Tuner.Tune(Settings.Options, &Measurements);
+			for (size_t i = 0; i < Measurements.size(); i++)
+			{
+				BenchmarkResult Result;
+				Result.Implementation = std::string(GetPixelFormatName(Measurements[i].Format)) + " " + Measurements[i].Backend;
+				if (!Measurements[i].Verified)
+				{
+					cerr << Result.Implementation << " on " << Measurements[i].ImageWidth << "x" << Measurements[i].ImageHeight
+						 << " does not match the serial kernel" << endl;
+					ExitCode = 1;
+					continue;
+				}
+				Result.ImageWidth = Measurements[i].ImageWidth;
+				Result.ImageHeight = Measurements[i].ImageHeight;
+				Result.BytesPerRun = (double)Result.ImageWidth * Result.ImageHeight * (GetPixelSize(Measurements[i].Format) + 1);
+				Result.Statistics = Measurements[i].Statistics;
+				Report.Add(Result);
+			}
+			if (!Tuner.SaveCache(GetDefaultTunerCacheName()))
+				cerr << "Cannot write " << GetDefaultTunerCacheName() << endl;
+		}
+
+		for (auto SizesPtr = Settings.ImageSizes.begin(); SizesPtr != Settings.ImageSizes.end(); SizesPtr++)
+		{
+			const int ImageWidth = SizesPtr->first;
+			const int ImageHeight = SizesPtr->second;
+			const int ImageSize = ImageWidth * ImageHeight;
+
+			unsigned char *RGBAImage = new unsigned char[ImageSize * RGBA_PIXEL_SIZE];
+			FillRandomImage(RGBAImage, ImageSize * RGBA_PIXEL_SIZE);
+			unsigned char *GrayImage = new unsigned char[ImageSize];
+			const ImageDescriptor Source = MakeImageDescriptor(RGBAImage, ImageWidth, ImageHeight, PIXEL_FORMAT_RGBA32);
+			const ImageDescriptor YImage = MakeImageDescriptor(GrayImage, ImageWidth, ImageHeight, PIXEL_FORMAT_Y8);
+
+			BenchmarkResult Result;
+			Result.ImageWidth = ImageWidth;
+			Result.ImageHeight = ImageHeight;
+			Result.BytesPerRun = (double)ImageSize * (RGBA_PIXEL_SIZE + 1);
+			Result.Implementation = "TBB SIMD Auto";
+			Result.Statistics = RunBenchmark([=]() { ProcessRGBTBBSIMDAuto(Source, YImage); }, Settings.Options);
+			Report.Add(Result);
+			Result.Implementation = std::string("Tuned ") + Tuner.GetBackend(PIXEL_FORMAT_RGBA32, ImageWidth, ImageHeight).Name;
+			Result.Statistics = RunBenchmark([&]() { Tuner.Convert(Source, YImage); }, Settings.Options);
+			Report.Add(Result);
+
+			delete[] RGBAImage;
+			delete[] GrayImage;
+		}
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+	{
+		const PixelFormat Formats[] = { PIXEL_FORMAT_RGB24, PIXEL_FORMAT_RGBA32, PIXEL_FORMAT_BGR24, PIXEL_FORMAT_BGRA32, PIXEL_FORMAT_ARGB32 };
+		const int ClassSizes[TUNER_SIZE_CLASSES] = { 64, 512, 2048, 8192 };
+		for (int i = 0; i < (int)(sizeof(Formats) / sizeof(Formats[0])); i++)
+		{
+			cout << left << setw(8) << GetPixelFormatName(Formats[i]);
+			for (int SizeClass = 0; SizeClass < TUNER_SIZE_CLASSES; SizeClass++)
+				cout << setw(8) << GetTunerSizeClassName((TunerSizeClass)SizeClass) << setw(14)
+					 << Tuner.GetBackend(Formats[i], ClassSizes[SizeClass], ClassSizes[SizeClass]).Name;
+			cout << right << endl;
+		}
+	}
+	return ExitCode;
+}
+
+// GetVerifyTargets
+// the kernels of the benchmark on packed images of their own format, and the functions that take an ImageDescriptor
+// on all the RGB formats
+
+static std::vector<VerifyTarget> GetVerifyTargets()
+{
+	const char *CoefficientsNames[] = { "BT.601", "BT.709", "BT.2020" };
+
+	const std::vector<PixelFormat> RGBFormats = GetRGBPixelFormats();
+	std::vector<VerifyTarget> Targets;
+	std::vector<TBBDemoImplementation> Implementations = GetImplementations();
+	for (auto ImplementationsPtr = Implementations.begin(); ImplementationsPtr != Implementations.end(); ImplementationsPtr++)
+	{
+		TBBDemoFunction Function = ImplementationsPtr->Function;
+		VerifyTarget Target(ImplementationsPtr->Name, [=](const ImageDescriptor &Source, const ImageDescriptor &YImage) {
+				Function(Source.Data, YImage.Data, Source.Width, Source.Height, GetPixelSize(Source.Format));
+			}, std::vector<PixelFormat>(1, ImplementationsPtr->SourceFormat),
+			ImplementationsPtr->MaxError, ImplementationsPtr->Coefficients);
+		Target.PackedOnly = true;
+#if defined(HAS_CPP_AMP)
+		// the AMP kernel writes the luma plane 4 pixels at a time
+		if (Function == &ProcessRGBAMP)
+			Target.PixelGranularity = 4;
+#endif
+		Targets.push_back(Target);
+	}
+
+	const CPUFeatures &Features = GetCPUFeatures();
+	const struct {
+		const char *Name;
+		ImageFunction Function;
+		int MaxError;
+		bool Supported;
+	} ImageFunctions[] = {
+		{ "Serial", &ProcessRGBSerial, 0, true },
+		{ "TBB1", &ProcessRGBTBB1, 0, true },
+		{ "TBB2", &ProcessRGBTBB2, 0, true },
+		{ "TBB3", &ProcessRGBTBB3, 0, true },
+		{ "SIMD1", &ProcessRGBSIMD, 0, true },
+		{ "SIMD2", &ProcessRGBSIMD2, 0, true },
+		{ "SIMD3", &ProcessRGBSIMD3, TRUNCATED_SCALES_MAX_ERROR, true },
+		{ "TBB SIMD", &ProcessRGBTBBSIMD, 0, true },
+		{ "SSSE3 Fast Rounded", &ProcessRGBSSSE3FastRounded, ROUNDED_SCALES_MAX_ERROR, Features.SSSE3 },
+		{ "AVX2", &ProcessRGBAVX2, 0, Features.AVX2 },
+		{ "AVX2 Fast", &ProcessRGBAVX2Fast, TRUNCATED_SCALES_MAX_ERROR, Features.AVX2 },
+		{ "AVX2 Fast Rounded", &ProcessRGBAVX2FastRounded, ROUNDED_SCALES_MAX_ERROR, Features.AVX2 },
+		{ "TBB AVX2", &ProcessRGBTBBAVX2, 0, Features.AVX2 },
+		{ "AVX-512", &ProcessRGBAVX512, 0, Features.AVX512BW },
+		{ "AVX-512 Fast", &ProcessRGBAVX512Fast, TRUNCATED_SCALES_MAX_ERROR, Features.AVX512BW },
+		{ "AVX-512 Fast Rounded", &ProcessRGBAVX512FastRounded, ROUNDED_SCALES_MAX_ERROR, Features.AVX512BW },
+		{ "TBB AVX-512", &ProcessRGBTBBAVX512, 0, Features.AVX512BW },
+		{ "SIMD Auto", &ProcessRGBSIMDAuto, 0, true },
+		{ "SIMD Fast Auto", &ProcessRGBSIMDFastAuto, TRUNCATED_SCALES_MAX_ERROR, true },
+		{ "SIMD Fast Rounded Auto", &ProcessRGBSIMDFastRoundedAuto, ROUNDED_SCALES_MAX_ERROR, true },
+		{ "TBB SIMD Auto", &ProcessRGBTBBSIMDAuto, 0, true }
+	};
+	for (int i = 0; i < (int)(sizeof(ImageFunctions) / sizeof(ImageFunctions[0])); i++)
+		if (ImageFunctions[i].Supported)
+			Targets.push_back(VerifyTarget(std::string(ImageFunctions[i].Name) + " strided", ImageFunctions[i].Function, RGBFormats,
+										   ImageFunctions[i].MaxError));
+	for (int Coefficients = LUMA_BT601; Coefficients <= LUMA_BT2020; Coefficients++)
+		for (int ReducedPrecision = 0; ReducedPrecision < 2; ReducedPrecision++)
+			for (int Parallel = 0; Parallel < 2; Parallel++)
+				Targets.push_back(VerifyTarget(std::string("Luma ") + CoefficientsNames[Coefficients] + (ReducedPrecision ? " Fast" : "") + (Parallel ? " TBB" : ""),
+											   [=](const ImageDescriptor &Source, const ImageDescriptor &YImage) {
+												   ConvertToLuma(Source, YImage, (LumaCoefficients)Coefficients, ReducedPrecision != 0, Parallel != 0);
+											   }, RGBFormats, ReducedPrecision ? ROUNDED_SCALES_MAX_ERROR : 0, (LumaCoefficients)Coefficients));
+	Targets.push_back(VerifyTarget("Tiled", [](const ImageDescriptor &Source, const ImageDescriptor &YImage) {
+			ConvertToLumaTiled(Source, YImage, GetDefaultTileSettings(Source.Format, Source.Width));
+		}, RGBFormats));
+	// the smallest tiles, so that most images span several tile rows and columns
+	Targets.push_back(VerifyTarget("Tiled 32x8", [](const ImageDescriptor &Source, const ImageDescriptor &YImage) {
+			TileSettings Tiles = { 32, 8 };
+			ConvertToLumaTiled(Source, YImage, Tiles);
+		}, RGBFormats));
+	Targets.push_back(VerifyTarget("Batch", [](const ImageDescriptor &Source, const ImageDescriptor &YImage) {
+			ConvertToLumaBatch(&Source, &YImage, 1);
+		}, RGBFormats));
+
+	return Targets;
+}
+
+// RunVerifyMode
+// TBBDemo --verify [--cases <count>] [--seed <value>] [--implementations <name>,...]
+// compares every implementation with the scalar kernel on random images, see VerifyImplementation: the kernels of
+// the benchmark on packed images of their own format, and the functions that take an ImageDescriptor on all the RGB
+// formats with padded, bottom-up and misaligned rows; the reduced precision ones pass when their error is at most
+// TRUNCATED_SCALES_MAX_ERROR or ROUNDED_SCALES_MAX_ERROR, all the others must be bit-exact
+// the largest error of each implementation is listed, the details of the failures are written to cerr
+
+static int RunVerifyMode(int argc, _TCHAR* argv[])
+{
+	VerifyOptions Options;
+	Options.CaseCount = 100;
+	Options.Seed = 0x5555;
+	Options.MaxWidth = 1500;
+	Options.MaxHeight = 200;
+	std::vector<std::string> ImplementationFilters;
+	bool ValidArguments = true;
+	for (int i = 2; (i < argc) && ValidArguments; i += 2)
+	{
+		ValidArguments = (i + 1 < argc);
+		if (!ValidArguments)
+			break;
+		std::string Option = ToLower(argv[i]);
+		std::string Value = ToLower(argv[i + 1]);
+		if (Option == "--cases")
+			ValidArguments = ((Options.CaseCount = atoi(Value.c_str())) > 0);
+		else if (Option == "--seed")
+			Options.Seed = (unsigned int)strtoul(Value.c_str(), NULL, 0);
+		else if (Option == "--implementations")
+			ImplementationFilters = SplitList(Value);
+		else
+			ValidArguments = false;
+	}
+	if (!ValidArguments)
+	{
+		cout << "Usage: TBBDemo --verify [--cases <count>] [--seed <value>] [--implementations <name>,...]" << endl;
+		return 1;
+	}
+	PrintBanner();
+	const std::vector<VerifyTarget> Targets = GetVerifyTargets();
+
+	int ExitCode = 0;
+	cout << "Cases per implementation: " << Options.CaseCount << ", seed " << Options.Seed << endl;
+	cout << left << setw(32) << "Implementation" << right << setw(8) << "Cases" << setw(8) << "Failed"
+		 << setw(12) << "Max error" << setw(10) << "Allowed" << setw(14) << "Inexact %" << endl;
+	for (auto TargetsPtr = Targets.begin(); TargetsPtr != Targets.end(); TargetsPtr++)
+	{
+		if (!IsImplementationSelected(TargetsPtr->Name, ImplementationFilters))
+			continue;
+		VerifyResult Result = VerifyImplementation(*TargetsPtr, Options);
+		cout << left << setw(32) << Result.Name << right << setw(8) << Result.Cases << setw(8) << Result.FailedCases
+			 << setw(12) << Result.MaxError << setw(10) << Result.AllowedError << fixed << setprecision(3)
+			 << setw(14) << (Result.Pixels ? 100.0 * Result.DifferentPixels / Result.Pixels : 0.0) << endl;
+		if (Result.FailedCases)
+		{
+			cerr << Result.Name << " failed " << Result.FailedCases << " of " << Result.Cases << " cases, the first one is "
+				 << Result.FirstFailure << endl;
+			ExitCode = 1;
+		}
+	}
+	return ExitCode;
+}
+
+// RunExhaustiveMode
+// TBBDemo --exhaustive [--implementations <name>,...]
+// runs the implementations of the verify mode on every one of the 2^24 RGB colors, in each of the formats they are
+// verified on, see VerifyExhaustively; the range and the mean of the signed differences from the scalar kernel are
+// listed with the share of exact and off-by-one results, and an implementation fails when a difference is larger
+// than the allowed one
+
+static int RunExhaustiveMode(int argc, _TCHAR* argv[])
+{
+	std::vector<std::string> ImplementationFilters;
+	if ((argc == 4) && (ToLower(argv[2]) == "--implementations"))
+		ImplementationFilters = SplitList(ToLower(argv[3]));
+	else if (argc != 2)
+	{
+		cout << "Usage: TBBDemo --exhaustive [--implementations <name>,...]" << endl;
+		return 1;
+	}
+	PrintBanner();
+	const std::vector<VerifyTarget> Targets = GetVerifyTargets();
+
+	int ExitCode = 0;
+	cout << left << setw(32) << "Implementation" << setw(8) << "Format" << right << setw(6) << "Min" << setw(6) << "Max"
+		 << setw(12) << "Mean error" << setw(10) << "Exact %" << setw(10) << "+-1 %" << setw(10) << "Allowed" << endl;
+	for (auto TargetsPtr = Targets.begin(); TargetsPtr != Targets.end(); TargetsPtr++)
+	{
+		if (!IsImplementationSelected(TargetsPtr->Name, ImplementationFilters))
+			continue;
+		for (auto FormatsPtr = TargetsPtr->Formats.begin(); FormatsPtr != TargetsPtr->Formats.end(); FormatsPtr++)
+		{
+			ExhaustiveResult Result;
+			if (!VerifyExhaustively(*TargetsPtr, *FormatsPtr, Result))
+			{
+				cerr << "Cannot allocate the images of all the colors" << endl;
+				return 1;
+			}
+			cout << left << setw(32) << Result.Name << setw(8) << GetPixelFormatName(Result.Format) << right << setw(6) << Result.MinError
+				 << setw(6) << Result.MaxError << fixed << setprecision(4) << setw(12) << Result.MeanError << setprecision(3)
+				 << setw(10) << 100.0 * Result.ExactPixels / Result.Pixels << setw(10) << 100.0 * Result.OffByOnePixels / Result.Pixels
+				 << setw(10) << Result.AllowedError << endl;
+			if (std::max(-Result.MinError, Result.MaxError) > Result.AllowedError)
+			{
+				cerr << Result.Name << " on " << GetPixelFormatName(Result.Format) << " images differs by up to "
+					 << std::max(-Result.MinError, Result.MaxError) << " from the scalar kernel, " << Result.AllowedError << " allowed" << endl;
+				ExitCode = 1;
+			}
 		}
 	}
+	return ExitCode;
+}
+
+// GetMachineDescription
+// a baseline is valid only on the CPU and with the number of threads it was recorded with
+
+static std::string GetMachineDescription()
+{
+	return std::string(GetCPUBrandString()) + ", " + std::to_string((long long)this_task_arena::max_concurrency()) + " threads";
+}
+
+// RunRegressionMode
+// TBBDemo --regression <baseline file> [--update] [--allow-missing] [--margin <percent>] [<benchmark options>]
+// benchmarks the implementations like the default mode and compares the median throughput of each one with the
+// baseline, failing when it is lower by more than the margin, 10% by default; --update records the run as the new
+// baseline instead, merged with the entries of the old one for the sizes that did not run and the implementations
+// left out by --implementations
+// an implementation that is not in the baseline, or an entry of the baseline for one of the sizes that did not run,
+// fails too, so that a renamed or dropped kernel does not slip past the gate, unless --allow-missing is given
+// the default sizes are 640x480 and 1920x1080, so that the gate takes seconds instead of the minutes of 8192x8192
+// returns 1 on regressions, and when the baseline cannot be loaded without --update
+
+static int RunRegressionMode(int argc, _TCHAR* argv[])
+{
+	std::vector<std::pair<int, int> > RegressionSizes;
+	RegressionSizes.push_back(std::make_pair(640, 480));
+	RegressionSizes.push_back(std::make_pair(1920, 1080));
+	bool Update = false;
+	bool AllowMissing = false;
+	double MarginPercent = 10.0;
+	int FirstOption = 3;
+	while (FirstOption < argc)
+	{
+		if (_tcscmp(argv[FirstOption], _T("--update")) == 0)
+		{
+			Update = true;
+			FirstOption++;
+		}
+		else if (_tcscmp(argv[FirstOption], _T("--allow-missing")) == 0)
+		{
+			AllowMissing = true;
+			FirstOption++;
+		}
+		else if ((_tcscmp(argv[FirstOption], _T("--margin")) == 0) && (FirstOption + 1 < argc))
+		{
+			MarginPercent = atof(ToString(argv[FirstOption + 1]).c_str());
+			FirstOption += 2;
+		}
+		else
+			break;
+	}
+	BenchmarkSettings Settings;
+	if ((argc < 3) || (argv[2][0] == _T('-')) || (MarginPercent <= 0.0) || (MarginPercent >= 100.0) ||
+		!ParseBenchmarkSettings(argc - (FirstOption - 1), argv + (FirstOption - 1), false, Settings, &RegressionSizes))
+	{
+		cout << "Usage: TBBDemo --regression <baseline file> [--update] [--allow-missing] [--margin <percent>]" << endl;
+		cout << "                            [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                            [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		PrintBanner();
+
+	const std::string BaselineName = ToString(argv[2]);
+	BenchmarkBaseline Baseline(GetMachineDescription());
+	if (!Baseline.Load(BaselineName) && !Update)
+	{
+		cerr << "Baseline " << BaselineName << " is missing, invalid or recorded on another machine, run with --update to record it" << endl;
+		return 1;
+	}
+	int ExitCode = 0;
+	std::vector<BenchmarkResult> Results;
+	{
+		BenchmarkReport Report(cout, Settings.Format);
+		BenchmarkImplementations(Settings, [&](const BenchmarkResult &Result, const std::function<void()> &) {
+				Report.Add(Result);
+				Results.push_back(Result);
+				if (Update)
+				{
+					Baseline.Add(Result);
+					return;
+				}
+				double BaselineMegapixelsPerSecond = Baseline.GetMegapixelsPerSecond(Result);
+				double MegapixelsPerSecond = GetMegapixelsPerSecond(Result);
+				if (BaselineMegapixelsPerSecond == 0.0)
+				{
+					cerr << Result.Implementation << " on " << Result.ImageWidth << "x" << Result.ImageHeight << " is not in the baseline" << endl;
+					if (!AllowMissing)
+						ExitCode = 1;
+				}
+				else if (MegapixelsPerSecond < BaselineMegapixelsPerSecond * (1.0 - MarginPercent / 100.0))
+				{
+					cerr << Result.Implementation << " on " << Result.ImageWidth << "x" << Result.ImageHeight << " regressed from "
+						 << fixed << setprecision(1) << BaselineMegapixelsPerSecond << " to " << MegapixelsPerSecond << " Mpixels/s ("
+						 << (1.0 - MegapixelsPerSecond / BaselineMegapixelsPerSecond) * 100.0 << "% slower)" << endl;
+					ExitCode = 1;
+				}
+			});
+	}
+	const std::vector<std::string> MissingEntries = Baseline.GetMissingEntries(Results);
+	for (auto EntriesPtr = MissingEntries.begin(); EntriesPtr != MissingEntries.end(); EntriesPtr++)
+	{
+		// the entries are "<width>x<height> <implementation>"
+		const std::string Implementation = EntriesPtr->substr(EntriesPtr->find(' ') + 1);
+		if (!IsImplementationSelected(Implementation, Settings.ImplementationFilters))
+			continue;
+		if (Update)
+			Baseline.RemoveEntry(*EntriesPtr);
+		else
+		{
+			cerr << Implementation << " on " << EntriesPtr->substr(0, EntriesPtr->find(' ')) << " is in the baseline but did not run" << endl;
+			if (!AllowMissing)
+				ExitCode = 1;
+		}
+	}
+	if (Update && !Baseline.Save(BaselineName))
+	{
+		cerr << "Cannot write baseline " << BaselineName << endl;
+		ExitCode = 1;
+	}
+	return ExitCode;
+}
 
-	Implementations.clear();
-	// free images
-	delete[] RGBAImage;
-	delete[] GrayImage;
-	// wait for user to enter a key before closing
-	char WaitForUser;
-	cin >> WaitForUser;
+// PrintCounterValue
+// prints Value in a column of Width characters, or n/a when the counters it is computed from are not available
+
+static void PrintCounterValue(bool Available, double Value, int Width, int Precision)
+{
+	if (Available)
+		cout << setw(Width) << fixed << setprecision(Precision) << Value;
+	else
+		cout << setw(Width) << "n/a";
+}
+
+// RunRooflineMode
+// TBBDemo --roofline [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...] [--sizes <width>x<height>,...] [--format table|csv|json]
+// measures the memory bandwidth with the STREAM kernels, then benchmarks the implementations like the default mode;
+// each one is run Repetitions more times while reading the performance counters, and timed on a cache-resident image
+// to find its compute roof
+// the table format ends with the counters per pixel and with the roofline of each implementation: the share of the
+// STREAM bandwidth it reaches, the lower of its compute and memory roofs and which of the two binds it, or "cache"
+// when the images fit in the last level cache and only the compute roof applies
+
+static int RunRooflineMode(int argc, _TCHAR* argv[])
+{
+	struct RooflineMeasurement {
+		BenchmarkResult Result;
+		PerfCounterValues Counters;		//< totals of the counted runs
+		double CountedNs;				//< duration of the counted runs
+	};
+
+	// opened before any parallel algorithm runs, so that the worker threads of TBB inherit the counters
+	PerfCounters Counters;
+	BenchmarkSettings Settings;
+	if (!ParseBenchmarkSettings(argc - 1, argv + 1, false, Settings))
+	{
+		cout << "Usage: TBBDemo --roofline [--warmup <runs>] [--repetitions <runs>] [--implementations <name>,...]" << endl;
+		cout << "                          [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	const bool Table = (Settings.Format == BENCHMARK_FORMAT_TABLE);
+	if (Table)
+		PrintBanner();
+
+	const StreamBandwidth Bandwidth = MeasureStreamBandwidth();
+	const double AchievableGBPerSecond = GetAchievableGBPerSecond(Bandwidth);
+	if (Table)
+	{
+		cout << "STREAM copy " << fixed << setprecision(2) << Bandwidth.CopyGBPerSecond << " GB/s, triad " << Bandwidth.TriadGBPerSecond
+			 << " GB/s, on arrays of " << (Bandwidth.ArraySize >> 20) << " MB" << endl;
+		if (!Counters.GetError().empty())
+			cout << "Performance counters not available: " << Counters.GetError() << endl;
+	}
+
+	std::vector<RooflineMeasurement> Measurements;
+	{
+		BenchmarkReport Report(cout, Settings.Format);
+		BenchmarkImplementations(Settings, [&](const BenchmarkResult &Result, const std::function<void()> &Run) {
+				Report.Add(Result);
+				RooflineMeasurement Measurement;
+				Measurement.Result = Result;
+				BenchmarkTimer Timer;
+				const PerfCounterValues Start = Counters.Read();
+				for (int i = 0; i < Settings.Options.Repetitions; i++)
+					Run();
+				Measurement.Counters = Counters.Read() - Start;
+				Measurement.CountedNs = Timer.GetElapsedNs();
+				Measurements.push_back(Measurement);
+			});
+	}
+	BenchmarkSettings CacheSettings = Settings;
+	CacheSettings.ImageSizes.assign(1, GetCacheResidentImageSize(4));
+	std::map<std::string, double> CacheMegapixelsPerSecond;
+	BenchmarkImplementations(CacheSettings, [&](const BenchmarkResult &Result, const std::function<void()> &) {
+			CacheMegapixelsPerSecond[Result.Implementation] = GetMegapixelsPerSecond(Result);
+		});
+	if (!Table)
+		return 0;
+
+	cout << endl << "Performance counters per pixel" << endl;
+	cout << left << setw(20) << "Implementation" << right << setw(12) << "Size" << setw(12) << "cycles" << setw(8) << "IPC"
+		 << setw(14) << "LLC misses" << setw(12) << "LLC GB/s" << setw(8) << "CPUs" << endl;
+	for (auto MeasurementsPtr = Measurements.begin(); MeasurementsPtr != Measurements.end(); MeasurementsPtr++)
+	{
+		const BenchmarkResult &Result = MeasurementsPtr->Result;
+		const PerfCounterValues &Values = MeasurementsPtr->Counters;
+		const double Pixels = (double)Result.ImageWidth * Result.ImageHeight * Settings.Options.Repetitions;
+		const bool CyclesAvailable = Values.Available[PERF_COUNTER_CYCLES] && (Values.Values[PERF_COUNTER_CYCLES] > 0.0);
+		cout << left << setw(20) << Result.Implementation << right
+			 << setw(12) << (std::to_string((long long)Result.ImageWidth) + "x" + std::to_string((long long)Result.ImageHeight));
+		PrintCounterValue(CyclesAvailable, Values.Values[PERF_COUNTER_CYCLES] / Pixels, 12, 3);
+		PrintCounterValue(CyclesAvailable && Values.Available[PERF_COUNTER_INSTRUCTIONS],
+						  Values.Values[PERF_COUNTER_INSTRUCTIONS] / std::max(Values.Values[PERF_COUNTER_CYCLES], 1.0), 8, 2);
+		PrintCounterValue(Values.Available[PERF_COUNTER_LLC_MISSES], Values.Values[PERF_COUNTER_LLC_MISSES] / Pixels, 14, 4);
+		// every miss brings a 64-byte line from memory, write-backs of the luma image are not counted
+		PrintCounterValue(Values.Available[PERF_COUNTER_LLC_MISSES], Values.Values[PERF_COUNTER_LLC_MISSES] * 64.0 / MeasurementsPtr->CountedNs, 12, 2);
+		PrintCounterValue(Values.Available[PERF_COUNTER_TASK_CLOCK], Values.Values[PERF_COUNTER_TASK_CLOCK] / MeasurementsPtr->CountedNs, 8, 2);
+		cout << endl;
+	}
+
+	cout << endl << "Roofline, memory roof at " << fixed << setprecision(2) << AchievableGBPerSecond << " GB/s" << endl;
+	cout << left << setw(20) << "Implementation" << right << setw(12) << "Size" << setw(10) << "bytes/px" << setw(10) << "GB/s"
+		 << setw(10) << "% STREAM" << setw(12) << "Mpixels/s" << setw(12) << "roof Mpx/s" << setw(10) << "% roof" << setw(10) << "bound" << endl;
+	for (auto MeasurementsPtr = Measurements.begin(); MeasurementsPtr != Measurements.end(); MeasurementsPtr++)
+	{
+		const BenchmarkResult &Result = MeasurementsPtr->Result;
+		RooflinePoint Point;
+		Point.BytesPerPixel = Result.BytesPerRun / ((double)Result.ImageWidth * Result.ImageHeight);
+		Point.MegapixelsPerSecond = GetMegapixelsPerSecond(Result);
+		Point.CacheMegapixelsPerSecond = CacheMegapixelsPerSecond[Result.Implementation];
+		Point.LastLevelCacheResident = IsLastLevelCacheResident(Result.BytesPerRun);
+		const double RoofMegapixelsPerSecond = GetRooflineMegapixelsPerSecond(Point, AchievableGBPerSecond);
+		cout << left << setw(20) << Result.Implementation << right
+			 << setw(12) << (std::to_string((long long)Result.ImageWidth) + "x" + std::to_string((long long)Result.ImageHeight))
+			 << fixed << setprecision(1) << setw(10) << Point.BytesPerPixel << setprecision(2) << setw(10) << GetGBPerSecond(Result)
+			 << setprecision(1) << setw(10) << GetGBPerSecond(Result) / AchievableGBPerSecond * 100.0
+			 << setw(12) << Point.MegapixelsPerSecond << setw(12) << RoofMegapixelsPerSecond
+			 << setw(10) << Point.MegapixelsPerSecond / RoofMegapixelsPerSecond * 100.0
+			 << setw(10) << (Point.LastLevelCacheResident ? "cache" : (IsMemoryBound(Point, AchievableGBPerSecond) ? "memory" : "compute")) << endl;
+	}
 	return 0;
 }
+
+// PrintLatencyHistogram
+// one bucket per power of 2 microseconds, from the one of the fastest frame to the one of the slowest
+
+static void PrintLatencyHistogram(const std::vector<double> &SortedLatenciesNs)
+{
+	const int BAR_WIDTH = 50;
+
+	if (SortedLatenciesNs.empty())
+		return;
+	const int FirstBucket = std::max((int)floor(log2(std::max(SortedLatenciesNs.front() / 1e3, 1.0))), 0);
+	const int LastBucket = std::max((int)floor(log2(std::max(SortedLatenciesNs.back() / 1e3, 1.0))), 0);
+	std::vector<int> Counts(LastBucket - FirstBucket + 1, 0);
+	for (auto LatencyPtr = SortedLatenciesNs.begin(); LatencyPtr != SortedLatenciesNs.end(); LatencyPtr++)
+		Counts[std::max((int)floor(log2(std::max(*LatencyPtr / 1e3, 1.0))), 0) - FirstBucket]++;
+	const int MaxCount = *std::max_element(Counts.begin(), Counts.end());
+	for (int i = 0; i < (int)Counts.size(); i++)
+	{
+		const long long Low = (i + FirstBucket == 0) ? 0 : (1LL << (i + FirstBucket));
+		cout << right << setw(24) << (std::to_string(Low) + " - " + std::to_string(1LL << (i + FirstBucket + 1)) + " us") << setw(8) << Counts[i]
+			 << " " << std::string((size_t)(Counts[i] * BAR_WIDTH + MaxCount - 1) / MaxCount, '#') << endl;
+	}
+}
+
+// RunRealTimeMode
+// TBBDemo --realtime [--fps <frames/s>] [--frames <count>] [--ring <frames>] [--concurrency <frames>] [--sizes <width>x<height>,...] [--format table|csv|json]
+// feeds RGBA frames at a fixed rate to a flow graph that converts them with the TBB SIMD kernel and reports the
+// latency from arrival to end of conversion of each frame: frames that wait too long in the ring are dropped, so a
+// kernel too slow for the frame rate shows up as dropped frames and a latency bound by the depth of the ring
+// the table format ends with the histogram of the latencies of each size
+
+static int RunRealTimeMode(int argc, _TCHAR* argv[])
+{
+	RealTimeOptions Options = GetDefaultRealTimeOptions();
+	std::vector<std::pair<int, int> > RealTimeSizes;
+	RealTimeSizes.push_back(std::make_pair(Options.ImageWidth, Options.ImageHeight));
+	int FirstOption = 2;
+	bool ValidOptions = true;
+	while ((FirstOption + 1 < argc) && ValidOptions)
+	{
+		const std::string Value = ToString(argv[FirstOption + 1]);
+		if (_tcscmp(argv[FirstOption], _T("--fps")) == 0)
+			Options.FramesPerSecond = atof(Value.c_str());
+		else if (_tcscmp(argv[FirstOption], _T("--frames")) == 0)
+			Options.FrameCount = atoi(Value.c_str());
+		else if (_tcscmp(argv[FirstOption], _T("--ring")) == 0)
+			Options.RingCapacity = atoi(Value.c_str());
+		else if (_tcscmp(argv[FirstOption], _T("--concurrency")) == 0)
+			Options.Concurrency = atoi(Value.c_str());
+		else
+			break;
+		ValidOptions = (Options.FramesPerSecond > 0.0) && (Options.FrameCount > 0) && (Options.RingCapacity > 0) && (Options.Concurrency > 0);
+		FirstOption += 2;
+	}
+	BenchmarkSettings Settings;
+	if (!ValidOptions || !ParseBenchmarkSettings(argc - (FirstOption - 1), argv + (FirstOption - 1), false, Settings, &RealTimeSizes) ||
+		!Settings.ImplementationFilters.empty())
+	{
+		cout << "Usage: TBBDemo --realtime [--fps <frames/s>] [--frames <count>] [--ring <frames>] [--concurrency <frames>]" << endl;
+		cout << "                          [--sizes <width>x<height>,...] [--format table|csv|json]" << endl;
+		return 1;
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+	{
+		PrintBanner();
+		cout << "Real-time conversion at " << fixed << setprecision(1) << Options.FramesPerSecond << " frames/s, ring of "
+			 << Options.RingCapacity << " frames, " << Options.Concurrency << " frames in conversion" << endl;
+		cout << left << setw(12) << "Size" << right << setw(10) << "produced" << setw(10) << "converted" << setw(10) << "dropped"
+			 << setw(12) << "p50 us" << setw(12) << "p99 us" << setw(12) << "p99.9 us" << setw(12) << "max us" << endl;
+	}
+	else if (Settings.Format == BENCHMARK_FORMAT_CSV)
+		cout << "width,height,fps,produced,converted,dropped,p50_us,p99_us,p999_us,max_us" << endl;
+	else
+		cout << "[";
+
+	int ExitCode = 0;
+	for (size_t i = 0; i < Settings.ImageSizes.size(); i++)
+	{
+		Options.ImageWidth = Settings.ImageSizes[i].first;
+		Options.ImageHeight = Settings.ImageSizes[i].second;
+		RealTimeStatistics Statistics;
+		if (!RunRealTimeConversion(Options, Statistics))
+		{
+			cerr << "Cannot allocate the frames of " << Options.ImageWidth << "x" << Options.ImageHeight << endl;
+			ExitCode = 1;
+			continue;
+		}
+		std::vector<double> SortedLatenciesNs(Statistics.LatenciesNs);
+		std::sort(SortedLatenciesNs.begin(), SortedLatenciesNs.end());
+		const double P50Us = GetPercentile(SortedLatenciesNs, 50.0) / 1e3;
+		const double P99Us = GetPercentile(SortedLatenciesNs, 99.0) / 1e3;
+		const double P999Us = GetPercentile(SortedLatenciesNs, 99.9) / 1e3;
+		const double MaxUs = GetPercentile(SortedLatenciesNs, 100.0) / 1e3;
+		if (Settings.Format == BENCHMARK_FORMAT_TABLE)
+		{
+			cout << left << setw(12) << (std::to_string((long long)Options.ImageWidth) + "x" + std::to_string((long long)Options.ImageHeight))
+				 << right << setw(10) << Statistics.FramesProduced << setw(10) << Statistics.FramesConverted << setw(10) << Statistics.FramesDropped
+				 << fixed << setprecision(1) << setw(12) << P50Us << setw(12) << P99Us << setw(12) << P999Us << setw(12) << MaxUs << endl;
+			PrintLatencyHistogram(SortedLatenciesNs);
+		}
+		else if (Settings.Format == BENCHMARK_FORMAT_CSV)
+		{
+			cout << Options.ImageWidth << "," << Options.ImageHeight << "," << Options.FramesPerSecond << "," << Statistics.FramesProduced << ","
+				 << Statistics.FramesConverted << "," << Statistics.FramesDropped << "," << P50Us << "," << P99Us << "," << P999Us << "," << MaxUs << endl;
+		}
+		else
+		{
+			cout << ((i > 0) ? ",\n  {" : "\n  {") << "\"width\": " << Options.ImageWidth << ", \"height\": " << Options.ImageHeight
+				 << ", \"fps\": " << Options.FramesPerSecond << ", \"produced\": " << Statistics.FramesProduced
+				 << ", \"converted\": " << Statistics.FramesConverted << ", \"dropped\": " << Statistics.FramesDropped
+				 << ", \"p50_us\": " << P50Us << ", \"p99_us\": " << P99Us << ", \"p999_us\": " << P999Us << ", \"max_us\": " << MaxUs << "}";
+		}
+	}
+	if (Settings.Format == BENCHMARK_FORMAT_JSON)
+		cout << endl << "]" << endl;
+	return ExitCode;
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--pipeline")) == 0))
+	{
+		PrintBanner();
+		return RunPipelineMode(argc, argv);
+	}
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--convert")) == 0))
+	{
+		PrintBanner();
+		return RunConvertMode(argc, argv);
+	}
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--sweep")) == 0))
+		return RunSweepMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--numa")) == 0))
+		return RunNUMAMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--allocation")) == 0))
+		return RunAllocationMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--statistics")) == 0))
+		return RunStatisticsMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--yuv")) == 0))
+		return RunYUVMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--highbitdepth")) == 0))
+		return RunHighBitDepthMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--batch")) == 0))
+		return RunBatchMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--async")) == 0))
+		return RunAsyncMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--tiling")) == 0))
+		return RunTilingMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--incremental")) == 0))
+		return RunIncrementalMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--tune")) == 0))
+		return RunTuneMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--verify")) == 0))
+		return RunVerifyMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--exhaustive")) == 0))
+		return RunExhaustiveMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--regression")) == 0))
+		return RunRegressionMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--roofline")) == 0))
+		return RunRooflineMode(argc, argv);
+	if ((argc >= 2) && (_tcscmp(argv[1], _T("--realtime")) == 0))
+		return RunRealTimeMode(argc, argv);
+
+	int ExitCode = RunBenchmarkMode(argc, argv);
+	// when started without arguments, as from Explorer, wait for user to enter a key before closing
+	if (argc == 1)
+	{
+		char WaitForUser;
+		cin >> WaitForUser;
+	}
+	return ExitCode;
+}
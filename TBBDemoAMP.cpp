@@ -8,6 +8,10 @@
 // -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
 // -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
 
+#include "TBBDemoAMP.h"
+
+#if defined(HAS_CPP_AMP)
+
 #include <iostream>
 using namespace std;
 #include <amp.h>
@@ -66,4 +70,6 @@ void ProcessRGBAMP(void *SourceImage, void *YImage, int ImageWidth, int ImageHei
 	});
 
 	YImageView.synchronize();
-}
\ No newline at end of file
+}
+
+#endif
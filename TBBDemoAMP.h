@@ -8,4 +8,13 @@
 // -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
 // -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
 
-void ProcessRGBAMP(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
\ No newline at end of file
+#pragma once
+
+// C++ AMP is available only with Visual C++ on Windows, and was deprecated in Visual Studio 2022
+#if defined(_WIN32) && defined(_MSC_VER) && !defined(__clang__)
+#define HAS_CPP_AMP 1
+#endif
+
+#if defined(HAS_CPP_AMP)
+void ProcessRGBAMP(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+#endif
@@ -0,0 +1,169 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+// AVX2 specialization of LumaKernel, see TBBDemoSSSE3.cpp
+
+#include "TBBDemoCPU.h"
+#include "TBBDemoKernel.h"
+#include "TBBDemoKernelInstances.h"
+
+#include <algorithm>
+
+// SIMD intrinsics
+#include <immintrin.h>
+
+// AVX2Constants
+// same as SSSE3Constants, with the shuffle mask repeated in both 128-bit lanes
+
+template <class Layout, class Scales>
+struct AVX2Constants {
+	__m256i ShuffleMask;
+	__m256i EvenScale;
+	__m256i OddScale;
+	__m256i ByteScale;
+	__m256i ShiftScalingAdjust;
+
+	TARGET_AVX2 AVX2Constants()
+	{
+		const KernelConstants<Layout, Scales> Values;
+		ShuffleMask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Values.LaneShuffleMask));
+		EvenScale = _mm256_set1_epi32(Values.EvenScale);
+		OddScale = _mm256_set1_epi32(Values.OddScale);
+		ByteScale = _mm256_set1_epi32(Values.ByteScale);
+		ShiftScalingAdjust = _mm256_set1_epi32(Scales::Rounding);
+	}
+};
+
+// ConvertPixelsAVX2
+// computes the luma of 8 pixels of 4 bytes each, see ConvertPixelsSSSE3
+
+template <class Layout, class Scales>
+static inline TARGET_AVX2 __m256i ConvertPixelsAVX2(__m256i RGBValue, const AVX2Constants<Layout, Scales> &Constants)
+{
+	__m256i YValue;
+	if (Scales::Reduced)
+	{
+		YValue = _mm256_madd_epi16(_mm256_maddubs_epi16(RGBValue, Constants.ByteScale), _mm256_set1_epi16(1));
+	}
+	else
+	{
+		__m256i EvenValue = _mm256_and_si256(RGBValue, _mm256_set1_epi32(0x00FF00FF));
+		__m256i OddValue = _mm256_srli_epi16(RGBValue, 8);
+		// int YValue = (SourceImagePtr[0] * Y_RED_SCALE  ) +
+		//			 (SourceImagePtr[1] * Y_GREEN_SCALE) +
+		//			 (SourceImagePtr[2] * Y_BLUE_SCALE );
+		YValue = _mm256_add_epi32(_mm256_madd_epi16(EvenValue, Constants.EvenScale), _mm256_madd_epi16(OddValue, Constants.OddScale));
+	}
+	// YValue += 1 << (SCALING_LOG - 1);
+	YValue = _mm256_add_epi32(YValue, Constants.ShiftScalingAdjust);
+	// YValue >>= SCALING_LOG;
+	return _mm256_srli_epi32(YValue, Scales::ScalingLog);
+}
+
+// Load8PixelsAVX2
+// loads 8 pixels, one per 32-bit element
+// 24-bit pixels are loaded with the first 4 in the low 128-bit lane and the other 4 in the high lane, so that the
+// in-lane _mm256_shuffle_epi8 can spread them; each 128-bit load reads 4 bytes past the 12 it uses
+// ALIGNED_LOADS applies only to 32-bit pixels, the loads of 24-bit ones fall at multiples of 12 bytes
+
+template <class Layout, class Scales, bool ALIGNED_LOADS>
+static inline TARGET_AVX2 __m256i Load8PixelsAVX2(const unsigned char *SourceImagePtr, const AVX2Constants<Layout, Scales> &Constants)
+{
+	if (Layout::PixelSize == 4)
+	{
+		__m256i RGBValue = ALIGNED_LOADS ? _mm256_load_si256((const __m256i *)SourceImagePtr) : _mm256_loadu_si256((const __m256i *)SourceImagePtr);
+		return Scales::SplitGreen ? _mm256_shuffle_epi8(RGBValue, Constants.ShuffleMask) : RGBValue;
+	}
+	__m256i RGBValue = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)SourceImagePtr));
+	RGBValue = _mm256_inserti128_si256(RGBValue, _mm_loadu_si128((const __m128i *)(SourceImagePtr + 12)), 1);
+	return _mm256_shuffle_epi8(RGBValue, Constants.ShuffleMask);
+}
+
+// PackYValuesAVX2
+// packs 4 registers of 8 luma values stored as 32-bit integers into 32 bytes, preserving their order
+// pack instructions work on each 128-bit lane separately, so the final permutation puts the 4-byte groups back in place
+
+static inline TARGET_AVX2 __m256i PackYValuesAVX2(__m256i YValue0, __m256i YValue1, __m256i YValue2, __m256i YValue3)
+{
+	__m256i YValue01 = _mm256_packs_epi32(YValue0, YValue1);
+	__m256i YValue23 = _mm256_packs_epi32(YValue2, YValue3);
+	// if (YValue > 255)
+	//	YValue = 255;
+	__m256i YValue = _mm256_packus_epi16(YValue01, YValue23);
+	return _mm256_permutevar8x32_epi32(YValue, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+// ConvertPixelsLoopAVX2
+// 32 pixels per loop, the remaining ones are processed by the scalar kernel
+// with 24-bit pixels the last load of each loop reads 4 bytes past the 96 bytes of the 32 pixels, so the loop stops
+// 2 pixels earlier than needed to stay inside the image
+
+template <class Layout, class Scales, bool NON_TEMPORAL, bool ALIGNED_LOADS>
+static inline TARGET_AVX2 void ConvertPixelsLoopAVX2(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	const AVX2Constants<Layout, Scales> Constants;
+	const int ReadAhead = (Layout::PixelSize == 3) ? 2 : 0;
+
+	int i = PixelCount;
+	for (; i >= 32 + ReadAhead; i -= 32)  // 32 pixels per loop
+	{
+		__m256i YValue0 = ConvertPixelsAVX2(Load8PixelsAVX2<Layout, Scales, ALIGNED_LOADS>(SourceImagePtr + 0 * Layout::PixelSize, Constants), Constants);
+		__m256i YValue1 = ConvertPixelsAVX2(Load8PixelsAVX2<Layout, Scales, ALIGNED_LOADS>(SourceImagePtr + 8 * Layout::PixelSize, Constants), Constants);
+		__m256i YValue2 = ConvertPixelsAVX2(Load8PixelsAVX2<Layout, Scales, ALIGNED_LOADS>(SourceImagePtr + 16 * Layout::PixelSize, Constants), Constants);
+		__m256i YValue3 = ConvertPixelsAVX2(Load8PixelsAVX2<Layout, Scales, ALIGNED_LOADS>(SourceImagePtr + 24 * Layout::PixelSize, Constants), Constants);
+		SourceImagePtr += 32 * Layout::PixelSize;
+		if (NON_TEMPORAL)
+			_mm256_stream_si256((__m256i *)YImagePtr, PackYValuesAVX2(YValue0, YValue1, YValue2, YValue3));
+		else
+			_mm256_storeu_si256((__m256i *)YImagePtr, PackYValuesAVX2(YValue0, YValue1, YValue2, YValue3));
+		YImagePtr += 32;
+	}
+	if (NON_TEMPORAL)
+		_mm_sfence();
+	LumaKernel<Layout, Scales, ISAScalar>::Process(SourceImagePtr, YImagePtr, i);
+}
+
+// AlignAndConvertPixelsAVX2
+// selects the loop for the alignment of the images
+// does not assume that the input image is aligned on 32 bytes, when it is and pixels have 4 bytes the loads are
+// aligned too; with non-temporal stores the luma plane is aligned by converting the first pixels with the scalar kernel
+
+template <class Layout, class Scales, bool NON_TEMPORAL>
+static inline TARGET_AVX2 void AlignAndConvertPixelsAVX2(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	if (NON_TEMPORAL)
+	{
+		int HeadCount = std::min((int)((32 - ((size_t)YImagePtr & 31)) & 31), PixelCount);
+		LumaKernel<Layout, Scales, ISAScalar>::Process(SourceImagePtr, YImagePtr, HeadCount);
+		SourceImagePtr += HeadCount * Layout::PixelSize;
+		YImagePtr += HeadCount;
+		PixelCount -= HeadCount;
+	}
+	if ((Layout::PixelSize == 4) && (((size_t)SourceImagePtr & 31) == 0))
+		ConvertPixelsLoopAVX2<Layout, Scales, NON_TEMPORAL, true>(SourceImagePtr, YImagePtr, PixelCount);
+	else
+		ConvertPixelsLoopAVX2<Layout, Scales, NON_TEMPORAL, false>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+// LumaKernel<Layout, Scales, ISAAVX2>::Process
+
+template <class Layout, class Scales>
+TARGET_AVX2 void LumaKernel<Layout, Scales, ISAAVX2>::Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	AlignAndConvertPixelsAVX2<Layout, Scales, false>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+template <class Layout, class Scales>
+TARGET_AVX2 void LumaKernel<Layout, Scales, ISAAVX2>::ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	AlignAndConvertPixelsAVX2<Layout, Scales, true>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+INSTANTIATE_LUMA_KERNELS(ISAAVX2)
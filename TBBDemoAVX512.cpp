@@ -0,0 +1,178 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+// AVX-512BW specialization of LumaKernel, see TBBDemoSSSE3.cpp
+
+#include "TBBDemoCPU.h"
+#include "TBBDemoKernel.h"
+#include "TBBDemoKernelInstances.h"
+
+#include <algorithm>
+
+// SIMD intrinsics
+#include <immintrin.h>
+
+#if defined(HAS_AVX512_INTRINSICS)
+
+// AVX512Constants
+// same as SSSE3Constants, with the shuffle mask repeated in all 128-bit lanes
+
+template <class Layout, class Scales>
+struct AVX512Constants {
+	__m512i ShuffleMask;
+	__m512i EvenScale;
+	__m512i OddScale;
+	__m512i ByteScale;
+	__m512i ShiftScalingAdjust;
+
+	TARGET_AVX512 AVX512Constants()
+	{
+		const KernelConstants<Layout, Scales> Values;
+		ShuffleMask = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)Values.LaneShuffleMask));
+		EvenScale = _mm512_set1_epi32(Values.EvenScale);
+		OddScale = _mm512_set1_epi32(Values.OddScale);
+		ByteScale = _mm512_set1_epi32(Values.ByteScale);
+		ShiftScalingAdjust = _mm512_set1_epi32(Scales::Rounding);
+	}
+};
+
+// ConvertPixelsAVX512
+// computes the luma of 16 pixels of 4 bytes each and packs them in 16 bytes, see ConvertPixelsSSSE3
+// the saturating down-conversion _mm512_cvtusepi32_epi8 replaces the pack instructions, so no lane shuffling is needed
+
+template <class Layout, class Scales>
+static inline TARGET_AVX512 __m128i ConvertPixelsAVX512(__m512i RGBValue, const AVX512Constants<Layout, Scales> &Constants)
+{
+	__m512i YValue;
+	if (Scales::Reduced)
+	{
+		YValue = _mm512_madd_epi16(_mm512_maddubs_epi16(RGBValue, Constants.ByteScale), _mm512_set1_epi16(1));
+	}
+	else
+	{
+		__m512i EvenValue = _mm512_and_si512(RGBValue, _mm512_set1_epi32(0x00FF00FF));
+		__m512i OddValue = _mm512_srli_epi16(RGBValue, 8);
+		YValue = _mm512_add_epi32(_mm512_madd_epi16(EvenValue, Constants.EvenScale), _mm512_madd_epi16(OddValue, Constants.OddScale));
+	}
+	// YValue += 1 << (SCALING_LOG - 1);
+	YValue = _mm512_add_epi32(YValue, Constants.ShiftScalingAdjust);
+	// YValue >>= SCALING_LOG;
+	YValue = _mm512_srli_epi32(YValue, Scales::ScalingLog);
+	// if (YValue > 255)
+	//	YValue = 255;
+	return _mm512_cvtusepi32_epi8(YValue);
+}
+
+// Load16PixelsAVX512
+// loads 16 pixels, one per 32-bit element
+// 24-bit pixels are loaded 4 per 128-bit lane and spread by the in-lane _mm512_shuffle_epi8, the last 128-bit load
+// reads 4 bytes past the 48 bytes of the 16 pixels
+// ALIGNED_LOADS applies only to 32-bit pixels, see Load8PixelsAVX2
+
+template <class Layout, class Scales, bool ALIGNED_LOADS>
+static inline TARGET_AVX512 __m512i Load16PixelsAVX512(const unsigned char *SourceImagePtr, const AVX512Constants<Layout, Scales> &Constants)
+{
+	if (Layout::PixelSize == 4)
+	{
+		__m512i RGBValue = ALIGNED_LOADS ? _mm512_load_si512(SourceImagePtr) : _mm512_loadu_si512(SourceImagePtr);
+		return Scales::SplitGreen ? _mm512_shuffle_epi8(RGBValue, Constants.ShuffleMask) : RGBValue;
+	}
+	__m512i RGBValue = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)SourceImagePtr));
+	RGBValue = _mm512_inserti32x4(RGBValue, _mm_loadu_si128((const __m128i *)(SourceImagePtr + 12)), 1);
+	RGBValue = _mm512_inserti32x4(RGBValue, _mm_loadu_si128((const __m128i *)(SourceImagePtr + 24)), 2);
+	RGBValue = _mm512_inserti32x4(RGBValue, _mm_loadu_si128((const __m128i *)(SourceImagePtr + 36)), 3);
+	return _mm512_shuffle_epi8(RGBValue, Constants.ShuffleMask);
+}
+
+// ConvertPixelsLoopAVX512
+// 32 pixels per loop, the remaining ones are processed by the AVX2 kernel
+
+template <class Layout, class Scales, bool NON_TEMPORAL, bool ALIGNED_LOADS>
+static inline TARGET_AVX512 void ConvertPixelsLoopAVX512(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	const AVX512Constants<Layout, Scales> Constants;
+	const int ReadAhead = (Layout::PixelSize == 3) ? 2 : 0;
+
+	int i = PixelCount;
+	for (; i >= 32 + ReadAhead; i -= 32)  // 32 pixels per loop
+	{
+		__m128i YValue0 = ConvertPixelsAVX512(Load16PixelsAVX512<Layout, Scales, ALIGNED_LOADS>(SourceImagePtr, Constants), Constants);
+		__m128i YValue1 = ConvertPixelsAVX512(Load16PixelsAVX512<Layout, Scales, ALIGNED_LOADS>(SourceImagePtr + 16 * Layout::PixelSize, Constants), Constants);
+		SourceImagePtr += 32 * Layout::PixelSize;
+		if (NON_TEMPORAL)
+		{
+			_mm256_stream_si256((__m256i *)YImagePtr, _mm256_inserti128_si256(_mm256_castsi128_si256(YValue0), YValue1, 1));
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i *)YImagePtr, YValue0);
+			_mm_storeu_si128((__m128i *)YImagePtr + 1, YValue1);
+		}
+		YImagePtr += 32;
+	}
+	if (NON_TEMPORAL)
+		_mm_sfence();
+	LumaKernel<Layout, Scales, ISAAVX2>::Process(SourceImagePtr, YImagePtr, i);
+}
+
+// AlignAndConvertPixelsAVX512
+// selects the loop for the alignment of the images, the loads are aligned when the input image is aligned on
+// 64 bytes, with non-temporal stores the luma plane is first aligned on 32 bytes by the scalar kernel
+
+template <class Layout, class Scales, bool NON_TEMPORAL>
+static inline TARGET_AVX512 void AlignAndConvertPixelsAVX512(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	if (NON_TEMPORAL)
+	{
+		int HeadCount = std::min((int)((32 - ((size_t)YImagePtr & 31)) & 31), PixelCount);
+		LumaKernel<Layout, Scales, ISAScalar>::Process(SourceImagePtr, YImagePtr, HeadCount);
+		SourceImagePtr += HeadCount * Layout::PixelSize;
+		YImagePtr += HeadCount;
+		PixelCount -= HeadCount;
+	}
+	if ((Layout::PixelSize == 4) && (((size_t)SourceImagePtr & 63) == 0))
+		ConvertPixelsLoopAVX512<Layout, Scales, NON_TEMPORAL, true>(SourceImagePtr, YImagePtr, PixelCount);
+	else
+		ConvertPixelsLoopAVX512<Layout, Scales, NON_TEMPORAL, false>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+// LumaKernel<Layout, Scales, ISAAVX512>::Process
+
+template <class Layout, class Scales>
+TARGET_AVX512 void LumaKernel<Layout, Scales, ISAAVX512>::Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	AlignAndConvertPixelsAVX512<Layout, Scales, false>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+template <class Layout, class Scales>
+TARGET_AVX512 void LumaKernel<Layout, Scales, ISAAVX512>::ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	AlignAndConvertPixelsAVX512<Layout, Scales, true>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+#else
+
+// without AVX-512 intrinsics GetCPUFeatures never reports AVX512BW, the AVX2 kernel is used only to satisfy the linker
+
+template <class Layout, class Scales>
+void LumaKernel<Layout, Scales, ISAAVX512>::Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	LumaKernel<Layout, Scales, ISAAVX2>::Process(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+template <class Layout, class Scales>
+void LumaKernel<Layout, Scales, ISAAVX512>::ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	LumaKernel<Layout, Scales, ISAAVX2>::ProcessNonTemporal(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+#endif
+
+INSTANTIATE_LUMA_KERNELS(ISAAVX512)
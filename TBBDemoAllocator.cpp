@@ -0,0 +1,170 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoAllocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(_WIN32)
+
+// AllocateImageMemory
+// large pages need the "Lock pages in memory" privilege, without it VirtualAlloc fails and regular pages are used,
+// which VirtualAlloc aligns on 64 KB anyway
+
+void *AllocateImageMemory(size_t Size, ImageMemory Memory)
+{
+	if (Size == 0)
+		return 0;
+	if (Memory == IMAGE_MEMORY_ALIGNED)
+		return _aligned_malloc(Size, IMAGE_ALIGNMENT);
+	size_t LargePageSize = GetLargePageMinimum();
+	if (LargePageSize > 0)
+	{
+		size_t LargeSize = (Size + LargePageSize - 1) / LargePageSize * LargePageSize;
+		void *Buffer = VirtualAlloc(0, LargeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (Buffer != 0)
+			return Buffer;
+	}
+	return VirtualAlloc(0, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void FreeImageMemory(void *Buffer, size_t Size, ImageMemory Memory)
+{
+	if (Buffer == 0)
+		return;
+	if (Memory == IMAGE_MEMORY_ALIGNED)
+		_aligned_free(Buffer);
+	else
+		VirtualFree(Buffer, 0, MEM_RELEASE);
+}
+
+#else
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// AllocateImageMemory
+// explicit huge pages (MAP_HUGETLB) exist only if the administrator has reserved them, otherwise the mapping is
+// aligned on a huge page boundary and marked with MADV_HUGEPAGE, so that transparent huge pages can back it
+
+void *AllocateImageMemory(size_t Size, ImageMemory Memory)
+{
+	if (Size == 0)
+		return 0;
+	if (Memory == IMAGE_MEMORY_ALIGNED)
+	{
+		void *Buffer = 0;
+		if (posix_memalign(&Buffer, IMAGE_ALIGNMENT, Size) != 0)
+			return 0;
+		return Buffer;
+	}
+	size_t HugeSize = (Size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#if defined(MAP_HUGETLB)
+	void *Buffer = mmap(0, HugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (Buffer != MAP_FAILED)
+		return Buffer;
+#endif
+	// map one huge page more than needed and unmap the parts before and after the aligned range
+	unsigned char *Mapping = (unsigned char *)mmap(0, HugeSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (Mapping == (unsigned char *)MAP_FAILED)
+		return 0;
+	unsigned char *AlignedBuffer = (unsigned char *)(((size_t)Mapping + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+	if (AlignedBuffer > Mapping)
+		munmap(Mapping, AlignedBuffer - Mapping);
+	size_t TrailingSize = (Mapping + HugeSize + HUGE_PAGE_SIZE) - (AlignedBuffer + HugeSize);
+	if (TrailingSize > 0)
+		munmap(AlignedBuffer + HugeSize, TrailingSize);
+#if defined(MADV_HUGEPAGE)
+	madvise(AlignedBuffer, HugeSize, MADV_HUGEPAGE);
+#endif
+	return AlignedBuffer;
+}
+
+void FreeImageMemory(void *Buffer, size_t Size, ImageMemory Memory)
+{
+	if (Buffer == 0)
+		return;
+	if (Memory == IMAGE_MEMORY_ALIGNED)
+		free(Buffer);
+	else
+		munmap(Buffer, (Size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+}
+
+#endif
+
+ImageBufferPool::ImageBufferPool(ImageMemory Memory) : Memory(Memory)
+{
+}
+
+ImageBufferPool::~ImageBufferPool()
+{
+	for (size_t i = 0; i < Buffers.size(); i++)
+		FreeImageMemory(Buffers[i].Data, Buffers[i].Size, Memory);
+}
+
+// ImageBufferPool::Acquire
+// the new buffer is touched outside the lock, writing one byte per 4 KB is enough to fault in every page
+
+unsigned char *ImageBufferPool::Acquire(size_t Size)
+{
+	const size_t PAGE_SIZE = 4096;
+
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		int BestBuffer = -1;
+		for (size_t i = 0; i < Buffers.size(); i++)
+			if (!Buffers[i].InUse && (Buffers[i].Size >= Size) && ((BestBuffer < 0) || (Buffers[i].Size < Buffers[BestBuffer].Size)))
+				BestBuffer = (int)i;
+		if (BestBuffer >= 0)
+		{
+			Buffers[BestBuffer].InUse = true;
+			return Buffers[BestBuffer].Data;
+		}
+	}
+
+	unsigned char *Data = (unsigned char *)AllocateImageMemory(Size, Memory);
+	if (Data == 0)
+		return 0;
+	for (size_t Offset = 0; Offset < Size; Offset += PAGE_SIZE)
+		Data[Offset] = 0;
+	PooledBuffer Buffer = { Data, Size, true };
+	std::lock_guard<std::mutex> Lock(Mutex);
+	Buffers.push_back(Buffer);
+	return Data;
+}
+
+void ImageBufferPool::Release(unsigned char *Buffer)
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+	for (size_t i = 0; i < Buffers.size(); i++)
+		if (Buffers[i].Data == Buffer)
+		{
+			Buffers[i].InUse = false;
+			return;
+		}
+}
+
+void ImageBufferPool::Trim()
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+	for (size_t i = Buffers.size(); i > 0; i--)
+		if (!Buffers[i - 1].InUse)
+		{
+			FreeImageMemory(Buffers[i - 1].Data, Buffers[i - 1].Size, Memory);
+			Buffers.erase(Buffers.begin() + (i - 1));
+		}
+}
@@ -0,0 +1,62 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+
+// image buffers
+// buffers are aligned on IMAGE_ALIGNMENT bytes, so that the SIMD kernels can use aligned loads and no load crosses a
+// cache line; with huge pages a 256 MB image needs 128 TLB entries instead of 65536, and as many page faults
+
+const size_t IMAGE_ALIGNMENT = 64;
+
+enum ImageMemory {
+	IMAGE_MEMORY_ALIGNED,			//< regular pages, aligned on IMAGE_ALIGNMENT bytes
+	IMAGE_MEMORY_HUGE_PAGES			//< explicit huge pages when available, otherwise transparent ones or regular pages
+};
+
+// returns 0 if the memory cannot be allocated, the same Size and Memory must be passed to FreeImageMemory
+void *AllocateImageMemory(size_t Size, ImageMemory Memory);
+void FreeImageMemory(void *Buffer, size_t Size, ImageMemory Memory);
+
+// ImageBufferPool
+// keeps released buffers for later requests, so that converting a sequence of images of the same size allocates and
+// faults in memory only for the first one; new buffers are touched before being returned, so the page faults are paid
+// by Acquire rather than by the first conversion; thread-safe
+
+class ImageBufferPool {
+public:
+	explicit ImageBufferPool(ImageMemory Memory);
+	~ImageBufferPool();
+
+	// the smallest free buffer of at least Size bytes, or a new one; 0 if the memory cannot be allocated
+	unsigned char *Acquire(size_t Size);
+	void Release(unsigned char *Buffer);
+	// frees the buffers that are not in use
+	void Trim();
+
+private:
+	ImageBufferPool(const ImageBufferPool &);
+	ImageBufferPool &operator=(const ImageBufferPool &);
+
+	struct PooledBuffer {
+		unsigned char *Data;
+		size_t Size;
+		bool InUse;
+	};
+
+	ImageMemory Memory;
+	std::vector<PooledBuffer> Buffers;
+	std::mutex Mutex;
+};
@@ -0,0 +1,208 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoAsync.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits.h>
+#include <mutex>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range2d.h>
+#include <partitioner.h>
+#include <task_arena.h>
+#include <task_group.h>
+using namespace tbb;
+
+// pixels of the largest tile, cancellation takes effect at tile boundaries, so this bounds the work done after
+// Cancel to one tile per thread, a few tens of microseconds
+const int ASYNC_TILE_PIXELS = 64 * 1024;
+// tile widths are multiples of the block of the AVX2 kernels, so that only the last tile of a row has a tail
+const int ASYNC_PIXEL_BLOCK = 32;
+
+// ConversionState
+// shared by the handle and the task that converts the image, so that either can outlive the other
+
+struct ConversionState {
+	ImageDescriptor Source;
+	ImageDescriptor YImage;
+	LumaFunction Kernel;
+	long long TotalPixels;
+	std::atomic<long long> ConvertedPixels;
+	task_group_context Context;
+	std::mutex Mutex;
+	std::condition_variable Finished;
+	ConversionStatus Status;		//< guarded by Mutex
+	std::function<void(ConversionStatus)> Continuation;
+};
+
+// GetAsyncArena
+// arena of the asynchronous conversions, with the default number of threads; tasks enqueued in an arena are
+// guaranteed to run even when the machine has a single core and the scheduler has no worker threads
+
+static task_arena &GetAsyncArena()
+{
+	static task_arena Arena;
+	return Arena;
+}
+
+// FinishConversion
+// publishes the final status, wakes up the waiting threads and runs the continuation outside of the lock, so that
+// it can query the handle
+
+static void FinishConversion(ConversionState &State)
+{
+	ConversionStatus Status = (State.ConvertedPixels.load() == State.TotalPixels) ? CONVERSION_COMPLETED : CONVERSION_CANCELLED;
+	std::function<void(ConversionStatus)> Continuation;
+	{
+		std::lock_guard<std::mutex> Lock(State.Mutex);
+		State.Status = Status;
+		Continuation.swap(State.Continuation);
+	}
+	State.Finished.notify_all();
+	if (Continuation)
+		Continuation(Status);
+}
+
+// RunConversion
+// splits the image in tiles of at most ASYNC_TILE_PIXELS pixels, tightly packed images are processed as a single
+// long row; simple_partitioner keeps the tiles that small even when few threads are available, since with
+// auto_partitioner a single thread would get the whole image in one chunk that cannot be cancelled; images of 2 GB or
+// more keep their rows, so that the row stays addressable with an int
+
+static void RunConversion(ConversionState &State)
+{
+	ImageDescriptor Source = State.Source;
+	ImageDescriptor YImage = State.YImage;
+	if (IsImagePacked(Source) && IsImagePacked(YImage) && ((long long)Source.Stride * Source.Height <= INT_MAX))
+	{
+		Source.Width *= Source.Height;
+		Source.Stride *= Source.Height;
+		Source.Height = 1;
+		YImage.Width = Source.Width;
+		YImage.Stride = Source.Width;
+		YImage.Height = 1;
+	}
+	const int PixelOffset = GetPixelSize(Source.Format);
+	const LumaFunction Kernel = State.Kernel;
+	const int ColumnBlocks = (Source.Width + ASYNC_PIXEL_BLOCK - 1) / ASYNC_PIXEL_BLOCK;
+	const int ColumnGrain = std::max(1, std::min(ColumnBlocks, ASYNC_TILE_PIXELS / ASYNC_PIXEL_BLOCK));
+	const int RowGrain = std::max(1, ASYNC_TILE_PIXELS / (ColumnGrain * ASYNC_PIXEL_BLOCK));
+
+	parallel_for( blocked_range2d<int,int>( 0, Source.Height, RowGrain, 0, ColumnBlocks, ColumnGrain),
+		[&](const blocked_range2d<int,int>& r) {
+			int StartX = r.cols().begin() * ASYNC_PIXEL_BLOCK;
+			int StopX = std::min(r.cols().end() * ASYNC_PIXEL_BLOCK, Source.Width);
+			for (int y = r.rows().begin(); y != r.rows().end(); y++)
+				Kernel(GetImageRow(Source, y) + StartX * PixelOffset, GetImageRow(YImage, y) + StartX, StopX - StartX, 1, PixelOffset);
+			State.ConvertedPixels += (long long)(StopX - StartX) * r.rows().size();
+		},
+		simple_partitioner(), State.Context
+		);
+	FinishConversion(State);
+}
+
+ConversionHandle ConvertToLumaAsync(const ImageDescriptor &Source, const ImageDescriptor &YImage,
+									LumaCoefficients Coefficients, bool ReducedPrecision)
+{
+	ConversionHandle Handle;
+	if (!IsRGB8Format(Source.Format) || (YImage.Format != PIXEL_FORMAT_Y8))
+		return Handle;
+	if ((Source.Width != YImage.Width) || (Source.Height != YImage.Height) || (Source.Width < 0) || (Source.Height < 0))
+		return Handle;
+	const LumaFunction Kernel = GetLumaFunction(Source.Format, Coefficients, ReducedPrecision, LUMA_ISA_BEST, false);
+	if (!Kernel)
+		return Handle;
+
+	Handle.State = std::make_shared<ConversionState>();
+	ConversionState &State = *Handle.State;
+	State.Source = Source;
+	State.YImage = YImage;
+	State.Kernel = Kernel;
+	State.TotalPixels = (long long)Source.Width * Source.Height;
+	State.ConvertedPixels = 0;
+	State.Status = CONVERSION_RUNNING;
+	std::shared_ptr<ConversionState> SharedState = Handle.State;
+	GetAsyncArena().enqueue([SharedState]() { RunConversion(*SharedState); });
+	return Handle;
+}
+
+ConversionHandle &ConversionHandle::operator=(ConversionHandle &&Other)
+{
+	if (this != &Other)
+	{
+		if (State)
+		{
+			Cancel();
+			Wait();
+		}
+		State = std::move(Other.State);
+	}
+	return *this;
+}
+
+ConversionHandle::~ConversionHandle()
+{
+	if (State)
+	{
+		Cancel();
+		Wait();
+	}
+}
+
+ConversionStatus ConversionHandle::GetStatus() const
+{
+	if (!State)
+		return CONVERSION_INVALID;
+	std::lock_guard<std::mutex> Lock(State->Mutex);
+	return State->Status;
+}
+
+double ConversionHandle::GetProgress() const
+{
+	if (!State)
+		return 0.0;
+	return State->TotalPixels ? (double)State->ConvertedPixels.load() / State->TotalPixels : 1.0;
+}
+
+ConversionStatus ConversionHandle::Wait()
+{
+	if (!State)
+		return CONVERSION_INVALID;
+	std::unique_lock<std::mutex> Lock(State->Mutex);
+	State->Finished.wait(Lock, [this]() { return State->Status != CONVERSION_RUNNING; });
+	return State->Status;
+}
+
+void ConversionHandle::Cancel()
+{
+	if (State)
+		State->Context.cancel_group_execution();
+}
+
+void ConversionHandle::SetContinuation(const std::function<void(ConversionStatus)> &Continuation)
+{
+	ConversionStatus Status = CONVERSION_INVALID;
+	if (State)
+	{
+		std::lock_guard<std::mutex> Lock(State->Mutex);
+		Status = State->Status;
+		if (Status == CONVERSION_RUNNING)
+		{
+			State->Continuation = Continuation;
+			return;
+		}
+	}
+	Continuation(Status);
+}
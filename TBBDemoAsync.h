@@ -0,0 +1,67 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+
+#include <functional>
+#include <memory>
+
+enum ConversionStatus {
+	CONVERSION_RUNNING,		//< queued or being converted
+	CONVERSION_COMPLETED,	//< every pixel was converted
+	CONVERSION_CANCELLED,	//< stopped by Cancel, only some of the tiles were converted
+	CONVERSION_INVALID		//< the handle holds no conversion, e.g. the images were rejected by ConvertToLumaAsync
+};
+
+struct ConversionState;
+
+// ConversionHandle
+// result of ConvertToLumaAsync, it can be polled, waited on or given a continuation, and it cancels the conversion
+// when destroyed before it is over, waiting for the tiles in flight so that the images can be released right after
+// Wait blocks the calling thread without helping the conversion, so it must not be called from a task of the
+// conversion arena, e.g. from a continuation
+// the methods of a handle that is not valid report CONVERSION_INVALID and no progress
+class ConversionHandle {
+public:
+	ConversionHandle() {}
+	ConversionHandle(ConversionHandle &&Other) : State(std::move(Other.State)) {}
+	ConversionHandle &operator=(ConversionHandle &&Other);
+	~ConversionHandle();
+
+	bool IsValid() const { return State != nullptr; }
+	ConversionStatus GetStatus() const;
+	// fraction of the pixels converted so far, between 0 and 1
+	double GetProgress() const;
+	ConversionStatus Wait();
+	// the tiles already started are completed, the others are skipped
+	void Cancel();
+	// Continuation is called once with the final status, by the thread that completes the conversion, or right away
+	// by the calling thread when the conversion is already over; it replaces any previous continuation
+	void SetContinuation(const std::function<void(ConversionStatus)> &Continuation);
+
+private:
+	friend ConversionHandle ConvertToLumaAsync(const ImageDescriptor &Source, const ImageDescriptor &YImage,
+											   LumaCoefficients Coefficients, bool ReducedPrecision);
+	ConversionHandle(const ConversionHandle &);
+	ConversionHandle &operator=(const ConversionHandle &);
+
+	std::shared_ptr<ConversionState> State;
+};
+
+// ConvertToLumaAsync
+// queues the conversion of an image in a task arena shared by all the asynchronous conversions and returns at once
+// the images must stay valid until the conversion is over, and must not overlap
+// when the format or the dimensions of the images are not supported nothing is queued and the handle is not valid
+ConversionHandle ConvertToLumaAsync(const ImageDescriptor &Source, const ImageDescriptor &YImage,
+									LumaCoefficients Coefficients = LUMA_BT601, bool ReducedPrecision = false);
@@ -0,0 +1,173 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBDemoBackends.h"
+#include "TBBDemoRoutines.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#if defined(HAS_OPENMP_BACKEND)
+#include <omp.h>
+#endif
+
+// chunks are made of whole blocks, a multiple of the pixels converted by each loop of every SIMD kernel
+const int BACKEND_PIXEL_BLOCK = 64;
+// chunk size of the parallel STL backend, 64 KB of RGBA pixels
+const int PARALLEL_STL_CHUNK_PIXELS = 16384;
+
+// ConvertPart
+// converts the Part-th of PartCount contiguous parts of the image, whose sizes differ by at most one block
+
+static void ConvertPart(unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount, int PixelOffset, int Part, int PartCount)
+{
+	const int Blocks = (PixelCount + BACKEND_PIXEL_BLOCK - 1) / BACKEND_PIXEL_BLOCK;
+	const int StartPixel = (int)((long long)Blocks * Part / PartCount) * BACKEND_PIXEL_BLOCK;
+	const int StopPixel = std::min((int)((long long)Blocks * (Part + 1) / PartCount) * BACKEND_PIXEL_BLOCK, PixelCount);
+	if (StopPixel > StartPixel)
+		ProcessRGBSIMDAuto(SourceImagePtr + StartPixel * PixelOffset, YImagePtr + StartPixel, StopPixel - StartPixel, 1, PixelOffset);
+}
+
+#if defined(HAS_OPENMP_BACKEND)
+
+void ProcessRGBOpenMPSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	const int PartCount = omp_get_max_threads();
+	#pragma omp parallel for schedule(static)
+	for (int Part = 0; Part < PartCount; Part++)
+		ConvertPart((unsigned char *)SourceImage, (unsigned char *)YImage, ImageWidth * ImageHeight, PixelOffset, Part, PartCount);
+}
+
+#endif
+
+#if defined(HAS_PARALLEL_STL_BACKEND)
+
+// ProcessRGBParallelSTLSIMDAuto
+// par_unseq allows the chunks to be interleaved on the same thread, which is safe since the kernel takes no locks
+
+void ProcessRGBParallelSTLSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	const int PixelCount = ImageWidth * ImageHeight;
+	std::vector<int> Chunks((PixelCount + PARALLEL_STL_CHUNK_PIXELS - 1) / PARALLEL_STL_CHUNK_PIXELS);
+	std::iota(Chunks.begin(), Chunks.end(), 0);
+	std::for_each(std::execution::par_unseq, Chunks.begin(), Chunks.end(), [=](int Chunk) {
+			const int StartPixel = Chunk * PARALLEL_STL_CHUNK_PIXELS;
+			const int StopPixel = std::min(StartPixel + PARALLEL_STL_CHUNK_PIXELS, PixelCount);
+			ProcessRGBSIMDAuto((unsigned char *)SourceImage + StartPixel * PixelOffset, (unsigned char *)YImage + StartPixel,
+							   StopPixel - StartPixel, 1, PixelOffset);
+		});
+}
+
+#endif
+
+// StaticThreadPool
+// persistent workers that run the parts of a statically partitioned loop, one loop at a time
+// Run publishes the loop body with a new generation number and wakes the workers, each one runs the part with its
+// own index and the last one to finish wakes the caller; the workers sleep on a condition variable between loops,
+// so the wake-up latency of the operating system is part of the cost of every loop, as with the other runtimes
+// once their threads stop spinning
+
+class StaticThreadPool {
+public:
+	typedef std::function<void(int Part, int PartCount)> PartFunction;
+
+	explicit StaticThreadPool(int ThreadCount) : Body(NULL), Generation(0), PendingParts(0), Stopping(false)
+	{
+		for (int Part = 1; Part < ThreadCount; Part++)
+			Workers.push_back(std::thread(&StaticThreadPool::WorkerLoop, this, Part));
+	}
+
+	~StaticThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Stopping = true;
+		}
+		WorkReady.notify_all();
+		for (size_t i = 0; i < Workers.size(); i++)
+			Workers[i].join();
+	}
+
+	int GetThreadCount() const { return (int)Workers.size() + 1; }
+
+	// calls Function(Part, GetThreadCount()) for every part, part 0 on the calling thread, and returns when all of
+	// them are done
+	void Run(const PartFunction &Function)
+	{
+		std::lock_guard<std::mutex> RunLock(RunMutex);
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Body = &Function;
+			PendingParts = (int)Workers.size();
+			Generation++;
+		}
+		WorkReady.notify_all();
+		Function(0, GetThreadCount());
+		std::unique_lock<std::mutex> Lock(Mutex);
+		WorkDone.wait(Lock, [this]() { return PendingParts == 0; });
+	}
+
+private:
+	StaticThreadPool(const StaticThreadPool &);
+	StaticThreadPool &operator=(const StaticThreadPool &);
+
+	void WorkerLoop(int Part)
+	{
+		unsigned long long DoneGeneration = 0;
+		for (;;)
+		{
+			const PartFunction *Function;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				WorkReady.wait(Lock, [&]() { return Stopping || (Generation != DoneGeneration); });
+				if (Stopping)
+					return;
+				DoneGeneration = Generation;
+				Function = Body;
+			}
+			(*Function)(Part, GetThreadCount());
+			bool Last;
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Last = (--PendingParts == 0);
+			}
+			if (Last)
+				WorkDone.notify_one();
+		}
+	}
+
+	std::vector<std::thread> Workers;
+	std::mutex RunMutex;				//< serializes the callers of Run
+	std::mutex Mutex;					//< protects the members below
+	std::condition_variable WorkReady;
+	std::condition_variable WorkDone;
+	const PartFunction *Body;
+	unsigned long long Generation;
+	int PendingParts;
+	bool Stopping;
+};
+
+static StaticThreadPool &GetThreadPool()
+{
+	static StaticThreadPool Pool(std::max((int)std::thread::hardware_concurrency(), 1));
+	return Pool;
+}
+
+void ProcessRGBThreadPoolSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	GetThreadPool().Run([=](int Part, int PartCount) {
+			ConvertPart((unsigned char *)SourceImage, (unsigned char *)YImage, ImageWidth * ImageHeight, PixelOffset, Part, PartCount);
+		});
+}
@@ -0,0 +1,45 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+// same exact SIMD kernel of ProcessRGBTBBSIMDAuto, the widest one supported by the CPU, run in parallel by other
+// runtimes, so that the differences in scheduling overhead and scaling are measured on identical work
+// every backend splits the image in chunks of whole blocks of 64 pixels, so that only the last chunk has a tail
+
+// OpenMP is enabled by /openmp with Visual C++ and -fopenmp with GCC and clang
+#if defined(_OPENMP)
+#define HAS_OPENMP_BACKEND 1
+#endif
+
+// parallel algorithms of C++17, Visual C++ supports them from Visual Studio 2017 15.7, libstdc++ implements them
+// with TBB, which is already linked
+#if defined(__has_include)
+#if __has_include(<execution>)
+#include <execution>
+#if defined(__cpp_lib_execution)
+#define HAS_PARALLEL_STL_BACKEND 1
+#endif
+#endif
+#endif
+
+#if defined(HAS_OPENMP_BACKEND)
+// one contiguous part of the image per OpenMP thread, schedule(static)
+void ProcessRGBOpenMPSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+#endif
+
+#if defined(HAS_PARALLEL_STL_BACKEND)
+// std::for_each with std::execution::par_unseq over chunks of 16K pixels, the library balances the load
+void ProcessRGBParallelSTLSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+#endif
+
+// one contiguous part of the image per thread of a pool of persistent std::thread workers, created on the first
+// call with one thread per hardware thread; the calling thread converts the first part
+void ProcessRGBThreadPoolSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
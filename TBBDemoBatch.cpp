@@ -0,0 +1,110 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoBatch.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <vector>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+using namespace tbb;
+
+// pixels converted by the smallest task, enough to hide the cost of stealing it while leaving several tasks
+// per thread on batches of thumbnails
+const int BATCH_GRAIN_PIXELS = 16 * 1024;
+
+// BatchImage
+// an image of the batch with the kernel for its pixel format, Coalesced is true when both images are tightly
+// packed and smaller than 2 GB, so that consecutive rows can be converted by a single call of the kernel
+
+struct BatchImage {
+	ImageDescriptor Source;
+	ImageDescriptor YImage;
+	LumaFunction Kernel;
+	int PixelSize;
+	bool Coalesced;
+};
+
+// ConvertBatchRows
+// converts rows StartRow to StopRow of an image, with the kernel handling the tail of each call
+
+static void ConvertBatchRows(const BatchImage &Image, int StartRow, int StopRow)
+{
+	if (Image.Coalesced)
+	{
+		Image.Kernel(GetImageRow(Image.Source, StartRow), GetImageRow(Image.YImage, StartRow),
+					 Image.Source.Width * (StopRow - StartRow), 1, Image.PixelSize);
+		return;
+	}
+	for (int y = StartRow; y < StopRow; y++)
+		Image.Kernel(GetImageRow(Image.Source, y), GetImageRow(Image.YImage, y), Image.Source.Width, 1, Image.PixelSize);
+}
+
+// ConvertToLumaBatch
+// the rows of the images are numbered one after the other, FirstRows[i] being the number of the first row of image i,
+// and a range of that iteration space can span several images; the grain is the number of rows that holds
+// BATCH_GRAIN_PIXELS pixels on average
+// every image is checked before the parallel loop, so that a bad descriptor fails the batch instead of crashing a
+// worker thread halfway through it
+
+bool ConvertToLumaBatch(const ImageDescriptor *Sources, const ImageDescriptor *YImages, int ImageCount,
+						LumaCoefficients Coefficients, bool ReducedPrecision)
+{
+	if (ImageCount < 0)
+		return false;
+	std::vector<BatchImage> Images(ImageCount);
+	std::vector<int> FirstRows(ImageCount + 1);
+	long long TotalPixels = 0;
+	FirstRows[0] = 0;
+	for (int i = 0; i < ImageCount; i++)
+	{
+		if (!IsRGB8Format(Sources[i].Format) || (YImages[i].Format != PIXEL_FORMAT_Y8))
+			return false;
+		if ((Sources[i].Width != YImages[i].Width) || (Sources[i].Height != YImages[i].Height) ||
+			(Sources[i].Width < 0) || (Sources[i].Height < 0))
+			return false;
+		BatchImage &Image = Images[i];
+		Image.Source = Sources[i];
+		Image.YImage = YImages[i];
+		Image.Kernel = GetLumaFunction(Sources[i].Format, Coefficients, ReducedPrecision, LUMA_ISA_BEST, false);
+		if (!Image.Kernel)
+			return false;
+		Image.PixelSize = GetPixelSize(Sources[i].Format);
+		Image.Coalesced = IsImagePacked(Sources[i]) && IsImagePacked(YImages[i]) &&
+						  ((long long)Sources[i].Stride * Sources[i].Height <= INT_MAX);
+		FirstRows[i + 1] = FirstRows[i] + Sources[i].Height;
+		TotalPixels += (long long)Sources[i].Width * Sources[i].Height;
+	}
+	const int TotalRows = FirstRows[ImageCount];
+	if (TotalPixels == 0)
+		return true;
+	const int GrainSize = (int)std::max(1LL, (long long)BATCH_GRAIN_PIXELS * TotalRows / TotalPixels);
+
+	parallel_for( blocked_range<int>( 0, TotalRows, GrainSize),
+		[&](const blocked_range<int>& r) {
+			// the last image whose first row is not past the start of the range, images without rows are skipped
+			int i = (int)(std::upper_bound(FirstRows.begin(), FirstRows.end(), r.begin()) - FirstRows.begin()) - 1;
+			int Row = r.begin();
+			while (Row < r.end())
+			{
+				int StopRow = std::min(r.end(), FirstRows[i + 1]);
+				if (StopRow > Row)
+					ConvertBatchRows(Images[i], Row - FirstRows[i], StopRow - FirstRows[i]);
+				Row = StopRow;
+				i++;
+			}
+		}
+		);
+	return true;
+}
@@ -0,0 +1,24 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+
+// ConvertToLumaBatch
+// converts ImageCount images, Sources[i] into YImages[i], as a single parallel loop over the rows of all the images,
+// so that the scheduling cost is paid once per batch and idle threads steal rows from any image instead of waiting
+// at the end of each one; every image can have its own RGB pixel format and stride, as with ConvertToLuma
+// rows are never split, so in-place conversion is supported when YImages[i] has the same Data and Stride of Sources[i]
+// returns false, without converting any image, when the format or the dimensions of one of them are not supported
+bool ConvertToLumaBatch(const ImageDescriptor *Sources, const ImageDescriptor *YImages, int ImageCount,
+						LumaCoefficients Coefficients = LUMA_BT601, bool ReducedPrecision = false);
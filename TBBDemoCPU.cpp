@@ -0,0 +1,173 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBDemoCPU.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// CPUIDEx
+// returns EAX, EBX, ECX and EDX for the given leaf and subleaf, or zeroes if the leaf is not supported
+
+static void CPUIDEx(unsigned int Leaf, int SubLeaf, unsigned int Registers[4])
+{
+#if defined(_MSC_VER)
+	int Info[4];
+	// the highest standard and extended leaves are returned by leaves 0 and 0x80000000
+	__cpuid(Info, (int)(Leaf & 0x80000000));
+	if (Leaf > (unsigned int)Info[0])
+	{
+		Registers[0] = Registers[1] = Registers[2] = Registers[3] = 0;
+		return;
+	}
+	__cpuidex(Info, Leaf, SubLeaf);
+	for (int i = 0; i < 4; i++)
+		Registers[i] = (unsigned int)Info[i];
+#else
+	if (!__get_cpuid_count(Leaf, SubLeaf, &Registers[0], &Registers[1], &Registers[2], &Registers[3]))
+		Registers[0] = Registers[1] = Registers[2] = Registers[3] = 0;
+#endif
+}
+
+// ReadXCR0
+// the OS must save the wider registers on context switches, otherwise AVX instructions cannot be used even if the CPU supports them
+
+static unsigned long long ReadXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int EAX, EDX;
+	__asm__ __volatile__ ("xgetbv" : "=a" (EAX), "=d" (EDX) : "c" (0));
+	return ((unsigned long long)EDX << 32) | EAX;
+#endif
+}
+
+static CPUFeatures DetectCPUFeatures()
+{
+	CPUFeatures Features = { false, false, false, false, false };
+	unsigned int Leaf1[4], Leaf7[4];
+	CPUIDEx(1, 0, Leaf1);
+	CPUIDEx(7, 0, Leaf7);
+
+	Features.SSE2 = (Leaf1[3] & (1 << 26)) != 0;
+	Features.SSSE3 = (Leaf1[2] & (1 << 9)) != 0;
+
+	bool OSXSAVE = (Leaf1[2] & (1 << 27)) != 0;
+	unsigned long long XCR0 = OSXSAVE ? ReadXCR0() : 0;
+	// XMM and YMM state
+	bool OSSavesYMM = (XCR0 & 0x06) == 0x06;
+	// opmask, upper ZMM0-15 and ZMM16-31 state
+	bool OSSavesZMM = (XCR0 & 0xE6) == 0xE6;
+
+	Features.AVX2 = OSSavesYMM && ((Leaf7[1] & (1 << 5)) != 0);
+	Features.F16C = OSSavesYMM && ((Leaf1[2] & (1 << 29)) != 0);
+#if defined(HAS_AVX512_INTRINSICS)
+	Features.AVX512BW = Features.AVX2 && OSSavesZMM && ((Leaf7[1] & (1 << 16)) != 0) && ((Leaf7[1] & (1 << 30)) != 0);
+#endif
+	return Features;
+}
+
+const CPUFeatures &GetCPUFeatures()
+{
+	static const CPUFeatures Features = DetectCPUFeatures();
+	return Features;
+}
+
+const char *GetCPUBestISAName()
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (Features.AVX512BW)
+		return "AVX-512BW";
+	if (Features.AVX2)
+		return "AVX2";
+	if (Features.SSSE3)
+		return "SSSE3";
+	if (Features.SSE2)
+		return "SSE2";
+	return "none";
+}
+
+// DetectCPUBrandString
+// each of the 3 leaves returns 16 characters of the name in EAX, EBX, ECX and EDX
+
+static std::string DetectCPUBrandString()
+{
+	unsigned int Registers[12];
+	char Brand[49];
+	for (int i = 0; i < 3; i++)
+		CPUIDEx(0x80000002 + i, 0, Registers + 4 * i);
+	memcpy(Brand, Registers, 48);
+	Brand[48] = 0;
+	std::string Name(Brand);
+	size_t Start = Name.find_first_not_of(' ');
+	if (Start == std::string::npos)
+		return "unknown";
+	return Name.substr(Start, Name.find_last_not_of(' ') - Start + 1);
+}
+
+const char *GetCPUBrandString()
+{
+	static const std::string Brand = DetectCPUBrandString();
+	return Brand.c_str();
+}
+
+// DetectCPUCacheSizes
+// Intel CPUs describe each cache with a subleaf of leaf 4, AMD CPUs use leaf 0x8000001D with the same layout:
+// type in bits 0-4 of EAX (1 data, 2 instruction, 3 unified, 0 no more caches), level in bits 5-7, and the size given
+// by ways, partitions, line size and sets, each stored minus one
+
+static CPUCacheSizes DetectCPUCacheSizes()
+{
+	CPUCacheSizes CacheSizes = { 0, 0, 0 };
+	const unsigned int Leaves[2] = { 4, 0x8000001D };
+	for (int i = 0; (i < 2) && (CacheSizes.L1Data == 0); i++)
+	{
+		for (int SubLeaf = 0; SubLeaf < 16; SubLeaf++)
+		{
+			unsigned int Registers[4];
+			CPUIDEx(Leaves[i], SubLeaf, Registers);
+			unsigned int Type = Registers[0] & 0x1F;
+			if (Type == 0)
+				break;
+			if (Type == 2)
+				continue;
+			int Level = (Registers[0] >> 5) & 0x7;
+			long long Size = (long long)((Registers[1] >> 22) + 1) * (((Registers[1] >> 12) & 0x3FF) + 1) *
+							 ((Registers[1] & 0xFFF) + 1) * ((long long)Registers[2] + 1);
+			int ClampedSize = (int)std::min(Size, (long long)INT_MAX);
+			if (Level == 1)
+				CacheSizes.L1Data = ClampedSize;
+			else if (Level == 2)
+				CacheSizes.L2 = ClampedSize;
+			else if (Level == 3)
+				CacheSizes.L3 = ClampedSize;
+		}
+	}
+	if (CacheSizes.L1Data == 0)
+		CacheSizes.L1Data = 32 * 1024;
+	if (CacheSizes.L2 == 0)
+		CacheSizes.L2 = 256 * 1024;
+	return CacheSizes;
+}
+
+const CPUCacheSizes &GetCPUCacheSizes()
+{
+	static const CPUCacheSizes CacheSizes = DetectCPUCacheSizes();
+	return CacheSizes;
+}
@@ -0,0 +1,56 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+// Visual C++ exposes every intrinsic regardless of the /arch setting, while GCC and clang require the target ISA
+// to be enabled on each function that uses it, so that the rest of the program can still run on older CPUs
+#if defined(__GNUC__)
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#define TARGET_AVX2_F16C __attribute__((target("avx2,f16c")))
+#else
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#define TARGET_AVX512
+#define TARGET_AVX2_F16C
+#endif
+
+// AVX-512 intrinsics are available starting from Visual Studio 2017
+#if defined(__GNUC__) || (defined(_MSC_VER) && (_MSC_VER >= 1910))
+#define HAS_AVX512_INTRINSICS 1
+#endif
+
+// instruction sets supported by both the CPU and the operating system
+struct CPUFeatures {
+	bool SSE2;
+	bool SSSE3;
+	bool AVX2;
+	bool AVX512BW;
+	bool F16C;				//< conversions between half and single precision floats, requires the YMM state
+};
+
+// CPUID is queried only once, the first time this function is called
+const CPUFeatures &GetCPUFeatures();
+// name of the widest instruction set used by the dispatched kernels
+const char *GetCPUBestISAName();
+// processor name reported by CPUID leaves 0x80000002-0x80000004, without leading and trailing spaces
+const char *GetCPUBrandString();
+
+// sizes in bytes of the data caches of one core, L3 is shared by several cores
+struct CPUCacheSizes {
+	int L1Data;
+	int L2;
+	int L3;					//< 0 when the CPU has no L3 cache
+};
+
+// read from the deterministic cache parameters of CPUID, common defaults are returned for the levels that are not reported
+const CPUCacheSizes &GetCPUCacheSizes();
@@ -0,0 +1,148 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include <string.h>
+
+#include "TBBDemoCounters.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *GetPerfCounterName(PerfCounter Counter)
+{
+	switch (Counter)
+	{
+	case PERF_COUNTER_CYCLES:
+		return "cycles";
+	case PERF_COUNTER_INSTRUCTIONS:
+		return "instructions";
+	case PERF_COUNTER_LLC_MISSES:
+		return "LLC misses";
+	case PERF_COUNTER_TASK_CLOCK:
+		return "task clock";
+	default:
+		return "unknown";
+	}
+}
+
+PerfCounterValues operator-(const PerfCounterValues &Stop, const PerfCounterValues &Start)
+{
+	PerfCounterValues Difference;
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		Difference.Available[i] = Stop.Available[i] && Start.Available[i];
+		Difference.Values[i] = Difference.Available[i] ? Stop.Values[i] - Start.Values[i] : 0.0;
+	}
+	return Difference;
+}
+
+#if defined(__linux__)
+
+// OpenPerfCounter
+// the counter starts enabled, user-mode only and inherited by the threads created afterwards; the enabled and
+// running times are read with the value, to scale it when the counter was multiplexed
+
+static int OpenPerfCounter(PerfCounter Counter)
+{
+	struct perf_event_attr Attributes;
+	memset(&Attributes, 0, sizeof(Attributes));
+	Attributes.size = sizeof(Attributes);
+	Attributes.type = PERF_TYPE_HARDWARE;
+	switch (Counter)
+	{
+	case PERF_COUNTER_CYCLES:
+		Attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+		break;
+	case PERF_COUNTER_INSTRUCTIONS:
+		Attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case PERF_COUNTER_LLC_MISSES:
+		Attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+		break;
+	default:
+		Attributes.type = PERF_TYPE_SOFTWARE;
+		Attributes.config = PERF_COUNT_SW_TASK_CLOCK;
+		break;
+	}
+	Attributes.inherit = 1;
+	Attributes.exclude_kernel = 1;
+	Attributes.exclude_hv = 1;
+	Attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(__NR_perf_event_open, &Attributes, 0, -1, -1, 0);
+}
+
+PerfCounters::PerfCounters()
+{
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		Descriptors[i] = OpenPerfCounter((PerfCounter)i);
+		if ((Descriptors[i] < 0) && Error.empty())
+		{
+			Error = std::string(GetPerfCounterName((PerfCounter)i)) + ": " + strerror(errno);
+			if ((errno == EACCES) || (errno == EPERM))
+				Error += ", see /proc/sys/kernel/perf_event_paranoid";
+			else if (errno == ENOENT)
+				Error += ", the event is not exposed by the CPU or the virtual machine";
+		}
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	for (int i = 0; i < PERF_COUNTERS; i++)
+		if (Descriptors[i] >= 0)
+			close(Descriptors[i]);
+}
+
+// PerfCounters::Read
+// the value of an inherited counter includes the counts of the threads that inherited it
+
+PerfCounterValues PerfCounters::Read() const
+{
+	PerfCounterValues Values;
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		unsigned long long Data[3] = { 0, 0, 0 };		// value, time enabled, time running
+		Values.Available[i] = (Descriptors[i] >= 0) && (read(Descriptors[i], Data, sizeof(Data)) == (ssize_t)sizeof(Data));
+		Values.Values[i] = 0.0;
+		if (Values.Available[i] && (Data[2] > 0))
+			Values.Values[i] = (double)Data[0] * ((double)Data[1] / (double)Data[2]);
+	}
+	return Values;
+}
+
+#else
+
+PerfCounters::PerfCounters() : Error("performance counters are read only on Linux")
+{
+	for (int i = 0; i < PERF_COUNTERS; i++)
+		Descriptors[i] = -1;
+}
+
+PerfCounters::~PerfCounters()
+{
+}
+
+PerfCounterValues PerfCounters::Read() const
+{
+	PerfCounterValues Values;
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		Values.Available[i] = false;
+		Values.Values[i] = 0.0;
+	}
+	return Values;
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include <string>
+
+// hardware performance counters
+// on Linux the counters are opened with perf_event_open for the calling thread, and inherited by the threads it
+// creates afterwards: they must be opened before the first parallel algorithm runs, so that the TBB worker threads,
+// which are created then, are counted too; only user-mode events are counted, which perf_event_paranoid allows
+// up to level 2
+// on other systems, in virtual machines without a virtual PMU and when perf_event_paranoid is 3 or more, the
+// counters are reported as unavailable and the measurements go on without them
+
+enum PerfCounter {
+	PERF_COUNTER_CYCLES,
+	PERF_COUNTER_INSTRUCTIONS,
+	PERF_COUNTER_LLC_MISSES,		//< last level cache misses, each one moves a cache line from memory
+	PERF_COUNTER_TASK_CLOCK,		//< CPU time of all the threads in ns, a software counter that needs no PMU
+	PERF_COUNTERS
+};
+
+struct PerfCounterValues {
+	bool Available[PERF_COUNTERS];
+	double Values[PERF_COUNTERS];	//< scaled up when the kernel multiplexed the counter with other events
+};
+
+const char *GetPerfCounterName(PerfCounter Counter);
+
+// PerfCounterValues difference, the counters that are unavailable in either of them are unavailable in the result
+PerfCounterValues operator-(const PerfCounterValues &Stop, const PerfCounterValues &Start);
+
+class PerfCounters {
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	bool IsAvailable(PerfCounter Counter) const { return Descriptors[Counter] >= 0; }
+	// why the first unavailable counter could not be opened, empty when all of them are available
+	const std::string &GetError() const { return Error; }
+	// current values, counters keep running from when they are opened
+	PerfCounterValues Read() const;
+
+private:
+	PerfCounters(const PerfCounters &);
+	PerfCounters &operator=(const PerfCounters &);
+
+	int Descriptors[PERF_COUNTERS];		//< -1 for the unavailable counters
+	std::string Error;
+};
@@ -0,0 +1,333 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBDemoHighBitDepth.h"
+#include "TBBDemoCPU.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range2d.h>
+using namespace tbb;
+
+// SIMD intrinsics
+#include <immintrin.h>
+
+// pixels converted by each step of the SIMD loop, and width of the column blocks of the parallel split
+const int HIGH_BIT_DEPTH_BLOCK_PIXELS = 16;
+
+// HalfToFloat
+// the exponent is rebiased from 15 to 127 and the mantissa widened from 10 to 23 bits, subnormal halves are
+// normalized since they are normal floats, infinities and NaN keep their payload
+
+float HalfToFloat(unsigned short Value)
+{
+	unsigned int Sign = (unsigned int)(Value & 0x8000) << 16;
+	unsigned int Exponent = (Value >> 10) & 0x1F;
+	unsigned int Mantissa = Value & 0x3FF;
+	unsigned int Bits;
+	if (Exponent == 0x1F)
+		Bits = Sign | 0x7F800000 | (Mantissa << 13);
+	else if (Exponent != 0)
+		Bits = Sign | ((Exponent + 127 - 15) << 23) | (Mantissa << 13);
+	else if (Mantissa == 0)
+		Bits = Sign;
+	else
+	{
+		// Mantissa * 2^-24, shifted until the implicit bit is set
+		Exponent = 127 - 15 + 1;
+		while ((Mantissa & 0x400) == 0)
+		{
+			Mantissa <<= 1;
+			Exponent--;
+		}
+		Bits = Sign | (Exponent << 23) | ((Mantissa & 0x3FF) << 13);
+	}
+	float Result;
+	memcpy(&Result, &Bits, sizeof(Result));
+	return Result;
+}
+
+// FloatToHalf
+// the dropped mantissa bits are rounded to nearest even, a carry out of the mantissa correctly increments the
+// exponent, up to infinity for the largest values; floats below the half normal range become subnormals or zero
+
+unsigned short FloatToHalf(float Value)
+{
+	unsigned int Bits;
+	memcpy(&Bits, &Value, sizeof(Bits));
+	unsigned int Sign = (Bits >> 16) & 0x8000;
+	int Exponent = (int)((Bits >> 23) & 0xFF);
+	unsigned int Mantissa = Bits & 0x7FFFFF;
+	if (Exponent == 0xFF)
+		return (unsigned short)(Sign | 0x7C00 | (Mantissa ? (0x200 | (Mantissa >> 13)) : 0));
+	int HalfExponent = Exponent - 127 + 15;
+	if (HalfExponent >= 0x1F)
+		return (unsigned short)(Sign | 0x7C00);
+	int Shift = 13;
+	unsigned int Half;
+	if (HalfExponent > 0)
+		Half = ((unsigned int)HalfExponent << 10) | (Mantissa >> Shift);
+	else if (HalfExponent >= -10)
+	{
+		// the implicit bit becomes explicit, and the exponent is folded into the shift
+		Mantissa |= 0x800000;
+		Shift = 14 - HalfExponent;
+		Half = Mantissa >> Shift;
+	}
+	else
+		return (unsigned short)Sign;
+	unsigned int Remainder = Mantissa & ((1u << Shift) - 1);
+	unsigned int Halfway = 1u << (Shift - 1);
+	if ((Remainder > Halfway) || ((Remainder == Halfway) && (Half & 1)))
+		Half++;
+	return (unsigned short)(Sign | Half);
+}
+
+// HighBitDepthConversion
+// everything the tile functions need, the coefficients are scaled from the range of the input to that of the output
+
+struct HighBitDepthConversion {
+	ImageDescriptor Source;
+	ImageDescriptor YImage;
+	bool HalfFloat;
+	double Red, Green, Blue;
+	double MaxCode;			//< largest output value
+};
+
+static HighBitDepthConversion MakeHighBitDepthConversion(const ImageDescriptor &Source, const ImageDescriptor &YImage, int BitDepth,
+														 LumaCoefficients Coefficients)
+{
+	assert((Source.Format == PIXEL_FORMAT_RGBA64) || (Source.Format == PIXEL_FORMAT_RGBA64F));
+	assert((YImage.Format == PIXEL_FORMAT_Y8) || (YImage.Format == PIXEL_FORMAT_Y16));
+	assert((Source.Width == YImage.Width) && (Source.Height == YImage.Height));
+	// 16-bit channels are read and written through aligned pointers
+	assert((((size_t)Source.Data | (size_t)Source.Stride) & 1) == 0);
+	assert((YImage.Format == PIXEL_FORMAT_Y8) || ((((size_t)YImage.Data | (size_t)YImage.Stride) & 1) == 0));
+
+	HighBitDepthConversion Conversion;
+	Conversion.Source = Source;
+	Conversion.YImage = YImage;
+	Conversion.HalfFloat = (Source.Format == PIXEL_FORMAT_RGBA64F);
+	assert(Conversion.HalfFloat || ((BitDepth >= 8) && (BitDepth <= 16)));
+	const double InputMaxCode = Conversion.HalfFloat ? 1.0 : (double)((1 << BitDepth) - 1);
+	if (YImage.Format == PIXEL_FORMAT_Y8)
+		Conversion.MaxCode = 255.0;
+	else
+		Conversion.MaxCode = Conversion.HalfFloat ? 65535.0 : InputMaxCode;
+	const double Scale = Conversion.MaxCode / InputMaxCode;
+	switch (Coefficients)
+	{
+	case LUMA_BT709:
+		Conversion.Red = CoefficientsBT709::Red * Scale;
+		Conversion.Green = CoefficientsBT709::Green * Scale;
+		Conversion.Blue = CoefficientsBT709::Blue * Scale;
+		break;
+	case LUMA_BT2020:
+		Conversion.Red = CoefficientsBT2020::Red * Scale;
+		Conversion.Green = CoefficientsBT2020::Green * Scale;
+		Conversion.Blue = CoefficientsBT2020::Blue * Scale;
+		break;
+	default:
+		Conversion.Red = CoefficientsBT601::Red * Scale;
+		Conversion.Green = CoefficientsBT601::Green * Scale;
+		Conversion.Blue = CoefficientsBT601::Blue * Scale;
+		break;
+	}
+	return Conversion;
+}
+
+// LoadChannel
+// value of a channel in the range of the input
+
+template <bool HALF_FLOAT>
+static inline float LoadChannel(unsigned short Value)
+{
+	return HALF_FLOAT ? HalfToFloat(Value) : (float)Value;
+}
+
+// RoundLuma
+// clamps to the output range and rounds to nearest, NaN fails the first comparison and gives 0 like _mm256_max_ps
+
+static inline int RoundLuma(float YValue, float MaxCode)
+{
+	if (!(YValue > 0.0f))
+		return 0;
+	return (int)(std::min(YValue, MaxCode) + 0.5f);
+}
+
+// ConvertTileScalar
+// converts the pixels from StartX to StopX of the rows from StartRow to StopRow, with the same order of operations
+// of the SIMD code: (Red + Green) + Blue
+
+template <bool HALF_FLOAT, class YType>
+static void ConvertTileScalar(const HighBitDepthConversion &Conversion, int StartRow, int StopRow, int StartX, int StopX)
+{
+	const float Red = (float)Conversion.Red;
+	const float Green = (float)Conversion.Green;
+	const float Blue = (float)Conversion.Blue;
+	const float MaxCode = (float)Conversion.MaxCode;
+	for (int Row = StartRow; Row < StopRow; Row++)
+	{
+		const unsigned short *SourcePtr = (const unsigned short *)GetImageRow(Conversion.Source, Row) + StartX * 4;
+		YType *YPtr = (YType *)GetImageRow(Conversion.YImage, Row) + StartX;
+		for (int x = StartX; x < StopX; x++, SourcePtr += 4)
+		{
+			float YValue = (LoadChannel<HALF_FLOAT>(SourcePtr[0]) * Red + LoadChannel<HALF_FLOAT>(SourcePtr[1]) * Green) +
+						   LoadChannel<HALF_FLOAT>(SourcePtr[2]) * Blue;
+			*YPtr++ = (YType)RoundLuma(YValue, MaxCode);
+		}
+	}
+}
+
+// HighBitDepthConstantsAVX2
+// the scales hold the coefficients of 2 pixels, one per 128-bit lane, with a zero for alpha
+
+struct HighBitDepthConstantsAVX2 {
+	__m256 Scales;
+	__m256 ColorMask;		//< clears alpha, since infinities and NaN would propagate through its zero coefficient
+	__m256 MaxCode;
+	__m256i PixelOrder;
+
+	TARGET_AVX2_F16C HighBitDepthConstantsAVX2(const HighBitDepthConversion &Conversion)
+	{
+		Scales = _mm256_setr_ps((float)Conversion.Red, (float)Conversion.Green, (float)Conversion.Blue, 0.0f,
+								(float)Conversion.Red, (float)Conversion.Green, (float)Conversion.Blue, 0.0f);
+		ColorMask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+		MaxCode = _mm256_set1_ps((float)Conversion.MaxCode);
+		PixelOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	}
+};
+
+// Load2PixelsAVX2
+// converts the 8 channels of 2 pixels to floats, F16C widens the halves and AVX2 the 16-bit integers
+
+template <bool HALF_FLOAT>
+static inline TARGET_AVX2_F16C __m256 Load2PixelsAVX2(const unsigned short *SourcePtr, const HighBitDepthConstantsAVX2 &Constants)
+{
+	__m128i RGBAValue = _mm_loadu_si128((const __m128i *)SourcePtr);
+	if (HALF_FLOAT)
+		return _mm256_and_ps(_mm256_cvtph_ps(RGBAValue), Constants.ColorMask);
+	return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(RGBAValue));
+}
+
+// Convert8PixelsAVX2
+// computes the luma of 8 pixels, returned in order as 32-bit integers
+// each load holds pixel 2i in the low lane and 2i+1 in the high lane, the first two horizontal adds produce
+// Red + Green and Blue of 4 pixels per register, the third one the luma of pixels 0 2 4 6 in the low lane and
+// 1 3 5 7 in the high lane, which the final permutation interleaves
+
+template <bool HALF_FLOAT>
+static inline TARGET_AVX2_F16C __m256i Convert8PixelsAVX2(const unsigned short *SourcePtr, const HighBitDepthConstantsAVX2 &Constants)
+{
+	__m256 Products01 = _mm256_mul_ps(Load2PixelsAVX2<HALF_FLOAT>(SourcePtr, Constants), Constants.Scales);
+	__m256 Products23 = _mm256_mul_ps(Load2PixelsAVX2<HALF_FLOAT>(SourcePtr + 8, Constants), Constants.Scales);
+	__m256 Products45 = _mm256_mul_ps(Load2PixelsAVX2<HALF_FLOAT>(SourcePtr + 16, Constants), Constants.Scales);
+	__m256 Products67 = _mm256_mul_ps(Load2PixelsAVX2<HALF_FLOAT>(SourcePtr + 24, Constants), Constants.Scales);
+	__m256 YValue = _mm256_hadd_ps(_mm256_hadd_ps(Products01, Products23), _mm256_hadd_ps(Products45, Products67));
+	// _mm256_max_ps returns its second operand when the first one is NaN
+	YValue = _mm256_min_ps(_mm256_max_ps(YValue, _mm256_setzero_ps()), Constants.MaxCode);
+	__m256i YInteger = _mm256_cvttps_epi32(_mm256_add_ps(YValue, _mm256_set1_ps(0.5f)));
+	return _mm256_permutevar8x32_epi32(YInteger, Constants.PixelOrder);
+}
+
+// ConvertTileAVX2
+// 16 pixels per loop, the remaining ones are processed by the scalar code
+// the in-lane pack leaves the 4 luma values of each 64-bit group in order, _mm256_permute4x64_epi64 puts the groups back
+// in place; the values are already clamped, so the 8-bit output is a second pack of the two halves
+
+template <bool HALF_FLOAT, class YType>
+static TARGET_AVX2_F16C void ConvertTileAVX2(const HighBitDepthConversion &Conversion, int StartRow, int StopRow, int StartX, int StopX)
+{
+	const HighBitDepthConstantsAVX2 Constants(Conversion);
+	const int SIMDStopX = StartX + (StopX - StartX) / HIGH_BIT_DEPTH_BLOCK_PIXELS * HIGH_BIT_DEPTH_BLOCK_PIXELS;
+	for (int Row = StartRow; Row < StopRow; Row++)
+	{
+		const unsigned short *SourcePtr = (const unsigned short *)GetImageRow(Conversion.Source, Row) + StartX * 4;
+		YType *YPtr = (YType *)GetImageRow(Conversion.YImage, Row) + StartX;
+		for (int x = StartX; x < SIMDStopX; x += HIGH_BIT_DEPTH_BLOCK_PIXELS)
+		{
+			__m256i YValue0 = Convert8PixelsAVX2<HALF_FLOAT>(SourcePtr, Constants);
+			__m256i YValue1 = Convert8PixelsAVX2<HALF_FLOAT>(SourcePtr + 32, Constants);
+			SourcePtr += 4 * HIGH_BIT_DEPTH_BLOCK_PIXELS;
+			__m256i YValue = _mm256_permute4x64_epi64(_mm256_packus_epi32(YValue0, YValue1), _MM_SHUFFLE(3, 1, 2, 0));
+			if (sizeof(YType) == 2)
+				_mm256_storeu_si256((__m256i *)YPtr, YValue);
+			else
+				_mm_storeu_si128((__m128i *)YPtr, _mm_packus_epi16(_mm256_castsi256_si128(YValue), _mm256_extracti128_si256(YValue, 1)));
+			YPtr += HIGH_BIT_DEPTH_BLOCK_PIXELS;
+		}
+	}
+	if (SIMDStopX < StopX)
+		ConvertTileScalar<HALF_FLOAT, YType>(Conversion, StartRow, StopRow, SIMDStopX, StopX);
+}
+
+typedef void (*HighBitDepthTileFunction)(const HighBitDepthConversion &Conversion, int StartRow, int StopRow, int StartX, int StopX);
+
+// SelectTileFunction
+// instantiation for the source format, the output format and the instruction set
+
+template <class YType>
+static HighBitDepthTileFunction SelectTileFunction(bool HalfFloat, bool UseAVX2)
+{
+	if (HalfFloat)
+		return UseAVX2 ? &ConvertTileAVX2<true, YType> : &ConvertTileScalar<true, YType>;
+	return UseAVX2 ? &ConvertTileAVX2<false, YType> : &ConvertTileScalar<false, YType>;
+}
+
+void ConvertToLumaHighBitDepthReference(const ImageDescriptor &Source, const ImageDescriptor &YImage, int BitDepth,
+										LumaCoefficients Coefficients)
+{
+	const HighBitDepthConversion Conversion = MakeHighBitDepthConversion(Source, YImage, BitDepth, Coefficients);
+	for (int Row = 0; Row < Source.Height; Row++)
+	{
+		const unsigned short *SourcePtr = (const unsigned short *)GetImageRow(Source, Row);
+		unsigned char *YPtr = GetImageRow(YImage, Row);
+		for (int x = 0; x < Source.Width; x++, SourcePtr += 4)
+		{
+			double Channels[3];
+			for (int i = 0; i < 3; i++)
+				Channels[i] = Conversion.HalfFloat ? (double)HalfToFloat(SourcePtr[i]) : (double)SourcePtr[i];
+			double YValue = Channels[0] * Conversion.Red + Channels[1] * Conversion.Green + Channels[2] * Conversion.Blue;
+			int Value = (YValue > 0.0) ? (int)floor(std::min(YValue, Conversion.MaxCode) + 0.5) : 0;
+			if (YImage.Format == PIXEL_FORMAT_Y8)
+				YPtr[x] = (unsigned char)Value;
+			else
+				((unsigned short *)YPtr)[x] = (unsigned short)Value;
+		}
+	}
+}
+
+void ConvertToLumaHighBitDepth(const ImageDescriptor &Source, const ImageDescriptor &YImage, int BitDepth,
+							   LumaCoefficients Coefficients, LumaISA ISA, bool Parallel)
+{
+	const HighBitDepthConversion Conversion = MakeHighBitDepthConversion(Source, YImage, BitDepth, Coefficients);
+	const CPUFeatures &Features = GetCPUFeatures();
+	const bool UseAVX2 = (ISA != LUMA_ISA_SCALAR) && Features.AVX2 && Features.F16C;
+	const HighBitDepthTileFunction ConvertTile = (YImage.Format == PIXEL_FORMAT_Y8) ?
+		SelectTileFunction<unsigned char>(Conversion.HalfFloat, UseAVX2) : SelectTileFunction<unsigned short>(Conversion.HalfFloat, UseAVX2);
+
+	if (!Parallel)
+	{
+		ConvertTile(Conversion, 0, Source.Height, 0, Source.Width);
+		return;
+	}
+	const int ColumnBlocks = (Source.Width + HIGH_BIT_DEPTH_BLOCK_PIXELS - 1) / HIGH_BIT_DEPTH_BLOCK_PIXELS;
+	parallel_for( blocked_range2d<int,int>( 0, Source.Height, 0, ColumnBlocks),
+	    [&](const blocked_range2d<int,int>& r) {
+			ConvertTile(Conversion, r.rows().begin(), r.rows().end(), r.cols().begin() * HIGH_BIT_DEPTH_BLOCK_PIXELS,
+						std::min(r.cols().end() * HIGH_BIT_DEPTH_BLOCK_PIXELS, Source.Width));
+	      }
+	    );
+}
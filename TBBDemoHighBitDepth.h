@@ -0,0 +1,40 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+
+// luma of RGBA64 and RGBA64F images, to Y8 or Y16
+// the kernels compute in single precision with the exact coefficients of the color standard, scaled to the range of
+// the output; below 2^16 the rounding errors of the 3 products and 2 sums stay under 1/32 of an output unit, so the
+// result differs from the rounded double precision reference only when the exact luma lies that close to a half-integer
+// - RGBA64 with BitDepth bits per channel: Y8 covers 0..2^BitDepth - 1 with 0..255, Y16 keeps the same bit depth
+// - RGBA64F: 0.0..1.0 maps to 0..255 or 0..65535, values outside the range are clamped and NaN gives 0
+// alpha is ignored in both formats
+const int HIGH_BIT_DEPTH_MAX_ERROR = 1;
+
+// half precision conversions in software, with subnormals, infinities and NaN; FloatToHalf rounds to nearest even
+float HalfToFloat(unsigned short Value);
+unsigned short FloatToHalf(float Value);
+
+// ConvertToLumaHighBitDepthReference
+// serial conversion in double precision, the reference of ConvertToLumaHighBitDepth
+// BitDepth is between 8 and 16 and is ignored for RGBA64F sources
+void ConvertToLumaHighBitDepthReference(const ImageDescriptor &Source, const ImageDescriptor &YImage, int BitDepth,
+										LumaCoefficients Coefficients = LUMA_BT601);
+
+// ConvertToLumaHighBitDepth
+// LUMA_ISA_SCALAR selects the scalar kernel, any other value the AVX2 one when the CPU supports AVX2 and F16C,
+// with the scalar kernel as fallback; with Parallel the image is split in tiles of rows and blocks of 16 pixels
+// the images must not overlap
+void ConvertToLumaHighBitDepth(const ImageDescriptor &Source, const ImageDescriptor &YImage, int BitDepth,
+							   LumaCoefficients Coefficients = LUMA_BT601, LumaISA ISA = LUMA_ISA_BEST, bool Parallel = true);
@@ -0,0 +1,385 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBDemoCPU.h"
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+#include "TBBDemoRoutines.h"
+
+#include <algorithm>
+#include <limits.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+#include <blocked_range2d.h>
+using namespace tbb;
+
+int GetPixelSize(PixelFormat Format)
+{
+	switch (Format)
+	{
+	case PIXEL_FORMAT_Y8:
+		return 1;
+	case PIXEL_FORMAT_Y16:
+		return 2;
+	case PIXEL_FORMAT_RGB24:
+	case PIXEL_FORMAT_BGR24:
+		return 3;
+	case PIXEL_FORMAT_RGBA32:
+	case PIXEL_FORMAT_BGRA32:
+	case PIXEL_FORMAT_ARGB32:
+		return 4;
+	case PIXEL_FORMAT_RGBA64:
+	case PIXEL_FORMAT_RGBA64F:
+		return 8;
+	}
+	return 0;
+}
+
+bool IsRGB8Format(PixelFormat Format)
+{
+	switch (Format)
+	{
+	case PIXEL_FORMAT_RGB24:
+	case PIXEL_FORMAT_BGR24:
+	case PIXEL_FORMAT_RGBA32:
+	case PIXEL_FORMAT_BGRA32:
+	case PIXEL_FORMAT_ARGB32:
+		return true;
+	}
+	return false;
+}
+
+const char *GetPixelFormatName(PixelFormat Format)
+{
+	switch (Format)
+	{
+	case PIXEL_FORMAT_Y8:
+		return "Y8";
+	case PIXEL_FORMAT_RGB24:
+		return "RGB24";
+	case PIXEL_FORMAT_RGBA32:
+		return "RGBA32";
+	case PIXEL_FORMAT_BGR24:
+		return "BGR24";
+	case PIXEL_FORMAT_BGRA32:
+		return "BGRA32";
+	case PIXEL_FORMAT_ARGB32:
+		return "ARGB32";
+	case PIXEL_FORMAT_RGBA64:
+		return "RGBA64";
+	case PIXEL_FORMAT_RGBA64F:
+		return "RGBA64F";
+	case PIXEL_FORMAT_Y16:
+		return "Y16";
+	}
+	return "unknown";
+}
+
+ImageDescriptor MakeImageDescriptor(void *Data, int Width, int Height, PixelFormat Format, int Stride)
+{
+	ImageDescriptor Image;
+	Image.Data = (unsigned char *)Data;
+	Image.Width = Width;
+	Image.Height = Height;
+	Image.Stride = (Stride != 0) ? Stride : Width * GetPixelSize(Format);
+	Image.Format = Format;
+	return Image;
+}
+
+// CheckImages
+// the kernels convert an 8-bit RGB image, in any channel order, to a Y8 image with the same dimensions
+// high bit depth images are converted by ConvertToLumaHighBitDepth
+// the images come from the caller, so they are checked in Release builds too: there is no kernel for the other
+// formats, and a size mismatch would write past the end of the luma plane
+
+static bool CheckImages(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	if (!IsRGB8Format(Source.Format))
+		return false;
+	if (YImage.Format != PIXEL_FORMAT_Y8)
+		return false;
+	return (Source.Width == YImage.Width) && (Source.Height == YImage.Height) && (Source.Width >= 0) && (Source.Height >= 0);
+}
+
+// CoalesceRows
+// when both images are tightly packed they can be processed as a single long row, so that a kernel has to run
+// its tail code only once instead of once per row; the row must still be addressable with an int, so images of
+// 2 GB or more keep their rows
+
+static void CoalesceRows(ImageDescriptor &Source, ImageDescriptor &YImage)
+{
+	if (IsImagePacked(Source) && IsImagePacked(YImage) && ((long long)Source.Stride * Source.Height <= INT_MAX))
+	{
+		Source.Width *= Source.Height;
+		Source.Stride *= Source.Height;
+		Source.Height = 1;
+		YImage.Width = Source.Width;
+		YImage.Stride = Source.Width;
+		YImage.Height = 1;
+	}
+}
+
+// ImagesOverlap
+// true when the memory spanned by the two images intersects, as it happens when converting in place
+
+static bool ImagesOverlap(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	unsigned char *SourceFirstRow = GetImageRow(Source, 0);
+	unsigned char *SourceLastRow = GetImageRow(Source, Source.Height - 1);
+	unsigned char *SourceStart = std::min(SourceFirstRow, SourceLastRow);
+	unsigned char *SourceStop = std::max(SourceFirstRow, SourceLastRow) + Source.Width * GetPixelSize(Source.Format);
+	unsigned char *YFirstRow = GetImageRow(YImage, 0);
+	unsigned char *YLastRow = GetImageRow(YImage, YImage.Height - 1);
+	unsigned char *YStart = std::min(YFirstRow, YLastRow);
+	unsigned char *YStop = std::max(YFirstRow, YLastRow) + YImage.Width;
+	return (SourceStart < YStop) && (YStart < SourceStop);
+}
+
+// GetSerialKernel
+// scalar kernel for the channel order of the given format
+
+static ProcessRGBFunction GetSerialKernel(PixelFormat Format)
+{
+	return GetLumaFunction(Format, LUMA_BT601, false, LUMA_ISA_SCALAR, false);
+}
+
+// GetFormatKernel
+// BT.601 kernel with the given precision and instruction set for the channel order of the given format
+// GetLumaFunction cannot be used here, since it does not select the truncated scales (SCALING_LOG 7)
+
+template <int SCALING_LOG, class ISA>
+static ProcessRGBFunction GetFormatKernel(PixelFormat Format)
+{
+	switch (Format)
+	{
+	case PIXEL_FORMAT_RGB24:
+		return &ProcessLuma<LayoutRGB24, CoefficientsBT601, SCALING_LOG, ISA, ExecutionSerial>;
+	case PIXEL_FORMAT_RGBA32:
+		return &ProcessLuma<LayoutRGBA32, CoefficientsBT601, SCALING_LOG, ISA, ExecutionSerial>;
+	case PIXEL_FORMAT_BGR24:
+		return &ProcessLuma<LayoutBGR24, CoefficientsBT601, SCALING_LOG, ISA, ExecutionSerial>;
+	case PIXEL_FORMAT_BGRA32:
+		return &ProcessLuma<LayoutBGRA32, CoefficientsBT601, SCALING_LOG, ISA, ExecutionSerial>;
+	case PIXEL_FORMAT_ARGB32:
+		return &ProcessLuma<LayoutARGB32, CoefficientsBT601, SCALING_LOG, ISA, ExecutionSerial>;
+	default:
+		return 0;
+	}
+}
+
+// SelectRowKernel
+// the RGBA32 kernels hard-code the channel order, other formats use the shuffle-based kernel with the instruction set
+// and precision of the RGBA32 one, so that each function runs the kernel it is named after on every format
+// ProcessRGBSIMD is SSE2 code, which has no byte shuffle, so the other formats use the SSSE3 kernel
+
+template <int SCALING_LOG, class ISA>
+static ProcessRGBFunction SelectRowKernel(const ImageDescriptor &Source, ProcessRGBFunction RGBAKernel)
+{
+	if (Source.Format == PIXEL_FORMAT_RGBA32)
+		return RGBAKernel;
+	return GetFormatKernel<SCALING_LOG, ISA>(Source.Format);
+}
+
+// SelectAutoRowKernel
+// same for the Auto kernels, which pick the widest instruction set supported by the CPU; without SSSE3 they run the
+// exact SSE2 kernel, and the other formats the exact scalar one
+
+template <int SCALING_LOG>
+static ProcessRGBFunction SelectAutoRowKernel(const ImageDescriptor &Source, ProcessRGBFunction RGBAKernel)
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (Features.AVX512BW)
+		return SelectRowKernel<SCALING_LOG, ISAAVX512>(Source, RGBAKernel);
+	if (Features.AVX2)
+		return SelectRowKernel<SCALING_LOG, ISAAVX2>(Source, RGBAKernel);
+	if (Features.SSSE3)
+		return SelectRowKernel<SCALING_LOG, ISASSSE3>(Source, RGBAKernel);
+	return SelectRowKernel<15, ISAScalar>(Source, RGBAKernel);
+}
+
+// ProcessImageRows
+// runs a kernel on each row of the image, the kernel converts a row of ImageWidth pixels and handles its own tail
+
+static bool ProcessImageRows(ImageDescriptor Source, ImageDescriptor YImage, ProcessRGBFunction RowKernel)
+{
+	if (!CheckImages(Source, YImage) || !RowKernel)
+		return false;
+	if (!ImagesOverlap(Source, YImage))
+		CoalesceRows(Source, YImage);
+	int PixelOffset = GetPixelSize(Source.Format);
+	for (int y = 0; y < Source.Height; y++)
+		RowKernel(GetImageRow(Source, y), GetImageRow(YImage, y), Source.Width, 1, PixelOffset);
+	return true;
+}
+
+// ParallelProcessImage
+// splits the image in tiles of rows and columns, the columns are split in multiples of PixelAlignment so that
+// chunk boundaries never fall inside a SIMD register and only the last tile of each row has a tail
+// when converting in place, luma values overwrite the beginning of the source row, so rows are never split;
+// this is safe only if YImage starts at the same address and has the same Stride of Source, other overlapping
+// layouts are converted serially
+
+static bool ParallelProcessImage(ImageDescriptor Source, ImageDescriptor YImage, ProcessRGBFunction RowKernel, int PixelAlignment)
+{
+	if (!CheckImages(Source, YImage) || !RowKernel)
+		return false;
+	int PixelOffset = GetPixelSize(Source.Format);
+
+	if (ImagesOverlap(Source, YImage))
+	{
+		if ((Source.Data != YImage.Data) || (Source.Stride != YImage.Stride))
+			return ProcessImageRows(Source, YImage, RowKernel);
+		parallel_for( blocked_range<int>( 0, Source.Height),
+			[=](const blocked_range<int>& r) {
+				for (int y = r.begin(); y != r.end(); y++)
+					RowKernel(GetImageRow(Source, y), GetImageRow(YImage, y), Source.Width, 1, PixelOffset);
+			}
+			);
+		return true;
+	}
+
+	CoalesceRows(Source, YImage);
+	int ColumnBlocks = (Source.Width + PixelAlignment - 1) / PixelAlignment;
+	parallel_for( blocked_range2d<int,int>( 0, Source.Height, 0, ColumnBlocks),
+	    [=](const blocked_range2d<int,int>& r) {
+			int StartX = r.cols().begin() * PixelAlignment;
+			int StopX = std::min(r.cols().end() * PixelAlignment, Source.Width);
+			for (int y = r.rows().begin(); y != r.rows().end(); y++)
+			{
+				unsigned char *LocalSourceImagePtr = GetImageRow(Source, y) + StartX * PixelOffset;
+				unsigned char *LocalYImagePtr = GetImageRow(YImage, y) + StartX;
+				RowKernel(LocalSourceImagePtr, LocalYImagePtr, StopX - StartX, 1, PixelOffset);
+			}
+	      }
+	    );
+	return true;
+}
+
+// ImageDescriptor versions of the kernels
+// the serial and SIMD kernels are applied row by row, the scalar TBB variants share the same tiled driver
+// since with padded rows they only differ in the shape of their ranges
+
+bool ProcessRGBSerial(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, GetSerialKernel(Source.Format));
+}
+
+bool ProcessRGBTBB1(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, GetSerialKernel(Source.Format), 1);
+}
+
+bool ProcessRGBTBB2(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, GetSerialKernel(Source.Format), 1);
+}
+
+bool ProcessRGBTBB3(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, GetSerialKernel(Source.Format), 1);
+}
+
+bool ProcessRGBSIMD(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<15, ISASSSE3>(Source, &ProcessRGBSIMD));
+}
+
+bool ProcessRGBSIMD2(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<15, ISASSSE3>(Source, &ProcessRGBSIMD2));
+}
+
+bool ProcessRGBSIMD3(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<7, ISASSSE3>(Source, &ProcessRGBSIMD3));
+}
+
+bool ProcessRGBTBBSIMD(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, SelectRowKernel<15, ISASSSE3>(Source, &ProcessRGBSIMD2), 4);
+}
+
+bool ProcessRGBSSSE3FastRounded(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<8, ISASSSE3>(Source, &ProcessRGBSSSE3FastRounded));
+}
+
+bool ProcessRGBAVX2(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<15, ISAAVX2>(Source, &ProcessRGBAVX2));
+}
+
+bool ProcessRGBAVX2Fast(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<7, ISAAVX2>(Source, &ProcessRGBAVX2Fast));
+}
+
+bool ProcessRGBAVX2FastRounded(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<8, ISAAVX2>(Source, &ProcessRGBAVX2FastRounded));
+}
+
+bool ProcessRGBAVX512(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<15, ISAAVX512>(Source, &ProcessRGBAVX512));
+}
+
+bool ProcessRGBAVX512Fast(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<7, ISAAVX512>(Source, &ProcessRGBAVX512Fast));
+}
+
+bool ProcessRGBAVX512FastRounded(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectRowKernel<8, ISAAVX512>(Source, &ProcessRGBAVX512FastRounded));
+}
+
+bool ProcessRGBTBBAVX2(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, SelectRowKernel<15, ISAAVX2>(Source, &ProcessRGBAVX2), 32);
+}
+
+bool ProcessRGBTBBAVX512(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, SelectRowKernel<15, ISAAVX512>(Source, &ProcessRGBAVX512), 32);
+}
+
+bool ProcessRGBSIMDAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectAutoRowKernel<15>(Source, &ProcessRGBSIMDAuto));
+}
+
+bool ProcessRGBSIMDFastAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectAutoRowKernel<7>(Source, &ProcessRGBSIMDFastAuto));
+}
+
+bool ProcessRGBSIMDFastRoundedAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ProcessImageRows(Source, YImage, SelectAutoRowKernel<8>(Source, &ProcessRGBSIMDFastRoundedAuto));
+}
+
+bool ProcessRGBTBBSIMDAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ParallelProcessImage(Source, YImage, SelectAutoRowKernel<15>(Source, &ProcessRGBSIMDAuto), 32);
+}
+
+// ConvertToLuma
+// converts an image with any RGB pixel format, coefficient set and precision, using the widest instruction set available
+
+bool ConvertToLuma(const ImageDescriptor &Source, const ImageDescriptor &YImage, LumaCoefficients Coefficients, bool ReducedPrecision, bool Parallel)
+{
+	ProcessRGBFunction RowKernel = GetLumaFunction(Source.Format, Coefficients, ReducedPrecision, LUMA_ISA_BEST, false);
+	if (Parallel)
+		return ParallelProcessImage(Source, YImage, RowKernel, ISAAVX2::PixelBlock);
+	return ProcessImageRows(Source, YImage, RowKernel);
+}
@@ -0,0 +1,55 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+// layout of the pixels in memory, channels are listed from the lowest address
+enum PixelFormat {
+	PIXEL_FORMAT_Y8,		//< luma only, 1 byte per pixel
+	PIXEL_FORMAT_RGB24,		//< 3 bytes per pixel
+	PIXEL_FORMAT_RGBA32,	//< 4 bytes per pixel
+	PIXEL_FORMAT_BGR24,		//< 3 bytes per pixel
+	PIXEL_FORMAT_BGRA32,	//< 4 bytes per pixel
+	PIXEL_FORMAT_ARGB32,	//< 4 bytes per pixel
+	PIXEL_FORMAT_RGBA64,	//< 8 bytes per pixel, 16-bit unsigned channels holding 10, 12 or 16 significant bits
+	PIXEL_FORMAT_RGBA64F,	//< 8 bytes per pixel, half precision float channels, 0.0 to 1.0 is the nominal range
+	PIXEL_FORMAT_Y16		//< luma only, 2 bytes per pixel
+};
+
+// ImageDescriptor
+// describes an image that is not owned by the descriptor, e.g. a capture buffer
+// Stride is the distance in bytes between the first pixels of two consecutive rows, it can be larger than
+// Width * pixel size when rows are padded, or negative for bottom-up images (Data then points to the top row)
+
+struct ImageDescriptor {
+	unsigned char *Data;
+	int Width;
+	int Height;
+	int Stride;
+	PixelFormat Format;
+};
+
+int GetPixelSize(PixelFormat Format);
+// true for the 8-bit RGB formats, in any channel order, that the luma kernels convert
+bool IsRGB8Format(PixelFormat Format);
+// name of the enumerator without the PIXEL_FORMAT_ prefix, e.g. "RGBA32"
+const char *GetPixelFormatName(PixelFormat Format);
+// a Stride of 0 means that rows are tightly packed
+ImageDescriptor MakeImageDescriptor(void *Data, int Width, int Height, PixelFormat Format, int Stride = 0);
+
+inline unsigned char *GetImageRow(const ImageDescriptor &Image, int Row)
+{
+	return Image.Data + (long long)Row * Image.Stride;
+}
+
+inline bool IsImagePacked(const ImageDescriptor &Image)
+{
+	return Image.Stride == Image.Width * GetPixelSize(Image.Format);
+}
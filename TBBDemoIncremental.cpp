@@ -0,0 +1,196 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBDemoIncremental.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+using namespace tbb;
+
+const int INCREMENTAL_TILE_WIDTH = 128;
+const int INCREMENTAL_TILE_HEIGHT = 32;
+
+// constants of the fingerprint, the multiplier is odd so that each step is a bijection of the word it mixes in
+const unsigned long long FINGERPRINT_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+const unsigned long long FINGERPRINT_SEEDS[4] = { 0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL };
+
+TileSettings GetDefaultIncrementalTileSettings()
+{
+	TileSettings Tiles;
+	Tiles.TileWidth = INCREMENTAL_TILE_WIDTH;
+	Tiles.TileHeight = INCREMENTAL_TILE_HEIGHT;
+	return Tiles;
+}
+
+IncrementalConverter::IncrementalConverter(int Width, int Height, PixelFormat Format, const TileSettings &Tiles, LumaCoefficients Coefficients) :
+	Width(Width), Height(Height), Format(Format), Tiles(Tiles), TileColumns(0), TileRows(0), Kernel(0)
+{
+	// the settings come from the caller, so they are checked in Release builds too: without a kernel the converter
+	// is not valid and every call to Convert fails
+	if (!IsRGB8Format(Format) || (Width < 0) || (Height < 0) || (Tiles.TileWidth <= 0) || (Tiles.TileHeight <= 0))
+		return;
+	TileColumns = (Width + Tiles.TileWidth - 1) / Tiles.TileWidth;
+	TileRows = (Height + Tiles.TileHeight - 1) / Tiles.TileHeight;
+	Kernel = GetLumaFunction(Format, Coefficients, false, LUMA_ISA_BEST, false);
+	Fingerprints.resize(GetTileCount());
+	FingerprintValid.resize(GetTileCount(), 0);
+}
+
+void IncrementalConverter::Reset()
+{
+	std::fill(FingerprintValid.begin(), FingerprintValid.end(), 0);
+}
+
+// IncrementalConverter::CheckImages
+// the frames must have the size and the format given to the constructor, since the tiles and the fingerprints are
+// laid out for them; a different frame would be read and written out of bounds
+
+bool IncrementalConverter::CheckImages(const ImageDescriptor &Source, const ImageDescriptor &YImage) const
+{
+	if (!IsValid())
+		return false;
+	if ((Source.Format != Format) || (Source.Width != Width) || (Source.Height != Height))
+		return false;
+	return (YImage.Format == PIXEL_FORMAT_Y8) && (YImage.Width == Width) && (YImage.Height == Height);
+}
+
+// MixWord
+// one step of a lane of the fingerprint
+
+static inline unsigned long long MixWord(unsigned long long Lane, unsigned long long Word)
+{
+	return (Lane ^ Word) * FINGERPRINT_MULTIPLIER;
+}
+
+// IncrementalConverter::FingerprintTile
+// the bytes of each row of the tile are read as 64-bit words spread over 4 independent lanes, so that the latency
+// of the multiplies overlaps; the words left after the last group of 4 and the final partial word, padded with
+// zeros, go to the first lane; every step and the final combination are bijections of a single word, which is
+// why a change of one word cannot be missed
+
+unsigned long long IncrementalConverter::FingerprintTile(const ImageDescriptor &Source, int Tile) const
+{
+	const int PixelSize = GetPixelSize(Format);
+	const int TileRow = Tile / TileColumns;
+	const int TileColumn = Tile % TileColumns;
+	const int StartX = TileColumn * Tiles.TileWidth;
+	const int RowBytes = (std::min(StartX + Tiles.TileWidth, Width) - StartX) * PixelSize;
+	const int StartY = TileRow * Tiles.TileHeight;
+	const int StopY = std::min(StartY + Tiles.TileHeight, Height);
+
+	unsigned long long Lanes[4] = { FINGERPRINT_SEEDS[0], FINGERPRINT_SEEDS[1], FINGERPRINT_SEEDS[2], FINGERPRINT_SEEDS[3] };
+	for (int y = StartY; y < StopY; y++)
+	{
+		const unsigned char *RowPtr = GetImageRow(Source, y) + StartX * PixelSize;
+		int i = 0;
+		for (; i + 32 <= RowBytes; i += 32)
+		{
+			unsigned long long Words[4];
+			memcpy(Words, RowPtr + i, sizeof(Words));
+			Lanes[0] = MixWord(Lanes[0], Words[0]);
+			Lanes[1] = MixWord(Lanes[1], Words[1]);
+			Lanes[2] = MixWord(Lanes[2], Words[2]);
+			Lanes[3] = MixWord(Lanes[3], Words[3]);
+		}
+		for (; i < RowBytes; i += 8)
+		{
+			unsigned long long Word = 0;
+			memcpy(&Word, RowPtr + i, std::min(8, RowBytes - i));
+			Lanes[0] = MixWord(Lanes[0], Word);
+		}
+	}
+	unsigned long long Fingerprint = Lanes[0] ^ ((Lanes[1] << 16) | (Lanes[1] >> 48)) ^
+		((Lanes[2] << 32) | (Lanes[2] >> 32)) ^ ((Lanes[3] << 48) | (Lanes[3] >> 16));
+	Fingerprint ^= Fingerprint >> 29;
+	return Fingerprint * FINGERPRINT_MULTIPLIER;
+}
+
+// IncrementalConverter::ConvertTile
+// the widest SIMD kernel is applied to each row of the tile
+
+void IncrementalConverter::ConvertTile(const ImageDescriptor &Source, const ImageDescriptor &YImage, int Tile) const
+{
+	const int PixelSize = GetPixelSize(Format);
+	const int TileRow = Tile / TileColumns;
+	const int TileColumn = Tile % TileColumns;
+	const int StartX = TileColumn * Tiles.TileWidth;
+	const int PixelCount = std::min(StartX + Tiles.TileWidth, Width) - StartX;
+	const int StartY = TileRow * Tiles.TileHeight;
+	const int StopY = std::min(StartY + Tiles.TileHeight, Height);
+	for (int y = StartY; y < StopY; y++)
+		Kernel(GetImageRow(Source, y) + StartX * PixelSize, GetImageRow(YImage, y) + StartX, PixelCount, 1, PixelSize);
+}
+
+int IncrementalConverter::Convert(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	if (!CheckImages(Source, YImage))
+		return -1;
+	std::atomic<int> ConvertedTiles(0);
+
+	parallel_for( blocked_range<int>( 0, GetTileCount()),
+		[&](const blocked_range<int>& r) {
+			int LocalConvertedTiles = 0;
+			for (int Tile = r.begin(); Tile != r.end(); Tile++)
+			{
+				const unsigned long long Fingerprint = FingerprintTile(Source, Tile);
+				if (FingerprintValid[Tile] && (Fingerprints[Tile] == Fingerprint))
+					continue;
+				ConvertTile(Source, YImage, Tile);
+				Fingerprints[Tile] = Fingerprint;
+				FingerprintValid[Tile] = 1;
+				LocalConvertedTiles++;
+			}
+			ConvertedTiles += LocalConvertedTiles;
+		}
+		);
+	return ConvertedTiles;
+}
+
+int IncrementalConverter::Convert(const ImageDescriptor &Source, const ImageDescriptor &YImage, const DirtyRect *Rects, int RectCount)
+{
+	if (!CheckImages(Source, YImage))
+		return -1;
+
+	// tiles touched by the rectangles clipped to the frame, listed once each and in memory order, since converting
+	// them in the order of the rectangles would jump across the frame
+	std::vector<char> Dirty(GetTileCount(), 0);
+	for (int i = 0; i < RectCount; i++)
+	{
+		const int StartX = std::max(Rects[i].X, 0);
+		const int StopX = std::min(Rects[i].X + Rects[i].Width, Width);
+		const int StartY = std::max(Rects[i].Y, 0);
+		const int StopY = std::min(Rects[i].Y + Rects[i].Height, Height);
+		if ((StartX >= StopX) || (StartY >= StopY))
+			continue;
+		for (int TileRow = StartY / Tiles.TileHeight; TileRow <= (StopY - 1) / Tiles.TileHeight; TileRow++)
+			for (int TileColumn = StartX / Tiles.TileWidth; TileColumn <= (StopX - 1) / Tiles.TileWidth; TileColumn++)
+				Dirty[TileRow * TileColumns + TileColumn] = 1;
+	}
+	std::vector<int> DirtyTiles;
+	for (int Tile = 0; Tile < GetTileCount(); Tile++)
+		if (Dirty[Tile])
+			DirtyTiles.push_back(Tile);
+
+	parallel_for( blocked_range<int>( 0, (int)DirtyTiles.size()),
+		[&](const blocked_range<int>& r) {
+			for (int i = r.begin(); i != r.end(); i++)
+			{
+				ConvertTile(Source, YImage, DirtyTiles[i]);
+				FingerprintValid[DirtyTiles[i]] = 0;
+			}
+		}
+		);
+	return (int)DirtyTiles.size();
+}
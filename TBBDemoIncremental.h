@@ -0,0 +1,71 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+#include "TBBDemoTiling.h"
+
+#include <vector>
+
+// rectangle of pixels of a frame that the caller knows to have changed, e.g. from the damage list of a screen capture
+struct DirtyRect {
+	int X;
+	int Y;
+	int Width;
+	int Height;
+};
+
+// GetDefaultIncrementalTileSettings
+// 128x32 tiles: 16 KB of RGBA pixels, small enough to follow the changed areas of a frame closely and large enough
+// for the cost of a task and of a fingerprint comparison to stay negligible
+TileSettings GetDefaultIncrementalTileSettings();
+
+// IncrementalConverter
+// converts a stream of frames of the same size and pixel format to luma, reconverting only the tiles whose pixels
+// changed since the previous frame; the luma image passed to Convert must hold the result of the previous call,
+// i.e. the caller keeps a single luma buffer for the stream, and Reset must be called when it does not
+// each tile has a 64-bit fingerprint of its source bytes: a change confined to one 64-bit word of a tile is always
+// detected, larger changes go undetected with a probability of about 2^-64
+// the converter is not valid when the format is not one of the 8-bit RGB formats or the tiles are empty
+class IncrementalConverter {
+public:
+	IncrementalConverter(int Width, int Height, PixelFormat Format, const TileSettings &Tiles = GetDefaultIncrementalTileSettings(),
+						 LumaCoefficients Coefficients = LUMA_BT601);
+
+	// fingerprints every tile and converts in the same task the tiles that changed, while their pixels are in the cache
+	// returns the number of tiles converted, all of them for the first frame, or -1 when the converter is not valid or
+	// the images do not have the size and the format of the stream
+	int Convert(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+	// converts only the tiles that intersect Rects, without reading the others; the fingerprints of the converted
+	// tiles are not computed, so the next call without rectangles converts them again; returns -1 as the other overload
+	int Convert(const ImageDescriptor &Source, const ImageDescriptor &YImage, const DirtyRect *Rects, int RectCount);
+	// the next frame is converted in full
+	void Reset();
+
+	bool IsValid() const { return Kernel != 0; }
+	int GetTileCount() const { return TileColumns * TileRows; }
+
+private:
+	bool CheckImages(const ImageDescriptor &Source, const ImageDescriptor &YImage) const;
+	void ConvertTile(const ImageDescriptor &Source, const ImageDescriptor &YImage, int Tile) const;
+	unsigned long long FingerprintTile(const ImageDescriptor &Source, int Tile) const;
+
+	int Width;
+	int Height;
+	PixelFormat Format;
+	TileSettings Tiles;
+	int TileColumns;
+	int TileRows;
+	LumaFunction Kernel;
+	std::vector<unsigned long long> Fingerprints;
+	std::vector<char> FingerprintValid;			//< char instead of bool, since each element is written by its own task
+};
@@ -0,0 +1,262 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBDemoCPU.h"
+#include "TBBDemoKernel.h"
+#include "TBBDemoKernelInstances.h"
+#include "TBBDemoRoutines.h"
+
+#include <algorithm>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+using namespace tbb;
+
+// RunKernel
+// store policies select the kernel entry point, execution policies split the work: the TBB one splits the range in blocks of PixelBlock pixels, the ones processed by each loop of
+// the kernel, so that chunk boundaries never fall inside a SIMD register and only the last chunk has a tail
+
+template <class Kernel>
+static inline void RunKernelChunk(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount, StoreCached)
+{
+	Kernel::Process(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+template <class Kernel>
+static inline void RunKernelChunk(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount, StoreNonTemporal)
+{
+	Kernel::ProcessNonTemporal(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+template <class Kernel, class Store>
+static void RunKernel(unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount, int, int, ExecutionSerial)
+{
+	RunKernelChunk<Kernel>(SourceImagePtr, YImagePtr, PixelCount, Store());
+}
+
+template <class Kernel, class Store>
+static void RunKernel(unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount, int PixelSize, int PixelBlock, ExecutionTBB)
+{
+	parallel_for( blocked_range<int>( 0, (PixelCount + PixelBlock - 1) / PixelBlock),
+	    [=](const blocked_range<int>& r) {
+			int StartPixel = r.begin() * PixelBlock;
+			int StopPixel = std::min(r.end() * PixelBlock, PixelCount);
+			RunKernelChunk<Kernel>(SourceImagePtr + StartPixel * PixelSize, YImagePtr + StartPixel, StopPixel - StartPixel, Store());
+	      }
+	    );
+}
+
+template <class Layout, class Coefficients, int SCALING_LOG, class ISA, class Execution, class Store>
+void ProcessLuma(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int)
+{
+	typedef LumaKernel<Layout, FixedPointScales<Coefficients, SCALING_LOG>, ISA> Kernel;
+	RunKernel<Kernel, Store>((unsigned char *)SourceImage, (unsigned char *)YImage, ImageWidth * ImageHeight, Layout::PixelSize, ISA::PixelBlock, Execution());
+}
+
+INSTANTIATE_PROCESS_LUMAS(ISAScalar)
+INSTANTIATE_PROCESS_LUMAS(ISASSSE3)
+INSTANTIATE_PROCESS_LUMAS(ISAAVX2)
+INSTANTIATE_PROCESS_LUMAS(ISAAVX512)
+
+// GetLumaFunction
+// each level of the selection turns one runtime parameter into a template argument
+
+template <class Layout, class Coefficients, int SCALING_LOG, class ISA, class Execution>
+static LumaFunction SelectStore(bool NonTemporal)
+{
+	if (NonTemporal)
+		return &ProcessLuma<Layout, Coefficients, SCALING_LOG, ISA, Execution, StoreNonTemporal>;
+	return &ProcessLuma<Layout, Coefficients, SCALING_LOG, ISA, Execution, StoreCached>;
+}
+
+template <class Layout, class Coefficients, int SCALING_LOG, class ISA>
+static LumaFunction SelectExecution(bool Parallel, bool NonTemporal)
+{
+	if (Parallel)
+		return SelectStore<Layout, Coefficients, SCALING_LOG, ISA, ExecutionTBB>(NonTemporal);
+	return SelectStore<Layout, Coefficients, SCALING_LOG, ISA, ExecutionSerial>(NonTemporal);
+}
+
+template <class Layout, class Coefficients, int SCALING_LOG>
+static LumaFunction SelectISA(LumaISA ISA, bool Parallel, bool NonTemporal)
+{
+	switch (ISA)
+	{
+	case LUMA_ISA_SSSE3:
+		return SelectExecution<Layout, Coefficients, SCALING_LOG, ISASSSE3>(Parallel, NonTemporal);
+	case LUMA_ISA_AVX2:
+		return SelectExecution<Layout, Coefficients, SCALING_LOG, ISAAVX2>(Parallel, NonTemporal);
+	case LUMA_ISA_AVX512:
+		return SelectExecution<Layout, Coefficients, SCALING_LOG, ISAAVX512>(Parallel, NonTemporal);
+	default:
+		return SelectExecution<Layout, Coefficients, SCALING_LOG, ISAScalar>(Parallel, NonTemporal);
+	}
+}
+
+template <class Layout, class Coefficients>
+static LumaFunction SelectPrecision(bool ReducedPrecision, LumaISA ISA, bool Parallel, bool NonTemporal)
+{
+	if (ReducedPrecision)
+		return SelectISA<Layout, Coefficients, 8>(ISA, Parallel, NonTemporal);
+	return SelectISA<Layout, Coefficients, 15>(ISA, Parallel, NonTemporal);
+}
+
+template <class Layout>
+static LumaFunction SelectCoefficients(LumaCoefficients Coefficients, bool ReducedPrecision, LumaISA ISA, bool Parallel, bool NonTemporal)
+{
+	switch (Coefficients)
+	{
+	case LUMA_BT709:
+		return SelectPrecision<Layout, CoefficientsBT709>(ReducedPrecision, ISA, Parallel, NonTemporal);
+	case LUMA_BT2020:
+		return SelectPrecision<Layout, CoefficientsBT2020>(ReducedPrecision, ISA, Parallel, NonTemporal);
+	default:
+		return SelectPrecision<Layout, CoefficientsBT601>(ReducedPrecision, ISA, Parallel, NonTemporal);
+	}
+}
+
+LumaFunction GetLumaFunction(PixelFormat Format, LumaCoefficients Coefficients, bool ReducedPrecision, LumaISA ISA, bool Parallel,
+							 bool NonTemporal)
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (ISA == LUMA_ISA_BEST)
+	{
+		if (Features.AVX512BW)
+			ISA = LUMA_ISA_AVX512;
+		else if (Features.AVX2)
+			ISA = LUMA_ISA_AVX2;
+		else if (Features.SSSE3)
+			ISA = LUMA_ISA_SSSE3;
+		else
+			ISA = LUMA_ISA_SCALAR;
+	}
+	if (((ISA == LUMA_ISA_SSSE3) && !Features.SSSE3) ||
+		((ISA == LUMA_ISA_AVX2) && !Features.AVX2) ||
+		((ISA == LUMA_ISA_AVX512) && !Features.AVX512BW))
+		return 0;
+
+	switch (Format)
+	{
+	case PIXEL_FORMAT_RGB24:
+		return SelectCoefficients<LayoutRGB24>(Coefficients, ReducedPrecision, ISA, Parallel, NonTemporal);
+	case PIXEL_FORMAT_RGBA32:
+		return SelectCoefficients<LayoutRGBA32>(Coefficients, ReducedPrecision, ISA, Parallel, NonTemporal);
+	case PIXEL_FORMAT_BGR24:
+		return SelectCoefficients<LayoutBGR24>(Coefficients, ReducedPrecision, ISA, Parallel, NonTemporal);
+	case PIXEL_FORMAT_BGRA32:
+		return SelectCoefficients<LayoutBGRA32>(Coefficients, ReducedPrecision, ISA, Parallel, NonTemporal);
+	case PIXEL_FORMAT_ARGB32:
+		return SelectCoefficients<LayoutARGB32>(Coefficients, ReducedPrecision, ISA, Parallel, NonTemporal);
+	default:
+		return 0;
+	}
+}
+
+// named instantiations
+// the kernels added after the original ProcessRGB* family are all BT.601 instantiations of ProcessLuma
+
+void ProcessRGBSSSE3FastRounded(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 8, ISASSSE3, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBAVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 15, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBAVX2Fast(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 7, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBAVX2FastRounded(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 8, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBAVX512(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 15, ISAAVX512, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBAVX512Fast(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 7, ISAAVX512, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBAVX512FastRounded(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 8, ISAAVX512, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBTBBAVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 15, ISAAVX2, ExecutionTBB>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGBTBBAVX512(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGBA32, CoefficientsBT601, 15, ISAAVX512, ExecutionTBB>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessBGRSerial(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	if (PixelOffset == 3)
+		ProcessLuma<LayoutBGR24, CoefficientsBT601, 15, ISAScalar, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+	else
+		ProcessLuma<LayoutBGRA32, CoefficientsBT601, 15, ISAScalar, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessARGBSerial(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutARGB32, CoefficientsBT601, 15, ISAScalar, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGB24SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGB24, CoefficientsBT601, 15, ISASSSE3, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessBGR24SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutBGR24, CoefficientsBT601, 15, ISASSSE3, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessBGRA32SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutBGRA32, CoefficientsBT601, 15, ISASSSE3, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessARGB32SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutARGB32, CoefficientsBT601, 15, ISASSSE3, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessRGB24AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutRGB24, CoefficientsBT601, 15, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessBGR24AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutBGR24, CoefficientsBT601, 15, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessBGRA32AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutBGRA32, CoefficientsBT601, 15, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+void ProcessARGB32AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	ProcessLuma<LayoutARGB32, CoefficientsBT601, 15, ISAAVX2, ExecutionSerial>(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
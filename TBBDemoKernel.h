@@ -0,0 +1,251 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include "TBBDemoImage.h"
+
+// luma kernel template
+// every parameter of the conversion is known at compile time, so that each instantiation is a fully specialized loop:
+// - Layout: position of the color channels inside a pixel, and pixel size
+// - Coefficients: luma coefficients of the color standard
+// - SCALING_LOG: fixed-point precision, 15 gives the same results of ProcessRGBSerial, 7 and 8 use 8-bit multiplies,
+//   see FixedPointScales
+// - ISA: instruction set of the inner loop
+// - Execution: serial or multi-threaded with Intel TBB
+// - Store: luma plane written through the cache, or with non-temporal stores when it will not be read again soon
+
+template <int RED_OFFSET, int GREEN_OFFSET, int BLUE_OFFSET, int PIXEL_SIZE>
+struct PixelLayout {
+	static const int RedOffset = RED_OFFSET;
+	static const int GreenOffset = GREEN_OFFSET;
+	static const int BlueOffset = BLUE_OFFSET;
+	static const int PixelSize = PIXEL_SIZE;
+};
+
+typedef PixelLayout<0, 1, 2, 3> LayoutRGB24;
+typedef PixelLayout<0, 1, 2, 4> LayoutRGBA32;
+typedef PixelLayout<2, 1, 0, 3> LayoutBGR24;
+typedef PixelLayout<2, 1, 0, 4> LayoutBGRA32;
+typedef PixelLayout<1, 2, 3, 4> LayoutARGB32;
+
+// Ey = Red*Er + Green*Eg + Blue*Eb
+struct CoefficientsBT601 {
+	static constexpr double Red = 0.299;
+	static constexpr double Green = 0.587;
+	static constexpr double Blue = 0.114;
+};
+
+struct CoefficientsBT709 {
+	static constexpr double Red = 0.2126;
+	static constexpr double Green = 0.7152;
+	static constexpr double Blue = 0.0722;
+};
+
+struct CoefficientsBT2020 {
+	static constexpr double Red = 0.2627;
+	static constexpr double Green = 0.6780;
+	static constexpr double Blue = 0.0593;
+};
+
+// coefficients are truncated like the original Y_RED_SCALE, Y_GREEN_SCALE and Y_BLUE_SCALE constants, so that the
+// BT.601 scales with SCALING_LOG 15 and 7 match the ones of ProcessRGBSerial and ProcessRGBSIMD3
+template <class Coefficients, int SCALING_LOG>
+struct FixedPointScales {
+	static const int ScalingLog = SCALING_LOG;
+	static const int Red = (int)(Coefficients::Red * (1 << SCALING_LOG));
+	static const int Green = (int)(Coefficients::Green * (1 << SCALING_LOG));
+	static const int Blue = (int)(Coefficients::Blue * (1 << SCALING_LOG));
+	static const int Rounding = 1 << (SCALING_LOG - 1);
+	// 8-bit multiplies are used when the scales fit in a signed byte
+	static const bool Reduced = (SCALING_LOG <= 7);
+	static const bool SplitGreen = false;
+};
+
+// GetTruncatedScale, GetScaleRemainder
+// integer and fractional part of a coefficient scaled by 1 << SCALING_LOG
+
+constexpr int GetTruncatedScale(double Coefficient, int SCALING_LOG)
+{
+	return (int)(Coefficient * (1 << SCALING_LOG));
+}
+
+constexpr double GetScaleRemainder(double Coefficient, int SCALING_LOG)
+{
+	return Coefficient * (1 << SCALING_LOG) - GetTruncatedScale(Coefficient, SCALING_LOG);
+}
+
+// FixedPointScales with SCALING_LOG 8
+// the truncated 7-bit scales do not sum to 128, e.g. 37 + 75 + 14 for BT.601, which darkens every pixel and takes
+// up to 4 levels off white; here the scales are rounded so that they sum to 256: the units lost by truncation go to
+// the coefficients with the largest remainders, so no scale is off by more than one unit and the sum of the errors
+// of the scales is 0, which keeps every result within 1 of the SCALING_LOG 15 one
+// the green scale does not fit in a signed byte, so the SIMD kernels duplicate the green channel in the fourth byte
+// of each pixel and split its scale in two: 128 - Red next to red and 128 - Blue next to blue, each pair of
+// _mm_maddubs_epi16 then sums to at most 255 * 128 and never saturates
+template <class Coefficients>
+struct FixedPointScales<Coefficients, 8> {
+	static const int ScalingLog = 8;
+	static const int Deficit = (1 << 8) - GetTruncatedScale(Coefficients::Red, 8) - GetTruncatedScale(Coefficients::Green, 8) -
+							   GetTruncatedScale(Coefficients::Blue, 8);
+	// 0 for the largest remainder, ties are broken in the order red, green, blue
+	static const int RedRank = (GetScaleRemainder(Coefficients::Green, 8) > GetScaleRemainder(Coefficients::Red, 8)) +
+							   (GetScaleRemainder(Coefficients::Blue, 8) > GetScaleRemainder(Coefficients::Red, 8));
+	static const int GreenRank = (GetScaleRemainder(Coefficients::Red, 8) >= GetScaleRemainder(Coefficients::Green, 8)) +
+								 (GetScaleRemainder(Coefficients::Blue, 8) > GetScaleRemainder(Coefficients::Green, 8));
+	static const int BlueRank = (GetScaleRemainder(Coefficients::Red, 8) >= GetScaleRemainder(Coefficients::Blue, 8)) +
+								(GetScaleRemainder(Coefficients::Green, 8) >= GetScaleRemainder(Coefficients::Blue, 8));
+	static const int Red = GetTruncatedScale(Coefficients::Red, 8) + (RedRank < Deficit);
+	static const int Green = GetTruncatedScale(Coefficients::Green, 8) + (GreenRank < Deficit);
+	static const int Blue = GetTruncatedScale(Coefficients::Blue, 8) + (BlueRank < Deficit);
+	static const int Rounding = 1 << 7;
+	static const bool Reduced = true;
+	static const bool SplitGreen = true;
+};
+
+// KernelConstants
+// values of the SIMD kernels that depend only on the template parameters, shared by all the instruction sets that
+// broadcast them to their own registers
+// 24-bit pixels are spread to RGB0 order by the shuffle, 32-bit pixels keep their layout and the channel order is
+// folded into the scales: EvenScale holds the coefficients of bytes 0 and 2 of each pixel, OddScale those of bytes 1 and 3,
+// and the byte that does not hold a color channel has a zero coefficient; ByteScale holds all four as signed bytes
+// with Scales::SplitGreen every pixel is shuffled to RGBG order, 32-bit ones too, and ByteScale holds the two halves
+// of the green scale
+// LaneShuffleMask spreads 4 pixels within a 128-bit lane
+
+template <class Layout, class Scales>
+struct KernelConstants {
+	static const bool Shuffled = (Layout::PixelSize == 3) || Scales::SplitGreen;
+	char LaneShuffleMask[16];
+	int EvenScale;
+	int OddScale;
+	int ByteScale;
+
+	KernelConstants()
+	{
+		int Scales32[4] = { 0, 0, 0, 0 };
+		Scales32[Shuffled ? 0 : Layout::RedOffset] = Scales::Red;
+		Scales32[Shuffled ? 1 : Layout::GreenOffset] = Scales::Green;
+		Scales32[Shuffled ? 2 : Layout::BlueOffset] = Scales::Blue;
+		if (Scales::SplitGreen)
+		{
+			Scales32[1] = 128 - Scales::Red;
+			Scales32[3] = 128 - Scales::Blue;
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			LaneShuffleMask[4 * i] = (char)(i * Layout::PixelSize + Layout::RedOffset);
+			LaneShuffleMask[4 * i + 1] = (char)(i * Layout::PixelSize + Layout::GreenOffset);
+			LaneShuffleMask[4 * i + 2] = (char)(i * Layout::PixelSize + Layout::BlueOffset);
+			LaneShuffleMask[4 * i + 3] = Scales::SplitGreen ? (char)(i * Layout::PixelSize + Layout::GreenOffset) : (char)0x80;
+		}
+		EvenScale = (Scales32[2] << 16) | Scales32[0];
+		OddScale = (Scales32[3] << 16) | Scales32[1];
+		ByteScale = (Scales32[3] << 24) | (Scales32[2] << 16) | (Scales32[1] << 8) | Scales32[0];
+	}
+};
+
+// largest difference from the SCALING_LOG 15 results of the kernels with 8-bit multiplies: with SCALING_LOG 7 the
+// BT.2020 scales lose 2/128 in total, which takes almost 4 levels off a white pixel, and the other sets 1/128
+const int TRUNCATED_SCALES_MAX_ERROR = 4;
+const int ROUNDED_SCALES_MAX_ERROR = 1;
+
+// PixelBlock is the number of pixels converted by each loop of the kernel, parallel ranges are split in multiples of it
+struct ISAScalar { static const int PixelBlock = 1; };
+struct ISASSSE3 { static const int PixelBlock = 16; };
+struct ISAAVX2 { static const int PixelBlock = 32; };
+struct ISAAVX512 { static const int PixelBlock = 32; };
+
+struct ExecutionSerial {};
+struct ExecutionTBB {};
+
+struct StoreCached {};
+struct StoreNonTemporal {};
+
+// LumaKernel
+// converts PixelCount consecutive pixels, the primary template is the scalar version and handles the tails of the
+// SIMD specializations, which are defined in the source file of their instruction set
+// ProcessNonTemporal writes the luma plane with streaming stores that bypass the cache, the scalar version has none
+// and stores normally
+// the SIMD specializations switch to aligned loads when the input pixels are aligned on the register size
+
+template <class Layout, class Scales, class ISA>
+struct LumaKernel {
+	static void Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+	{
+		for (; PixelCount > 0; PixelCount--)
+		{
+			int YValue = (SourceImagePtr[Layout::RedOffset] * Scales::Red  ) +
+						 (SourceImagePtr[Layout::GreenOffset] * Scales::Green) +
+						 (SourceImagePtr[Layout::BlueOffset] * Scales::Blue );
+			SourceImagePtr += Layout::PixelSize;
+			YValue += Scales::Rounding;
+			YValue >>= Scales::ScalingLog;
+			if (YValue > 255)
+				YValue = 255;
+			*YImagePtr = (unsigned char)YValue;
+			YImagePtr++;
+		}
+	}
+
+	static void ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+	{
+		Process(SourceImagePtr, YImagePtr, PixelCount);
+	}
+};
+
+template <class Layout, class Scales>
+struct LumaKernel<Layout, Scales, ISASSSE3> {
+	static void Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount);
+	static void ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount);
+};
+
+template <class Layout, class Scales>
+struct LumaKernel<Layout, Scales, ISAAVX2> {
+	static void Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount);
+	static void ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount);
+};
+
+template <class Layout, class Scales>
+struct LumaKernel<Layout, Scales, ISAAVX512> {
+	static void Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount);
+	static void ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount);
+};
+
+// ProcessLuma
+// entry point with the same signature of the ProcessRGB* functions, PixelOffset is implied by Layout and ignored
+// instantiated in TBBDemoKernel.cpp for every layout, coefficient set, precision, instruction set, execution policy
+// and store policy
+
+template <class Layout, class Coefficients, int SCALING_LOG, class ISA, class Execution, class Store = StoreCached>
+void ProcessLuma(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// runtime selection of an instantiation
+
+enum LumaCoefficients {
+	LUMA_BT601,
+	LUMA_BT709,
+	LUMA_BT2020
+};
+
+enum LumaISA {
+	LUMA_ISA_SCALAR,
+	LUMA_ISA_SSSE3,
+	LUMA_ISA_AVX2,
+	LUMA_ISA_AVX512,
+	LUMA_ISA_BEST			//< widest instruction set supported by the CPU
+};
+
+typedef void (*LumaFunction)(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// ReducedPrecision selects the 8-bit multiplies with rounded scales, within ROUNDED_SCALES_MAX_ERROR of the full precision
+// returns 0 when the format is not an RGB one or the instruction set is not supported by the CPU
+LumaFunction GetLumaFunction(PixelFormat Format, LumaCoefficients Coefficients, bool ReducedPrecision, LumaISA ISA, bool Parallel,
+							 bool NonTemporal = false);
@@ -0,0 +1,44 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+// list of the explicit instantiations of LumaKernel and ProcessLuma
+// every layout is instantiated with every coefficient set, in full (SCALING_LOG 15) and reduced precision with rounded
+// scales (SCALING_LOG 8); the truncated scales (SCALING_LOG 7) of the original ProcessRGBSIMD3 are kept for BT.601
+
+#define LUMA_FOR_EACH_SCALES(MACRO, Layout, ISA) \
+	MACRO(Layout, CoefficientsBT601, 15, ISA) \
+	MACRO(Layout, CoefficientsBT601, 8, ISA) \
+	MACRO(Layout, CoefficientsBT601, 7, ISA) \
+	MACRO(Layout, CoefficientsBT709, 15, ISA) \
+	MACRO(Layout, CoefficientsBT709, 8, ISA) \
+	MACRO(Layout, CoefficientsBT2020, 15, ISA) \
+	MACRO(Layout, CoefficientsBT2020, 8, ISA)
+
+#define LUMA_FOR_EACH_VARIANT(MACRO, ISA) \
+	LUMA_FOR_EACH_SCALES(MACRO, LayoutRGB24, ISA) \
+	LUMA_FOR_EACH_SCALES(MACRO, LayoutRGBA32, ISA) \
+	LUMA_FOR_EACH_SCALES(MACRO, LayoutBGR24, ISA) \
+	LUMA_FOR_EACH_SCALES(MACRO, LayoutBGRA32, ISA) \
+	LUMA_FOR_EACH_SCALES(MACRO, LayoutARGB32, ISA)
+
+#define INSTANTIATE_LUMA_KERNEL(Layout, Coefficients, SCALING_LOG, ISA) \
+	template struct LumaKernel<Layout, FixedPointScales<Coefficients, SCALING_LOG>, ISA>;
+
+#define INSTANTIATE_LUMA_KERNELS(ISA) LUMA_FOR_EACH_VARIANT(INSTANTIATE_LUMA_KERNEL, ISA)
+
+#define INSTANTIATE_PROCESS_LUMA(Layout, Coefficients, SCALING_LOG, ISA) \
+	template void ProcessLuma<Layout, Coefficients, SCALING_LOG, ISA, ExecutionSerial, StoreCached>(void *, void *, int, int, int); \
+	template void ProcessLuma<Layout, Coefficients, SCALING_LOG, ISA, ExecutionTBB, StoreCached>(void *, void *, int, int, int); \
+	template void ProcessLuma<Layout, Coefficients, SCALING_LOG, ISA, ExecutionSerial, StoreNonTemporal>(void *, void *, int, int, int); \
+	template void ProcessLuma<Layout, Coefficients, SCALING_LOG, ISA, ExecutionTBB, StoreNonTemporal>(void *, void *, int, int, int);
+
+#define INSTANTIATE_PROCESS_LUMAS(ISA) LUMA_FOR_EACH_VARIANT(INSTANTIATE_PROCESS_LUMA, ISA)
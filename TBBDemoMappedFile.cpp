@@ -0,0 +1,163 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoMappedFile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+// InitMappedFile
+// marks all the handles as invalid, so that CloseMappedFile can be called on a partially opened file
+
+static void InitMappedFile(MappedFile &File)
+{
+	File.Data = 0;
+	File.Size = 0;
+	File.File = INVALID_HANDLE_VALUE;
+	File.Mapping = 0;
+}
+
+// MapFile
+// Windows has no equivalent of madvise for mapped files, FILE_FLAG_SEQUENTIAL_SCAN gives the cache manager the
+// same hint about the access pattern
+
+static bool MapFile(MappedFile &File, DWORD Protection, DWORD Access)
+{
+	ULARGE_INTEGER MappingSize;
+	MappingSize.QuadPart = File.Size;
+	File.Mapping = CreateFileMapping(File.File, 0, Protection, MappingSize.HighPart, MappingSize.LowPart, 0);
+	if (File.Mapping == 0)
+		return false;
+	File.Data = (unsigned char *)MapViewOfFile(File.Mapping, Access, 0, 0, File.Size);
+	return (File.Data != 0);
+}
+
+bool OpenMappedFile(const _TCHAR *FileName, MappedFile &File)
+{
+	InitMappedFile(File);
+	File.File = CreateFile(FileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	LARGE_INTEGER FileSize;
+	if ((File.File == INVALID_HANDLE_VALUE) || !GetFileSizeEx(File.File, &FileSize) || (FileSize.QuadPart == 0) ||
+		((ULONGLONG)FileSize.QuadPart > (size_t)-1))
+	{
+		CloseMappedFile(File);
+		return false;
+	}
+	File.Size = (size_t)FileSize.QuadPart;
+	if (!MapFile(File, PAGE_READONLY, FILE_MAP_READ))
+	{
+		CloseMappedFile(File);
+		return false;
+	}
+	return true;
+}
+
+bool CreateMappedFile(const _TCHAR *FileName, size_t Size, MappedFile &File)
+{
+	InitMappedFile(File);
+	if (Size == 0)
+		return false;
+	File.File = CreateFile(FileName, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	File.Size = Size;
+	if ((File.File == INVALID_HANDLE_VALUE) || !MapFile(File, PAGE_READWRITE, FILE_MAP_WRITE))
+	{
+		CloseMappedFile(File);
+		return false;
+	}
+	return true;
+}
+
+void CloseMappedFile(MappedFile &File)
+{
+	if (File.Data != 0)
+		UnmapViewOfFile(File.Data);
+	if (File.Mapping != 0)
+		CloseHandle(File.Mapping);
+	if (File.File != INVALID_HANDLE_VALUE)
+		CloseHandle(File.File);
+	InitMappedFile(File);
+}
+
+#else
+
+// InitMappedFile
+// marks the descriptor as invalid, so that CloseMappedFile can be called on a partially opened file
+
+static void InitMappedFile(MappedFile &File)
+{
+	File.Data = 0;
+	File.Size = 0;
+	File.File = -1;
+}
+
+// MapFile
+// MADV_SEQUENTIAL lets the kernel read ahead aggressively and drop the pages already processed
+
+static bool MapFile(MappedFile &File, int Protection)
+{
+	void *Data = mmap(0, File.Size, Protection, MAP_SHARED, File.File, 0);
+	if (Data == MAP_FAILED)
+		return false;
+	File.Data = (unsigned char *)Data;
+	madvise(Data, File.Size, MADV_SEQUENTIAL);
+	return true;
+}
+
+bool OpenMappedFile(const _TCHAR *FileName, MappedFile &File)
+{
+	InitMappedFile(File);
+	File.File = open(FileName, O_RDONLY);
+	struct stat FileStatus;
+	if ((File.File < 0) || (fstat(File.File, &FileStatus) != 0) || (FileStatus.st_size <= 0))
+	{
+		CloseMappedFile(File);
+		return false;
+	}
+	File.Size = (size_t)FileStatus.st_size;
+	if (!MapFile(File, PROT_READ))
+	{
+		CloseMappedFile(File);
+		return false;
+	}
+	return true;
+}
+
+bool CreateMappedFile(const _TCHAR *FileName, size_t Size, MappedFile &File)
+{
+	InitMappedFile(File);
+	if (Size == 0)
+		return false;
+	File.File = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	File.Size = Size;
+	if ((File.File < 0) || (ftruncate(File.File, (off_t)Size) != 0) || !MapFile(File, PROT_READ | PROT_WRITE))
+	{
+		CloseMappedFile(File);
+		return false;
+	}
+	return true;
+}
+
+void CloseMappedFile(MappedFile &File)
+{
+	if (File.Data != 0)
+		munmap(File.Data, File.Size);
+	if (File.File >= 0)
+		close(File.File);
+	InitMappedFile(File);
+}
+
+#endif
@@ -0,0 +1,38 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include <stddef.h>
+#include "stdafx.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+// file mapped in memory, read-only for the input images and read-write for the output ones
+struct MappedFile {
+	unsigned char *Data;
+	size_t Size;
+#if defined(_WIN32)
+	HANDLE File;
+	HANDLE Mapping;
+#else
+	int File;
+#endif
+};
+
+// maps an existing file for sequential reading, returns false if it cannot be opened or is empty
+bool OpenMappedFile(const _TCHAR *FileName, MappedFile &File);
+// creates or truncates a file of Size bytes and maps it for sequential writing
+bool CreateMappedFile(const _TCHAR *FileName, size_t Size, MappedFile &File);
+// unmaps the file and closes it, the pages written are flushed to disk by the operating system
+void CloseMappedFile(MappedFile &File);
@@ -0,0 +1,144 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBBenchmark.h"
+#include "TBBDemoNUMA.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+#include <task_arena.h>
+#include <task_group.h>
+#include <info.h>
+using namespace tbb;
+
+// rows converted by each task, the same for the first touch and the conversion, so that with the static partitioner
+// each page is touched by the thread that later converts it
+const int NUMA_ROW_GRAIN = 8;
+
+// NUMASliceArena
+// tbb::task_arena is an alias of a class of an internal namespace, so the header cannot forward-declare it
+
+struct NUMASliceArena {
+	explicit NUMASliceArena(const task_arena::constraints &Constraints) : Arena(Constraints) {}
+	explicit NUMASliceArena(int Threads) : Arena(Threads) {}
+	task_arena Arena;
+};
+
+// NUMAConverter::NUMAConverter
+// rows are distributed in proportion to the threads of each node, every slice but the last one gets its rounded share
+
+NUMAConverter::NUMAConverter(int ImageWidth, int ImageHeight) : ImageWidth(ImageWidth), ImageHeight(ImageHeight)
+{
+	std::vector<numa_node_id> Nodes = info::numa_nodes();
+	int TotalThreads = 0;
+	for (size_t i = 0; i < Nodes.size(); i++)
+	{
+		NUMASlice Slice;
+		Slice.NodeId = Nodes[i];
+		Slice.Threads = std::max(1, info::default_concurrency(Nodes[i]));
+		Slice.StartRow = 0;
+		Slice.StopRow = 0;
+		Slices.push_back(Slice);
+		TotalThreads += Slice.Threads;
+	}
+	int ThreadsBefore = 0;
+	for (size_t i = 0; i < Slices.size(); i++)
+	{
+		Slices[i].StartRow = (i == 0) ? 0 : Slices[i - 1].StopRow;
+		ThreadsBefore += Slices[i].Threads;
+		Slices[i].StopRow = (i + 1 == Slices.size()) ? ImageHeight : (int)(((long long)ImageHeight * ThreadsBefore) / TotalThreads);
+		if (Slices[i].NodeId >= 0)
+			Arenas.emplace_back(new NUMASliceArena(task_arena::constraints(Slices[i].NodeId, Slices[i].Threads)));
+		else
+			Arenas.emplace_back(new NUMASliceArena(Slices[i].Threads));
+	}
+}
+
+// NUMAConverter::~NUMAConverter
+// defined here, where NUMASliceArena is complete
+
+NUMAConverter::~NUMAConverter()
+{
+}
+
+// NUMAConverter::AllocateImage
+// large allocations are served by fresh pages of the operating system, which are assigned to a node only when touched
+
+unsigned char *NUMAConverter::AllocateImage(int ImageWidth, int ImageHeight, int PixelSize)
+{
+	return new unsigned char[(size_t)ImageWidth * ImageHeight * PixelSize];
+}
+
+void NUMAConverter::FreeImage(unsigned char *Image)
+{
+	delete[] Image;
+}
+
+// RunOnSlices
+// starts the work of every slice in its arena and then waits for all of them, so that the nodes run concurrently
+// SliceFunction is called with the slice and a range of rows of it, inside the arena of the slice
+
+template <class SliceFunction>
+static void RunOnSlices(const std::vector<NUMASlice> &Slices, const std::vector<std::unique_ptr<NUMASliceArena> > &Arenas,
+						const SliceFunction &Function)
+{
+	std::vector<task_group> TaskGroups(Slices.size());
+	for (size_t i = 0; i < Slices.size(); i++)
+	{
+		const NUMASlice &Slice = Slices[i];
+		task_group &TaskGroup = TaskGroups[i];
+		Arenas[i]->Arena.execute([&Slice, &TaskGroup, &Function]() {
+			TaskGroup.run([&Slice, &Function]() {
+				parallel_for( blocked_range<int>( Slice.StartRow, Slice.StopRow, NUMA_ROW_GRAIN),
+				    [&Slice, &Function](const blocked_range<int>& r) {
+						Function(Slice, r.begin(), r.end());
+				      },
+				    static_partitioner());
+			});
+		});
+	}
+	for (size_t i = 0; i < Slices.size(); i++)
+	{
+		task_group &TaskGroup = TaskGroups[i];
+		Arenas[i]->Arena.execute([&TaskGroup]() {
+			TaskGroup.wait();
+		});
+	}
+}
+
+// NUMAConverter::FillImages
+// each row is filled with its own seed, so that the image does not depend on which thread fills which rows
+
+void NUMAConverter::FillImages(unsigned char *RGBAImage, unsigned char *YImage) const
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const int Width = ImageWidth;
+	RunOnSlices(Slices, Arenas, [=](const NUMASlice &, int StartRow, int StopRow) {
+		for (int y = StartRow; y < StopRow; y++)
+		{
+			FillRandomImage(RGBAImage + (size_t)y * Width * RGBA_PIXEL_SIZE, (size_t)Width * RGBA_PIXEL_SIZE, 0x5555u + (unsigned int)y * 2654435761u);
+			memset(YImage + (size_t)y * Width, 0, Width);
+		}
+	});
+}
+
+void NUMAConverter::Convert(LumaFunction Kernel, unsigned char *RGBAImage, unsigned char *YImage) const
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const int Width = ImageWidth;
+	RunOnSlices(Slices, Arenas, [=](const NUMASlice &, int StartRow, int StopRow) {
+		Kernel(RGBAImage + (size_t)StartRow * Width * RGBA_PIXEL_SIZE, YImage + (size_t)StartRow * Width, Width, StopRow - StartRow, RGBA_PIXEL_SIZE);
+	});
+}
@@ -0,0 +1,58 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "TBBDemoKernel.h"
+
+// NUMA-aware conversion
+// the image is split in horizontal slices, one per NUMA node and sized by the number of threads of the node; each node
+// has its own task_arena constrained to it, whose threads first touch the pages of the slice, so that the operating
+// system places them on that node, and later convert the same slice, reading and writing only local memory
+// on systems with a single node, or when the TBB NUMA support library is missing, there is one unconstrained arena
+
+struct NUMASlice {
+	int NodeId;			//< -1 when the topology is unknown
+	int Threads;
+	int StartRow;
+	int StopRow;
+};
+
+// task_arena of a slice, defined in TBBDemoNUMA.cpp so that the header does not depend on TBB
+struct NUMASliceArena;
+
+class NUMAConverter {
+public:
+	NUMAConverter(int ImageWidth, int ImageHeight);
+	~NUMAConverter();
+
+	const std::vector<NUMASlice> &GetSlices() const { return Slices; }
+	// allocates an image without touching its pages, they are placed by the first write
+	static unsigned char *AllocateImage(int ImageWidth, int ImageHeight, int PixelSize);
+	static void FreeImage(unsigned char *Image);
+	// writes every slice from the threads of its node, with the partitioning used by Convert; the RGBA image is
+	// filled with pseudo-random data that depends only on the position of each pixel, the luma one is cleared
+	void FillImages(unsigned char *RGBAImage, unsigned char *YImage) const;
+	// converts every slice with the threads of its node, Kernel must be a single-threaded one
+	void Convert(LumaFunction Kernel, unsigned char *RGBAImage, unsigned char *YImage) const;
+
+private:
+	NUMAConverter(const NUMAConverter &);
+	NUMAConverter &operator=(const NUMAConverter &);
+
+	int ImageWidth;
+	int ImageHeight;
+	std::vector<NUMASlice> Slices;
+	std::vector<std::unique_ptr<NUMASliceArena> > Arenas;
+};
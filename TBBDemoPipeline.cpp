@@ -0,0 +1,116 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoPipeline.h"
+
+#include <atomic>
+#include <vector>
+
+// Intel TBB library
+#include <parallel_pipeline.h>
+#include <concurrent_queue.h>
+#include <tick_count.h>
+using namespace tbb;
+
+// FrameBuffer
+// input and output planes of one frame, allocated once and recycled by the pipeline
+
+struct FrameBuffer {
+	std::vector<unsigned char> RGBAImage;
+	std::vector<unsigned char> YImage;
+};
+
+// RunConversionPipeline
+// three stages: a serial in-order reader, a parallel conversion stage and a serial in-order writer
+// the reader takes its buffers from a pool of BuffersInFlight frames and the writer gives them back, as the pipeline
+// runs with as many tokens as buffers the reader always finds one free and memory stays flat however long the sequence is
+// while a frame is converted the next ones are being read and the previous ones written, so I/O overlaps with compute;
+// the conversion kernel may be a parallel one too, TBB balances the nested parallelism with the other stages
+
+bool RunConversionPipeline(FILE *InputFile, FILE *OutputFile, int ImageWidth, int ImageHeight, int BuffersInFlight,
+						   LumaFunction Kernel, PipelineStatistics &Statistics)
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const size_t ImageSize = (size_t)ImageWidth * ImageHeight;
+
+	Statistics.Frames = 0;
+	Statistics.Seconds = 0.0;
+	Statistics.FramesPerSecond = 0.0;
+	Statistics.GBPerSecond = 0.0;
+	if ((ImageSize == 0) || (BuffersInFlight <= 0) || (Kernel == 0))
+		return false;
+
+	std::vector<FrameBuffer> Buffers;
+	concurrent_queue<FrameBuffer *> FreeBuffers;
+	try
+	{
+		Buffers.resize(BuffersInFlight);
+		for (int i = 0; i < BuffersInFlight; i++)
+		{
+			Buffers[i].RGBAImage.resize(ImageSize * RGBA_PIXEL_SIZE);
+			Buffers[i].YImage.resize(ImageSize);
+			FreeBuffers.push(&Buffers[i]);
+		}
+	}
+	catch (const std::bad_alloc &)
+	{
+		return false;
+	}
+
+	int FramesWritten = 0;
+	std::atomic<bool> WriteFailed(false);
+	tick_count StartTime = tick_count::now();
+	parallel_pipeline(BuffersInFlight,
+		make_filter<void, FrameBuffer *>(filter_mode::serial_in_order,
+			[&](flow_control &Control) -> FrameBuffer * {
+				FrameBuffer *Frame = 0;
+				if (WriteFailed || !FreeBuffers.try_pop(Frame))
+				{
+					Control.stop();
+					return 0;
+				}
+				if (fread(&Frame->RGBAImage[0], 1, Frame->RGBAImage.size(), InputFile) != Frame->RGBAImage.size())
+				{
+					FreeBuffers.push(Frame);
+					Control.stop();
+					return 0;
+				}
+				return Frame;
+			}) &
+		make_filter<FrameBuffer *, FrameBuffer *>(filter_mode::parallel,
+			[=](FrameBuffer *Frame) -> FrameBuffer * {
+				Kernel(&Frame->RGBAImage[0], &Frame->YImage[0], ImageWidth, ImageHeight, RGBA_PIXEL_SIZE);
+				return Frame;
+			}) &
+		make_filter<FrameBuffer *, void>(filter_mode::serial_in_order,
+			[&](FrameBuffer *Frame) {
+				if (!WriteFailed)
+				{
+					if (fwrite(&Frame->YImage[0], 1, Frame->YImage.size(), OutputFile) == Frame->YImage.size())
+						FramesWritten++;
+					else
+						WriteFailed = true;
+				}
+				FreeBuffers.push(Frame);
+			})
+		);
+	if (fflush(OutputFile) != 0)
+		WriteFailed = true;
+	Statistics.Seconds = (tick_count::now() - StartTime).seconds();
+
+	Statistics.Frames = FramesWritten;
+	if (Statistics.Seconds > 0.0)
+	{
+		Statistics.FramesPerSecond = FramesWritten / Statistics.Seconds;
+		Statistics.GBPerSecond = ((double)FramesWritten * ImageSize * (RGBA_PIXEL_SIZE + 1)) / Statistics.Seconds / 1e9;
+	}
+	return !WriteFailed;
+}
@@ -0,0 +1,30 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include <stdio.h>
+
+#include "TBBDemoKernel.h"
+
+// results of a run of the conversion pipeline
+struct PipelineStatistics {
+	int Frames;					//< frames read, converted and written
+	double Seconds;				//< wall-clock time of the whole run, I/O included
+	double FramesPerSecond;
+	double GBPerSecond;			//< bytes read plus bytes written, per second
+};
+
+// converts a sequence of raw RGBA frames of ImageWidth x ImageHeight pixels read from InputFile into luma planes
+// written to OutputFile, keeping at most BuffersInFlight frames in memory
+// returns false if the buffers cannot be allocated or a write fails, a trailing partial frame is ignored
+bool RunConversionPipeline(FILE *InputFile, FILE *OutputFile, int ImageWidth, int ImageHeight, int BuffersInFlight,
+						   LumaFunction Kernel, PipelineStatistics &Statistics);
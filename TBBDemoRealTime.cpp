@@ -0,0 +1,250 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBBenchmark.h"
+#include "TBBDemoRealTime.h"
+#include "TBBDemoRoutines.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Intel TBB library
+#include <flow_graph.h>
+#include <concurrent_queue.h>
+#include <global_control.h>
+#include <task_arena.h>
+using namespace tbb;
+using namespace tbb::flow;
+
+typedef std::chrono::steady_clock RealTimeClock;
+
+// RealTimeFrame
+// input and output planes of one frame, allocated once and recycled; the capture thread only stamps the arrival time,
+// like a capture driver that fills buffers taken from a pool
+
+struct RealTimeFrame {
+	std::vector<unsigned char> RGBAImage;
+	std::vector<unsigned char> YImage;
+	RealTimeClock::time_point Arrival;
+	RealTimeClock::time_point Completion;
+};
+
+// FrameRing
+// lock-free single producer, single consumer ring of frame indices
+// the producer is the only one that advances Tail and the consumer pops by advancing Head, but when the ring is full
+// the producer drops the oldest frame by advancing Head itself, so Head is moved with compare-and-swap on both sides:
+// a pop that loses against a drop retries on the next frame, a drop that loses against a pop finds a free slot
+// the slots are atomic as the producer may overwrite a slot that the consumer is reading, the consumer then fails
+// its compare-and-swap and never uses the value it read
+
+class FrameRing {
+public:
+	explicit FrameRing(int Capacity) : Slots(Capacity), Head(0), Tail(0) {}
+
+	// returns the frame dropped to make room, or -1
+	int Push(int Frame)
+	{
+		const size_t Capacity = Slots.size();
+		const unsigned long long CurrentTail = Tail.load(std::memory_order_relaxed);
+		unsigned long long CurrentHead = Head.load(std::memory_order_acquire);
+		int Dropped = -1;
+		if (CurrentTail - CurrentHead == Capacity)
+		{
+			const int Oldest = Slots[CurrentHead % Capacity].load(std::memory_order_relaxed);
+			if (Head.compare_exchange_strong(CurrentHead, CurrentHead + 1, std::memory_order_acq_rel))
+				Dropped = Oldest;
+		}
+		Slots[CurrentTail % Capacity].store(Frame, std::memory_order_relaxed);
+		Tail.store(CurrentTail + 1, std::memory_order_release);
+		return Dropped;
+	}
+
+	// returns the oldest frame, or -1 when the ring is empty
+	int Pop()
+	{
+		const size_t Capacity = Slots.size();
+		unsigned long long CurrentHead = Head.load(std::memory_order_acquire);
+		while (CurrentHead != Tail.load(std::memory_order_acquire))
+		{
+			const int Frame = Slots[CurrentHead % Capacity].load(std::memory_order_relaxed);
+			if (Head.compare_exchange_weak(CurrentHead, CurrentHead + 1, std::memory_order_acq_rel))
+				return Frame;
+		}
+		return -1;
+	}
+
+	bool IsEmpty() const
+	{
+		return Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_acquire);
+	}
+
+private:
+	FrameRing(const FrameRing &);
+	FrameRing &operator=(const FrameRing &);
+
+	std::vector<std::atomic<int> > Slots;
+	std::atomic<unsigned long long> Head;
+	std::atomic<unsigned long long> Tail;
+};
+
+// GetDefaultRealTimeOptions
+
+RealTimeOptions GetDefaultRealTimeOptions()
+{
+	RealTimeOptions Options;
+	Options.ImageWidth = 1920;
+	Options.ImageHeight = 1080;
+	Options.FramesPerSecond = 60.0;
+	Options.FrameCount = 300;
+	Options.RingCapacity = 4;
+	Options.Concurrency = 2;
+	Options.Kernel = &ProcessRGBTBBSIMDAuto;
+	return Options;
+}
+
+// RunRealTimeConversion
+// a capture thread pushes a frame in the ring at every period and rings a doorbell; the calling thread is the only
+// consumer of the ring and feeds a flow graph: a conversion node limited to Concurrency frames at a time, followed by
+// a serial node that records the latency and gives the buffer back
+// frames are popped only when the conversion node can start them at once, so frames wait in the ring, where the
+// newest arrivals push out the oldest ones, and never in the queue of the node, where they would only get staler
+// the pool holds a buffer for each slot of the ring, for each frame in conversion and for the one being captured,
+// so the capture thread always finds a free buffer
+// the graph runs in its own arena with a worker for each frame in conversion, as the calling thread blocks on the
+// doorbell instead of running tasks; on a single-core machine TBB would otherwise start no worker at all
+
+bool RunRealTimeConversion(const RealTimeOptions &Options, RealTimeStatistics &Statistics)
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const size_t ImageSize = (size_t)Options.ImageWidth * Options.ImageHeight;
+
+	Statistics.FramesProduced = 0;
+	Statistics.FramesConverted = 0;
+	Statistics.FramesDropped = 0;
+	Statistics.LatenciesNs.clear();
+	Statistics.Seconds = 0.0;
+	if ((ImageSize == 0) || (Options.FramesPerSecond <= 0.0) || (Options.FrameCount <= 0) || (Options.RingCapacity <= 0) ||
+		(Options.Concurrency <= 0) || (Options.Kernel == 0))
+		return false;
+
+	const int BufferCount = Options.RingCapacity + Options.Concurrency + 1;
+	std::vector<RealTimeFrame> Frames;
+	concurrent_queue<int> FreeFrames;
+	try
+	{
+		Frames.resize(BufferCount);
+		for (int i = 0; i < BufferCount; i++)
+		{
+			Frames[i].RGBAImage = CreateRandomImage(ImageSize * RGBA_PIXEL_SIZE, 0x5555u + i);
+			Frames[i].YImage.resize(ImageSize);
+			FreeFrames.push(i);
+		}
+		Statistics.LatenciesNs.reserve(Options.FrameCount);
+	}
+	catch (const std::bad_alloc &)
+	{
+		return false;
+	}
+
+	const int Workers = std::max(this_task_arena::max_concurrency(), Options.Concurrency);
+	global_control Parallelism(global_control::max_allowed_parallelism, Workers + 1);
+	task_arena Arena(Workers, 0);
+	FrameRing Ring(Options.RingCapacity);
+	std::mutex DoorbellMutex;
+	std::condition_variable Doorbell;
+	std::atomic<int> InFlight(0);
+	std::atomic<int> Dropped(0);
+	std::atomic<bool> CaptureDone(false);
+
+	std::unique_ptr<graph> Graph;
+	std::unique_ptr<function_node<int, int> > ConvertNode;
+	std::unique_ptr<function_node<int, continue_msg> > CompleteNode;
+	Arena.execute([&]() {
+			Graph.reset(new graph());
+			ConvertNode.reset(new function_node<int, int>(*Graph, Options.Concurrency, [&](int Index) -> int {
+					RealTimeFrame &Frame = Frames[Index];
+					Options.Kernel(&Frame.RGBAImage[0], &Frame.YImage[0], Options.ImageWidth, Options.ImageHeight, RGBA_PIXEL_SIZE);
+					Frame.Completion = RealTimeClock::now();
+					return Index;
+				}));
+			CompleteNode.reset(new function_node<int, continue_msg>(*Graph, serial, [&](int Index) -> continue_msg {
+					const RealTimeFrame &Frame = Frames[Index];
+					Statistics.LatenciesNs.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Frame.Completion - Frame.Arrival).count());
+					// the buffer is free before the slot is, so that the pool never runs dry
+					FreeFrames.push(Index);
+					InFlight--;
+					std::lock_guard<std::mutex> Lock(DoorbellMutex);
+					Doorbell.notify_all();
+					return continue_msg();
+				}));
+			make_edge(*ConvertNode, *CompleteNode);
+		});
+
+	const RealTimeClock::time_point Start = RealTimeClock::now();
+	std::thread Capture([&]() {
+			const RealTimeClock::duration Period = std::chrono::duration_cast<RealTimeClock::duration>(std::chrono::duration<double>(1.0 / Options.FramesPerSecond));
+			RealTimeClock::time_point NextArrival = Start;
+			for (int i = 0; i < Options.FrameCount; i++)
+			{
+				std::this_thread::sleep_until(NextArrival);
+				NextArrival += Period;
+				int Index = -1;
+				if (!FreeFrames.try_pop(Index))
+				{
+					Dropped++;
+					continue;
+				}
+				Frames[Index].Arrival = RealTimeClock::now();
+				const int DroppedIndex = Ring.Push(Index);
+				if (DroppedIndex >= 0)
+				{
+					FreeFrames.push(DroppedIndex);
+					Dropped++;
+				}
+				std::lock_guard<std::mutex> Lock(DoorbellMutex);
+				Doorbell.notify_all();
+			}
+			CaptureDone = true;
+			std::lock_guard<std::mutex> Lock(DoorbellMutex);
+			Doorbell.notify_all();
+		});
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(DoorbellMutex);
+			Doorbell.wait(Lock, [&]() {
+					return ((InFlight < Options.Concurrency) && !Ring.IsEmpty()) || (CaptureDone && Ring.IsEmpty());
+				});
+		}
+		if (CaptureDone && Ring.IsEmpty())
+			break;
+		if (InFlight >= Options.Concurrency)
+			continue;
+		const int Index = Ring.Pop();
+		if (Index < 0)
+			continue;
+		InFlight++;
+		ConvertNode->try_put(Index);
+	}
+	Capture.join();
+	Arena.execute([&]() { Graph->wait_for_all(); });
+
+	Statistics.Seconds = std::chrono::duration<double>(RealTimeClock::now() - Start).count();
+	Statistics.FramesDropped = Dropped;
+	Statistics.FramesConverted = (int)Statistics.LatenciesNs.size();
+	Statistics.FramesProduced = Statistics.FramesConverted + Statistics.FramesDropped;
+	return true;
+}
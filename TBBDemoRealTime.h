@@ -0,0 +1,44 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include "TBBDemoKernel.h"
+
+#include <vector>
+
+// settings of a real-time run: frames arrive at a fixed rate from a capture thread, whether or not the previous ones
+// have been converted
+struct RealTimeOptions {
+	int ImageWidth;
+	int ImageHeight;
+	double FramesPerSecond;		//< arrival rate of the frames
+	int FrameCount;				//< frames produced by the capture thread
+	int RingCapacity;			//< frames waiting for conversion, when the ring is full the oldest one is dropped
+	int Concurrency;			//< frames converted at the same time
+	LumaFunction Kernel;		//< RGBA to luma kernel, it may be a parallel one
+};
+
+// results of a real-time run, every produced frame is either converted or dropped
+struct RealTimeStatistics {
+	int FramesProduced;
+	int FramesConverted;
+	int FramesDropped;
+	std::vector<double> LatenciesNs;	//< from arrival to end of conversion, for each converted frame in completion order
+	double Seconds;						//< wall-clock time of the whole run
+};
+
+// GetDefaultRealTimeOptions
+// 1080p at 60 frames/s for 5 seconds, a ring of 4 frames and 2 frames in conversion
+RealTimeOptions GetDefaultRealTimeOptions();
+
+// RunRealTimeConversion
+// returns false if the options are invalid or the buffers cannot be allocated
+bool RunRealTimeConversion(const RealTimeOptions &Options, RealTimeStatistics &Statistics);
@@ -0,0 +1,118 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include "TBBBenchmark.h"
+#include "TBBDemoCPU.h"
+#include "TBBDemoRoofline.h"
+
+#include <algorithm>
+#include <vector>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+#include <partitioner.h>
+#include <task_arena.h>
+using namespace tbb;
+
+// RunStreamLoop
+// runs Body on the whole array with the same static partition every time, so that each thread works on the pages
+// it initialized
+
+template <class Body>
+static void RunStreamLoop(size_t ElementCount, const Body &LoopBody)
+{
+	parallel_for(blocked_range<size_t>(0, ElementCount), [&](const blocked_range<size_t> &Range) {
+			LoopBody(Range.begin(), Range.end());
+		}, static_partitioner());
+}
+
+StreamBandwidth MeasureStreamBandwidth(int Repetitions)
+{
+	const CPUCacheSizes &CacheSizes = GetCPUCacheSizes();
+	const size_t LastLevelCache = (size_t)(CacheSizes.L3 ? CacheSizes.L3 : CacheSizes.L2);
+	const size_t ArraySize = std::max(4 * LastLevelCache, (size_t)32 * 1024 * 1024);
+	const size_t ElementCount = ArraySize / sizeof(double);
+	const double Scalar = 3.0;
+
+	// new[] leaves the arrays uninitialized, so that every page is first touched by the parallel loop
+	double *A = new double[ElementCount];
+	double *B = new double[ElementCount];
+	double *C = new double[ElementCount];
+	RunStreamLoop(ElementCount, [=](size_t Start, size_t Stop) {
+			for (size_t i = Start; i < Stop; i++)
+			{
+				A[i] = 1.0;
+				B[i] = 2.0;
+				C[i] = 0.0;
+			}
+		});
+
+	std::vector<double> CopyNs, TriadNs;
+	for (int Run = 0; Run < Repetitions; Run++)
+	{
+		BenchmarkTimer Timer;
+		RunStreamLoop(ElementCount, [=](size_t Start, size_t Stop) {
+				for (size_t i = Start; i < Stop; i++)
+					C[i] = A[i];
+			});
+		CopyNs.push_back(Timer.GetElapsedNs());
+		Timer.Restart();
+		RunStreamLoop(ElementCount, [=](size_t Start, size_t Stop) {
+				for (size_t i = Start; i < Stop; i++)
+					A[i] = B[i] + Scalar * C[i];
+			});
+		TriadNs.push_back(Timer.GetElapsedNs());
+	}
+	delete[] A;
+	delete[] B;
+	delete[] C;
+
+	StreamBandwidth Bandwidth;
+	Bandwidth.ArraySize = ArraySize;
+	Bandwidth.CopyGBPerSecond = 2.0 * ArraySize / ComputeBenchmarkStatistics(CopyNs).MinNs;
+	Bandwidth.TriadGBPerSecond = 3.0 * ArraySize / ComputeBenchmarkStatistics(TriadNs).MinNs;
+	return Bandwidth;
+}
+
+double GetAchievableGBPerSecond(const StreamBandwidth &Bandwidth)
+{
+	return std::max(Bandwidth.CopyGBPerSecond, Bandwidth.TriadGBPerSecond);
+}
+
+bool IsLastLevelCacheResident(double Bytes)
+{
+	const CPUCacheSizes &CacheSizes = GetCPUCacheSizes();
+	return Bytes <= (double)(CacheSizes.L3 ? CacheSizes.L3 : CacheSizes.L2);
+}
+
+double GetRooflineMegapixelsPerSecond(const RooflinePoint &Point, double GBPerSecond)
+{
+	if (Point.LastLevelCacheResident)
+		return Point.CacheMegapixelsPerSecond;
+	return std::min(Point.CacheMegapixelsPerSecond, GBPerSecond * 1e3 / Point.BytesPerPixel);
+}
+
+bool IsMemoryBound(const RooflinePoint &Point, double GBPerSecond)
+{
+	return !Point.LastLevelCacheResident && (GBPerSecond * 1e3 / Point.BytesPerPixel < Point.CacheMegapixelsPerSecond);
+}
+
+// GetCacheResidentImageSize
+// rows of 256 pixels, as many as fill half of the L2 cache of every thread, so that the share of the image of each
+// thread of a parallel kernel stays in its L2; a smaller image would measure the cost of starting the parallel loop
+
+std::pair<int, int> GetCacheResidentImageSize(int PixelSize)
+{
+	const int ImageWidth = 256;
+	const long long CacheBytes = (long long)GetCPUCacheSizes().L2 / 2 * this_task_arena::max_concurrency();
+	const int ImageHeight = (int)std::max(std::min(CacheBytes / (ImageWidth * (PixelSize + 1)), 64 * 1024LL), 16LL);
+	return std::make_pair(ImageWidth, ImageHeight);
+}
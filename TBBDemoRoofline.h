@@ -0,0 +1,53 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include <stddef.h>
+#include <utility>
+
+// StreamBandwidth
+// memory bandwidth measured by the Copy and Triad kernels of the STREAM benchmark, on arrays of doubles processed by
+// all the threads of the current arena; as in STREAM, the bytes of each element are counted once, without the reads
+// of the write-allocate traffic
+struct StreamBandwidth {
+	size_t ArraySize;				//< bytes of each of the three arrays
+	double CopyGBPerSecond;			//< best run, 16 bytes per element
+	double TriadGBPerSecond;		//< best run, 24 bytes per element
+};
+
+// MeasureStreamBandwidth
+// the arrays are 4 times the size of the last level cache and at least 32 MB, so that they cannot be cached;
+// they are initialized by the same threads and with the same static partition as the timed loops
+StreamBandwidth MeasureStreamBandwidth(int Repetitions = 10);
+
+// the higher of the two STREAM figures, the bandwidth that the conversion kernels can hope to reach
+double GetAchievableGBPerSecond(const StreamBandwidth &Bandwidth);
+
+// roofline model of a conversion kernel
+// the throughput of a kernel is bound by two ceilings: the one of its computation, measured on an image that fits
+// in the L2 caches, and the one of memory, the STREAM bandwidth divided by the bytes it moves per pixel;
+// the kernel is memory-bound when the latter is the lower one; images that fit in the last level cache are not
+// read from memory, so they have no memory roof
+struct RooflinePoint {
+	double BytesPerPixel;				//< bytes read plus bytes written
+	double MegapixelsPerSecond;			//< measured on the image of the benchmark
+	double CacheMegapixelsPerSecond;	//< measured on the cache-resident image
+	bool LastLevelCacheResident;		//< the images of the benchmark fit in the last level cache
+};
+
+// true when Bytes fit in the last level cache, L3 or L2 when there is no L3
+bool IsLastLevelCacheResident(double Bytes);
+
+double GetRooflineMegapixelsPerSecond(const RooflinePoint &Point, double GBPerSecond);
+bool IsMemoryBound(const RooflinePoint &Point, double GBPerSecond);
+
+// width and height of the cache-resident image, for a source of PixelSize bytes per pixel and a luma image
+std::pair<int, int> GetCacheResidentImageSize(int PixelSize);
@@ -8,17 +8,18 @@
 // -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
 // -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
 
-#include <Windows.h>
+#include "TBBDemoCPU.h"
+#include "TBBDemoRoutines.h"
 
 // Intel TBB library
-#include <task_scheduler_init.h>
-using namespace tbb;
 #include <parallel_for.h>
 #include <blocked_range.h>
 #include <blocked_range2d.h>
+using namespace tbb;
 
 // SIMD intrinsics
 #include <emmintrin.h>
+#include <tmmintrin.h>
 
 // constants for RGB to Y conversion
 // Ey = 0.299*Er + 0.587*Eg + 0.114*Eb
@@ -162,7 +163,7 @@ void ProcessRGBTBB3(void *SourceImage, void *YImage, int ImageWidth, int ImageHe
 // ProcessRGBSIMD
 // SSE2 version of Serial code
 // both input and output image are unidimensional arrays of ImageWidth * ImageHeight pixels
-// assumes that PixelOffset is 4 (RGBA image) and that ImageWidth * ImageHeight * PixelOffset is a multiple of 16
+// assumes that PixelOffset is 4 (RGBA image), 4 pixels are processed per loop and the remaining ones by scalar code
 // does not assume that the input image is aligned on 16 bytes
 
 void ProcessRGBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
@@ -172,7 +173,8 @@ void ProcessRGBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHe
 	__m128i *SourceImagePtr = (__m128i *)SourceImage;
 	int *YImagePtr = (int *)YImage;
 
-    for (int i = (ImageWidth * ImageHeight); i > 0; i -= 4)  // 4 pixels per loop
+	int i = (ImageWidth * ImageHeight);
+	for (; i >= 4; i -= 4)  // 4 pixels per loop
 	{
 		__m128i RGBValue = _mm_loadu_si128(SourceImagePtr);
 		SourceImagePtr++;
@@ -200,15 +202,17 @@ void ProcessRGBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHe
 		*YImagePtr = _mm_cvtsi128_si32(YValue);
 		YImagePtr++;
 	}
+	if (i > 0)
+		ProcessRGBSerial(SourceImagePtr, YImagePtr, i, 1, PixelOffset);
 }
 
 // ProcessRGBSIMD2
 // SSSE3 version of Serial code
 // both input and output image are unidimensional arrays of ImageWidth * ImageHeight pixels
-// assumes that PixelOffset is 4 (RGBA image) and that ImageWidth * ImageHeight * PixelOffset is a multiple of 16
+// assumes that PixelOffset is 4 (RGBA image), 4 pixels are processed per loop and the remaining ones by scalar code
 // does not assume that the input image is aligned on 16 bytes
 
-void ProcessRGBSIMD2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+TARGET_SSSE3 void ProcessRGBSIMD2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
 {
 	__m128i RGBScale = _mm_set_epi16(0, Y_BLUE_SCALE, Y_GREEN_SCALE, Y_RED_SCALE, 0, Y_BLUE_SCALE, Y_GREEN_SCALE, Y_RED_SCALE);
 	__m128i ShiftScalingAdjust = _mm_set1_epi32(1 << (SCALING_LOG - 1));
@@ -216,7 +220,8 @@ void ProcessRGBSIMD2(void *SourceImage, void *YImage, int ImageWidth, int ImageH
 	__m128i ZeroConst = _mm_setzero_si128();
 	int *YImagePtr = (int *)YImage;
 
-    for (int i = (ImageWidth * ImageHeight); i > 0; i -= 4)  // 4 pixels per loop
+	int i = (ImageWidth * ImageHeight);
+	for (; i >= 4; i -= 4)  // 4 pixels per loop
 	{
 		__m128i RGBValue = _mm_loadu_si128(SourceImagePtr);
 		SourceImagePtr++;
@@ -240,15 +245,17 @@ void ProcessRGBSIMD2(void *SourceImage, void *YImage, int ImageWidth, int ImageH
 		*YImagePtr = _mm_cvtsi128_si32(YValue);
 		YImagePtr++;
 	}
+	if (i > 0)
+		ProcessRGBSerial(SourceImagePtr, YImagePtr, i, 1, PixelOffset);
 }
 
 // ProcessRGBSIMD3
 // reduced precision SSSE3 version of Serial code that does NOT produce results that match serial code's ones.
 // both input and output image are unidimensional arrays of ImageWidth * ImageHeight pixels
-// assumes that PixelOffset is 4 (RGBA image) and that ImageWidth * ImageHeight * PixelOffset is a multiple of 16
+// assumes that PixelOffset is 4 (RGBA image), 4 pixels are processed per loop and the remaining ones by scalar code
 // does not assume that the input image is aligned on 16 bytes
 
-void ProcessRGBSIMD3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+TARGET_SSSE3 void ProcessRGBSIMD3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
 {
 	const int SCALING_LOG = 7;
 	const int SCALING_FACTOR = (1 << SCALING_LOG);
@@ -262,7 +269,8 @@ void ProcessRGBSIMD3(void *SourceImage, void *YImage, int ImageWidth, int ImageH
 	__m128i ZeroConst = _mm_setzero_si128();
 	int *YImagePtr = (int *)YImage;
 
-    for (int i = (ImageWidth * ImageHeight); i > 0; i -= 4)  // 4 pixels per loop
+	int i = (ImageWidth * ImageHeight);
+	for (; i >= 4; i -= 4)  // 4 pixels per loop
 	{
 		__m128i RGBValue = _mm_loadu_si128(SourceImagePtr);
 		SourceImagePtr++;
@@ -279,30 +287,41 @@ void ProcessRGBSIMD3(void *SourceImage, void *YImage, int ImageWidth, int ImageH
 		*YImagePtr = _mm_cvtsi128_si32(YValue);
 		YImagePtr++;
 	}
+	// the scalar tail must use the same reduced precision coefficients
+	unsigned char *TailSourcePtr = (unsigned char *)SourceImagePtr;
+	unsigned char *TailYPtr = (unsigned char *)YImagePtr;
+	for (; i > 0; i--)
+	{
+		int YValue = (TailSourcePtr[0] * Y_RED_SCALE  ) +
+					 (TailSourcePtr[1] * Y_GREEN_SCALE) +
+					 (TailSourcePtr[2] * Y_BLUE_SCALE );
+		TailSourcePtr += PixelOffset;
+		YValue += 1 << (SCALING_LOG - 1);
+		YValue >>= SCALING_LOG;
+		*TailYPtr = (unsigned char)YValue;
+		TailYPtr++;
+	}
 }
 
 // ProcessRGBTBBSIMD
 // by using a lambda that copies the required information automatically [=], the kernel of the computation is contained
 // inside the invocation to parallel_for
+// the range counts groups of 4 pixels, so that chunk boundaries never fall in the middle of a SIMD register,
+// and the pixels that do not fill a whole group are converted by scalar code after the parallel loop
 
-void ProcessRGBTBBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+TARGET_SSSE3 void ProcessRGBTBBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
 {
 	__m128i RGBScale = _mm_set_epi16(0, Y_BLUE_SCALE, Y_GREEN_SCALE, Y_RED_SCALE, 0, Y_BLUE_SCALE, Y_GREEN_SCALE, Y_RED_SCALE);
 	__m128i ShiftScalingAdjust = _mm_set1_epi32(1 << (SCALING_LOG - 1));
-	__m128i *SourceImagePtr = (__m128i *)SourceImage;
 	__m128i ZeroConst = _mm_setzero_si128();
-	int *YImagePtr = (int *)YImage;
+	int PixelGroups = (ImageWidth * ImageHeight) / 4;
 	
-	parallel_for( blocked_range<int>( 0, (ImageWidth * ImageHeight)),
-	    [=](const blocked_range<int>& r) {
-			unsigned char *LocalSourceImagePtr = (unsigned char *)SourceImage;
-			unsigned char *LocalYImagePtr = (unsigned char *)YImage;
-			LocalSourceImagePtr += r.begin() * PixelOffset;
-			LocalYImagePtr += r.begin();
-			__m128i *SourceImagePtr = (__m128i *)LocalSourceImagePtr;
-			int *YImagePtr = (int *)LocalYImagePtr;
+	parallel_for( blocked_range<int>( 0, PixelGroups),
+	    [=](const blocked_range<int>& r) TARGET_SSSE3 {
+			__m128i *SourceImagePtr = (__m128i *)SourceImage + r.begin();
+			int *YImagePtr = (int *)YImage + r.begin();
 
-			for (int i = r.begin(); i < r.end(); i+=4)
+			for (int i = r.begin(); i != r.end(); i++)
 			{
 				__m128i RGBValue = _mm_loadu_si128(SourceImagePtr);
 				SourceImagePtr++;
@@ -325,4 +344,98 @@ void ProcessRGBTBBSIMD(void *SourceImage, void *YImage, int ImageWidth, int Imag
 			}
 	      }
 	    );
-}
\ No newline at end of file
+
+	int TailPixels = (ImageWidth * ImageHeight) - PixelGroups * 4;
+	if (TailPixels > 0)
+		ProcessRGBSerial((unsigned char *)SourceImage + PixelGroups * 4 * PixelOffset, (unsigned char *)YImage + PixelGroups * 4, TailPixels, 1, PixelOffset);
+}
+
+// runtime dispatch
+// the kernels are selected once, during static initialization, so each call costs only an indirect jump
+
+static ProcessRGBFunction SelectSIMDKernel()
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (Features.AVX512BW)
+		return &ProcessRGBAVX512;
+	if (Features.AVX2)
+		return &ProcessRGBAVX2;
+	if (Features.SSSE3)
+		return &ProcessRGBSIMD2;
+	return &ProcessRGBSIMD;
+}
+
+static ProcessRGBFunction SelectSIMDFastKernel()
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (Features.AVX512BW)
+		return &ProcessRGBAVX512Fast;
+	if (Features.AVX2)
+		return &ProcessRGBAVX2Fast;
+	if (Features.SSSE3)
+		return &ProcessRGBSIMD3;
+	return &ProcessRGBSIMD;
+}
+
+static ProcessRGBFunction SelectSIMDFastRoundedKernel()
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (Features.AVX512BW)
+		return &ProcessRGBAVX512FastRounded;
+	if (Features.AVX2)
+		return &ProcessRGBAVX2FastRounded;
+	if (Features.SSSE3)
+		return &ProcessRGBSSSE3FastRounded;
+	return &ProcessRGBSIMD;
+}
+
+static ProcessRGBFunction SelectTBBSIMDKernel()
+{
+	const CPUFeatures &Features = GetCPUFeatures();
+	if (Features.AVX512BW)
+		return &ProcessRGBTBBAVX512;
+	if (Features.AVX2)
+		return &ProcessRGBTBBAVX2;
+	if (Features.SSSE3)
+		return &ProcessRGBTBBSIMD;
+	return &ProcessRGBTBB2;
+}
+
+static const ProcessRGBFunction SIMDKernel = SelectSIMDKernel();
+static const ProcessRGBFunction SIMDFastKernel = SelectSIMDFastKernel();
+static const ProcessRGBFunction SIMDFastRoundedKernel = SelectSIMDFastRoundedKernel();
+static const ProcessRGBFunction TBBSIMDKernel = SelectTBBSIMDKernel();
+
+// ProcessRGBSIMDAuto
+// exact single-threaded conversion with the widest instruction set available
+
+void ProcessRGBSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	SIMDKernel(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+// ProcessRGBSIMDFastAuto
+// reduced precision single-threaded conversion with the widest instruction set available
+// without SSSE3 there is no reduced precision kernel, so the exact SSE2 one is used
+
+void ProcessRGBSIMDFastAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	SIMDFastKernel(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+// ProcessRGBSIMDFastRoundedAuto
+// reduced precision single-threaded conversion with rounded scales and the widest instruction set available, within
+// 1 of the exact result; without SSSE3 the exact SSE2 kernel is used
+
+void ProcessRGBSIMDFastRoundedAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	SIMDFastRoundedKernel(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
+
+// ProcessRGBTBBSIMDAuto
+// exact multi-threaded conversion with the widest instruction set available
+
+void ProcessRGBTBBSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset)
+{
+	TBBSIMDKernel(SourceImage, YImage, ImageWidth, ImageHeight, PixelOffset);
+}
@@ -8,6 +8,13 @@
 // -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
 // -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
 
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+
+// all kernels share the same signature, so that they can be selected at runtime
+typedef void (*ProcessRGBFunction)(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// both input and output image are unidimensional arrays of ImageWidth * ImageHeight pixels
 void ProcessRGBSerial(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
 void ProcessRGBTBB1(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
 void ProcessRGBTBB2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
@@ -16,3 +23,67 @@ void ProcessRGBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHe
 void ProcessRGBSIMD2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
 void ProcessRGBSIMD3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
 void ProcessRGBTBBSIMD(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// the following kernels are BT.601 instantiations of ProcessLuma, see TBBDemoKernel.h
+// SSSE3, AVX2 and AVX-512BW kernels, they must be called only if GetCPUFeatures() reports the corresponding instruction set
+// the Fast kernels use the truncated 7-bit scales of ProcessRGBSIMD3, the FastRounded ones the rounded 8-bit scales,
+// which keep every result within 1 of ProcessRGBSerial, see FixedPointScales
+void ProcessRGBSSSE3FastRounded(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBAVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBAVX2Fast(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBAVX2FastRounded(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBAVX512(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBAVX512Fast(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBAVX512FastRounded(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBTBBAVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBTBBAVX512(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// kernels for other channel orders, PixelOffset is implied by the format
+// ProcessBGRSerial handles BGR24 and BGRA32 images, selected by PixelOffset like ProcessRGBSerial does for RGB24 and RGBA32
+void ProcessBGRSerial(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessARGBSerial(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGB24SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessBGR24SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessBGRA32SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessARGB32SSSE3(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGB24AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessBGR24AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessBGRA32AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessARGB32AVX2(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// entry points that run the widest kernel supported by the CPU
+void ProcessRGBSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBSIMDFastAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBSIMDFastRoundedAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+void ProcessRGBTBBSIMDAuto(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset);
+
+// versions of the kernels that work on padded rows, YImage must be a PIXEL_FORMAT_Y8 image with the same dimensions of Source
+// source images can have any of the RGB pixel formats, the RGBA32 kernels named by each function are used for
+// PIXEL_FORMAT_RGBA32 images and the kernel with the same instruction set and precision for the other formats, while
+// Serial and TBB1/2/3 stay scalar
+// in-place conversion is supported when YImage has the same Data and Stride of Source
+// they return false, without converting anything, when the formats or the dimensions of the images are not supported
+bool ProcessRGBSerial(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBB1(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBB2(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBB3(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSIMD(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSIMD2(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSIMD3(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBBSIMD(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBAVX2(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSSSE3FastRounded(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBAVX2Fast(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBAVX2FastRounded(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBAVX512(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBAVX512Fast(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBAVX512FastRounded(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBBAVX2(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBBAVX512(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSIMDAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSIMDFastAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBSIMDFastRoundedAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+bool ProcessRGBTBBSIMDAuto(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+
+// any RGB pixel format, coefficient set and precision, with the widest instruction set available
+bool ConvertToLuma(const ImageDescriptor &Source, const ImageDescriptor &YImage, LumaCoefficients Coefficients, bool ReducedPrecision, bool Parallel);
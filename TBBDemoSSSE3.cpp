@@ -0,0 +1,169 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+// SSSE3 specialization of LumaKernel
+// each instruction set has its own source file, so that with GCC and clang only the functions marked with the
+// TARGET_* macros use it, and with Visual C++ the file can be given its own /arch setting
+
+#include "TBBDemoCPU.h"
+#include "TBBDemoKernel.h"
+#include "TBBDemoKernelInstances.h"
+
+#include <algorithm>
+
+// SIMD intrinsics
+#include <tmmintrin.h>
+
+// SSSE3Constants
+// registers that depend only on the template parameters, kept together so that the helpers take a single argument
+// the values are computed by KernelConstants and broadcast to every 32-bit element
+
+template <class Layout, class Scales>
+struct SSSE3Constants {
+	__m128i ShuffleMask;
+	__m128i EvenScale;
+	__m128i OddScale;
+	__m128i ByteScale;
+	__m128i ShiftScalingAdjust;
+
+	TARGET_SSSE3 SSSE3Constants()
+	{
+		const KernelConstants<Layout, Scales> Values;
+		ShuffleMask = _mm_loadu_si128((const __m128i *)Values.LaneShuffleMask);
+		EvenScale = _mm_set1_epi32(Values.EvenScale);
+		OddScale = _mm_set1_epi32(Values.OddScale);
+		ByteScale = _mm_set1_epi32(Values.ByteScale);
+		ShiftScalingAdjust = _mm_set1_epi32(Scales::Rounding);
+	}
+};
+
+// ConvertPixelsSSSE3
+// computes the luma of 4 pixels of 4 bytes each, returned as 32-bit integers
+// with full precision, masking bytes 0 and 2 and shifting bytes 1 and 3 gives 16-bit values ready for _mm_madd_epi16,
+// so each pixel stays in its own 32-bit element and no horizontal add is needed
+// with reduced precision, _mm_maddubs_epi16 multiplies the bytes directly like ProcessRGBSIMD3 does
+
+template <class Layout, class Scales>
+static inline TARGET_SSSE3 __m128i ConvertPixelsSSSE3(__m128i RGBValue, const SSSE3Constants<Layout, Scales> &Constants)
+{
+	__m128i YValue;
+	if (Scales::Reduced)
+	{
+		YValue = _mm_madd_epi16(_mm_maddubs_epi16(RGBValue, Constants.ByteScale), _mm_set1_epi16(1));
+	}
+	else
+	{
+		__m128i EvenValue = _mm_and_si128(RGBValue, _mm_set1_epi32(0x00FF00FF));
+		__m128i OddValue = _mm_srli_epi16(RGBValue, 8);
+		YValue = _mm_add_epi32(_mm_madd_epi16(EvenValue, Constants.EvenScale), _mm_madd_epi16(OddValue, Constants.OddScale));
+	}
+	// YValue += 1 << (SCALING_LOG - 1);
+	YValue = _mm_add_epi32(YValue, Constants.ShiftScalingAdjust);
+	// YValue >>= SCALING_LOG;
+	return _mm_srli_epi32(YValue, Scales::ScalingLog);
+}
+
+// Load4PixelsSSSE3
+// returns the Index-th group of 4 pixels of a block of 16, one pixel per 32-bit element
+// the 48 bytes of 16 pixels of 3 bytes are loaded in 3 registers, _mm_alignr_epi8 extracts the 12 bytes of each group
+// and _mm_shuffle_epi8 spreads them in RGB0 order
+
+template <class Layout, class Scales>
+static inline TARGET_SSSE3 __m128i Load4PixelsSSSE3(const __m128i RGBValue[4], int Index, const SSSE3Constants<Layout, Scales> &Constants)
+{
+	if (Layout::PixelSize == 4)
+		return Scales::SplitGreen ? _mm_shuffle_epi8(RGBValue[Index], Constants.ShuffleMask) : RGBValue[Index];
+	switch (Index)
+	{
+	case 0:
+		return _mm_shuffle_epi8(RGBValue[0], Constants.ShuffleMask);
+	case 1:
+		return _mm_shuffle_epi8(_mm_alignr_epi8(RGBValue[1], RGBValue[0], 12), Constants.ShuffleMask);
+	case 2:
+		return _mm_shuffle_epi8(_mm_alignr_epi8(RGBValue[2], RGBValue[1], 8), Constants.ShuffleMask);
+	default:
+		return _mm_shuffle_epi8(_mm_srli_si128(RGBValue[2], 4), Constants.ShuffleMask);
+	}
+}
+
+// ConvertPixelsLoopSSSE3
+// 16 pixels per loop, the remaining ones are processed by the scalar kernel
+// with ALIGNED_LOADS the input image must be aligned on 16 bytes, as all the loads are at multiples of 16 bytes
+// from the start of the block they stay aligned for 24-bit pixels too
+
+template <class Layout, class Scales, bool NON_TEMPORAL, bool ALIGNED_LOADS>
+static inline TARGET_SSSE3 void ConvertPixelsLoopSSSE3(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	const SSSE3Constants<Layout, Scales> Constants;
+	const int RegisterCount = Layout::PixelSize;
+
+	int i = PixelCount;
+	for (; i >= 16; i -= 16)  // 16 pixels per loop
+	{
+		__m128i RGBValue[4];
+		for (int j = 0; j < RegisterCount; j++)
+			RGBValue[j] = ALIGNED_LOADS ? _mm_load_si128((const __m128i *)SourceImagePtr + j) : _mm_loadu_si128((const __m128i *)SourceImagePtr + j);
+		SourceImagePtr += 16 * Layout::PixelSize;
+		__m128i YValue0 = ConvertPixelsSSSE3(Load4PixelsSSSE3(RGBValue, 0, Constants), Constants);
+		__m128i YValue1 = ConvertPixelsSSSE3(Load4PixelsSSSE3(RGBValue, 1, Constants), Constants);
+		__m128i YValue2 = ConvertPixelsSSSE3(Load4PixelsSSSE3(RGBValue, 2, Constants), Constants);
+		__m128i YValue3 = ConvertPixelsSSSE3(Load4PixelsSSSE3(RGBValue, 3, Constants), Constants);
+		// if (YValue > 255)
+		//	YValue = 255;
+		__m128i YValue = _mm_packus_epi16(_mm_packs_epi32(YValue0, YValue1), _mm_packs_epi32(YValue2, YValue3));
+		if (NON_TEMPORAL)
+			_mm_stream_si128((__m128i *)YImagePtr, YValue);
+		else
+			_mm_storeu_si128((__m128i *)YImagePtr, YValue);
+		YImagePtr += 16;
+	}
+	if (NON_TEMPORAL)
+		_mm_sfence();
+	LumaKernel<Layout, Scales, ISAScalar>::Process(SourceImagePtr, YImagePtr, i);
+}
+
+// AlignAndConvertPixelsSSSE3
+// selects the loop for the alignment of the images
+// does not assume that the input image is aligned on 16 bytes, when it is the loads are aligned too
+// non-temporal stores need an aligned destination, so the scalar kernel first converts the pixels up to the next
+// 16-byte boundary of the luma plane
+
+template <class Layout, class Scales, bool NON_TEMPORAL>
+static inline TARGET_SSSE3 void AlignAndConvertPixelsSSSE3(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	if (NON_TEMPORAL)
+	{
+		int HeadCount = std::min((int)((16 - ((size_t)YImagePtr & 15)) & 15), PixelCount);
+		LumaKernel<Layout, Scales, ISAScalar>::Process(SourceImagePtr, YImagePtr, HeadCount);
+		SourceImagePtr += HeadCount * Layout::PixelSize;
+		YImagePtr += HeadCount;
+		PixelCount -= HeadCount;
+	}
+	if (((size_t)SourceImagePtr & 15) == 0)
+		ConvertPixelsLoopSSSE3<Layout, Scales, NON_TEMPORAL, true>(SourceImagePtr, YImagePtr, PixelCount);
+	else
+		ConvertPixelsLoopSSSE3<Layout, Scales, NON_TEMPORAL, false>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+// LumaKernel<Layout, Scales, ISASSSE3>::Process
+
+template <class Layout, class Scales>
+TARGET_SSSE3 void LumaKernel<Layout, Scales, ISASSSE3>::Process(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	AlignAndConvertPixelsSSSE3<Layout, Scales, false>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+template <class Layout, class Scales>
+TARGET_SSSE3 void LumaKernel<Layout, Scales, ISASSSE3>::ProcessNonTemporal(const unsigned char *SourceImagePtr, unsigned char *YImagePtr, int PixelCount)
+{
+	AlignAndConvertPixelsSSSE3<Layout, Scales, true>(SourceImagePtr, YImagePtr, PixelCount);
+}
+
+INSTANTIATE_LUMA_KERNELS(ISASSSE3)
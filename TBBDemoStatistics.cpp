@@ -0,0 +1,209 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoRoutines.h"
+#include "TBBDemoStatistics.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+#include <combinable.h>
+using namespace tbb;
+
+// SIMD intrinsics
+#include <emmintrin.h>
+
+// pixels converted and binned by each step of the fused loop: 16 KB of RGBA input and 4 KB of luma, a multiple
+// of the blocks of every SIMD kernel
+const int STATISTICS_BLOCK = 4096;
+
+// PartialStatistics
+// statistics of the pixels processed by one thread
+// incrementing the same bin of a single histogram for consecutive pixels, as happens in flat areas, serializes the
+// loads and stores to that bin; four histograms used in turn break the dependency and are summed at the end
+
+struct PartialStatistics {
+	unsigned int Histograms[4][256];
+	unsigned char Min;
+	unsigned char Max;
+	unsigned long long Sum;
+	unsigned long long PixelCount;
+
+	PartialStatistics()
+	{
+		memset(Histograms, 0, sizeof(Histograms));
+		Min = 255;
+		Max = 0;
+		Sum = 0;
+		PixelCount = 0;
+	}
+};
+
+// AccumulateStatistics
+// min, max and sum are computed 16 pixels at a time: _mm_sad_epu8 against zero adds groups of 8 bytes into two 64-bit
+// lanes; the histogram is updated from the same 16 bytes, which are in the L1 cache
+
+static void AccumulateStatistics(const unsigned char *YImagePtr, int PixelCount, PartialStatistics &Partial)
+{
+	__m128i MinValue = _mm_set1_epi8((char)Partial.Min);
+	__m128i MaxValue = _mm_set1_epi8((char)Partial.Max);
+	__m128i SumValue = _mm_setzero_si128();
+	__m128i ZeroConst = _mm_setzero_si128();
+
+	int i = PixelCount;
+	for (; i >= 16; i -= 16)  // 16 pixels per loop
+	{
+		__m128i YValue = _mm_loadu_si128((const __m128i *)YImagePtr);
+		MinValue = _mm_min_epu8(MinValue, YValue);
+		MaxValue = _mm_max_epu8(MaxValue, YValue);
+		SumValue = _mm_add_epi64(SumValue, _mm_sad_epu8(YValue, ZeroConst));
+		for (int j = 0; j < 16; j += 4)
+		{
+			Partial.Histograms[0][YImagePtr[j + 0]]++;
+			Partial.Histograms[1][YImagePtr[j + 1]]++;
+			Partial.Histograms[2][YImagePtr[j + 2]]++;
+			Partial.Histograms[3][YImagePtr[j + 3]]++;
+		}
+		YImagePtr += 16;
+	}
+
+	unsigned char MinBytes[16], MaxBytes[16];
+	unsigned long long Sums[2];
+	_mm_storeu_si128((__m128i *)MinBytes, MinValue);
+	_mm_storeu_si128((__m128i *)MaxBytes, MaxValue);
+	_mm_storeu_si128((__m128i *)Sums, SumValue);
+	for (int j = 0; j < 16; j++)
+	{
+		Partial.Min = std::min(Partial.Min, MinBytes[j]);
+		Partial.Max = std::max(Partial.Max, MaxBytes[j]);
+	}
+	Partial.Sum += Sums[0] + Sums[1];
+	for (; i > 0; i--)
+	{
+		Partial.Min = std::min(Partial.Min, *YImagePtr);
+		Partial.Max = std::max(Partial.Max, *YImagePtr);
+		Partial.Sum += *YImagePtr;
+		Partial.Histograms[0][*YImagePtr]++;
+		YImagePtr++;
+	}
+	Partial.PixelCount += PixelCount;
+}
+
+// MergeStatistics
+// adds the partial statistics of a thread to the final ones
+
+static void MergeStatistics(const PartialStatistics &Partial, LumaStatistics &Statistics)
+{
+	for (int Bin = 0; Bin < 256; Bin++)
+		Statistics.Histogram[Bin] += Partial.Histograms[0][Bin] + Partial.Histograms[1][Bin] + Partial.Histograms[2][Bin] + Partial.Histograms[3][Bin];
+	if (Partial.PixelCount > 0)
+	{
+		Statistics.Min = std::min(Statistics.Min, Partial.Min);
+		Statistics.Max = std::max(Statistics.Max, Partial.Max);
+	}
+	Statistics.Sum += Partial.Sum;
+	Statistics.PixelCount += Partial.PixelCount;
+}
+
+static void ClearStatistics(LumaStatistics &Statistics)
+{
+	memset(Statistics.Histogram, 0, sizeof(Statistics.Histogram));
+	Statistics.Min = 255;
+	Statistics.Max = 0;
+	Statistics.Sum = 0;
+	Statistics.PixelCount = 0;
+}
+
+bool AreLumaStatisticsEqual(const LumaStatistics &First, const LumaStatistics &Second)
+{
+	return (memcmp(First.Histogram, Second.Histogram, sizeof(First.Histogram)) == 0) && (First.Min == Second.Min) &&
+		   (First.Max == Second.Max) && (First.Sum == Second.Sum) && (First.PixelCount == Second.PixelCount);
+}
+
+// ComputeLumaStatistics
+// plain scalar code, independent of the optimized functions it is compared with
+
+void ComputeLumaStatistics(const unsigned char *YImage, int PixelCount, LumaStatistics &Statistics)
+{
+	ClearStatistics(Statistics);
+	for (int i = 0; i < PixelCount; i++)
+	{
+		unsigned char YValue = YImage[i];
+		Statistics.Histogram[YValue]++;
+		if (YValue < Statistics.Min)
+			Statistics.Min = YValue;
+		if (YValue > Statistics.Max)
+			Statistics.Max = YValue;
+		Statistics.Sum += YValue;
+	}
+	Statistics.PixelCount = PixelCount;
+}
+
+void ComputeLumaStatisticsTBB(const unsigned char *YImage, int PixelCount, LumaStatistics &Statistics)
+{
+	combinable<PartialStatistics> Partials;
+	parallel_for( blocked_range<int>( 0, (PixelCount + STATISTICS_BLOCK - 1) / STATISTICS_BLOCK),
+	    [=, &Partials](const blocked_range<int>& r) {
+			PartialStatistics &Partial = Partials.local();
+			int StartPixel = r.begin() * STATISTICS_BLOCK;
+			int StopPixel = std::min(r.end() * STATISTICS_BLOCK, PixelCount);
+			AccumulateStatistics(YImage + StartPixel, StopPixel - StartPixel, Partial);
+	      }
+	    );
+	ClearStatistics(Statistics);
+	Partials.combine_each([&Statistics](const PartialStatistics &Partial) {
+		MergeStatistics(Partial, Statistics);
+	});
+}
+
+void ProcessLumaWithStatistics(LumaFunction Kernel, int SourcePixelSize, void *SourceImage, void *YImage, int ImageWidth, int ImageHeight,
+							   LumaStatistics &Statistics)
+{
+	const int PixelCount = ImageWidth * ImageHeight;
+	combinable<PartialStatistics> Partials;
+	parallel_for( blocked_range<int>( 0, (PixelCount + STATISTICS_BLOCK - 1) / STATISTICS_BLOCK),
+	    [=, &Partials](const blocked_range<int>& r) {
+			PartialStatistics &Partial = Partials.local();
+			for (int Block = r.begin(); Block != r.end(); Block++)
+			{
+				int StartPixel = Block * STATISTICS_BLOCK;
+				int BlockPixels = std::min(STATISTICS_BLOCK, PixelCount - StartPixel);
+				unsigned char *YImagePtr = (unsigned char *)YImage + StartPixel;
+				Kernel((unsigned char *)SourceImage + StartPixel * SourcePixelSize, YImagePtr, BlockPixels, 1, SourcePixelSize);
+				AccumulateStatistics(YImagePtr, BlockPixels, Partial);
+			}
+	      }
+	    );
+	ClearStatistics(Statistics);
+	Partials.combine_each([&Statistics](const PartialStatistics &Partial) {
+		MergeStatistics(Partial, Statistics);
+	});
+}
+
+// ProcessRGBTBBSIMDStatistics
+// the kernels are selected once, during static initialization, like the other Auto functions
+
+static const LumaFunction RGB24StatisticsKernel = GetLumaFunction(PIXEL_FORMAT_RGB24, LUMA_BT601, false, LUMA_ISA_BEST, false);
+static const LumaFunction RGBA32StatisticsKernel = GetLumaFunction(PIXEL_FORMAT_RGBA32, LUMA_BT601, false, LUMA_ISA_BEST, false);
+
+void ProcessRGBTBBSIMDStatistics(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset,
+								 LumaStatistics &Statistics)
+{
+	LumaFunction Kernel = &ProcessRGBSerial;
+	if (PixelOffset == 3)
+		Kernel = RGB24StatisticsKernel;
+	else if (PixelOffset == 4)
+		Kernel = RGBA32StatisticsKernel;
+	ProcessLumaWithStatistics(Kernel, PixelOffset, SourceImage, YImage, ImageWidth, ImageHeight, Statistics);
+}
@@ -0,0 +1,51 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include "TBBDemoKernel.h"
+
+// luma statistics used for exposure control
+struct LumaStatistics {
+	unsigned int Histogram[256];
+	unsigned char Min;				//< 255 for an empty image
+	unsigned char Max;				//< 0 for an empty image
+	unsigned long long Sum;
+	unsigned long long PixelCount;
+};
+
+inline double GetLumaMean(const LumaStatistics &Statistics)
+{
+	return Statistics.PixelCount ? (double)Statistics.Sum / Statistics.PixelCount : 0.0;
+}
+
+bool AreLumaStatisticsEqual(const LumaStatistics &First, const LumaStatistics &Second);
+
+// ComputeLumaStatistics
+// serial second pass over a luma plane, the reference of the other functions
+void ComputeLumaStatistics(const unsigned char *YImage, int PixelCount, LumaStatistics &Statistics);
+
+// ComputeLumaStatisticsTBB
+// multi-threaded second pass over a luma plane
+void ComputeLumaStatisticsTBB(const unsigned char *YImage, int PixelCount, LumaStatistics &Statistics);
+
+// ProcessLumaWithStatistics
+// converts an image with Kernel, which must be single-threaded, and computes the statistics of the result in the same
+// pass: each task converts a block small enough to stay in the L1 cache and bins it right away, so the luma plane
+// is written to memory but never read back
+void ProcessLumaWithStatistics(LumaFunction Kernel, int SourcePixelSize, void *SourceImage, void *YImage, int ImageWidth, int ImageHeight,
+							   LumaStatistics &Statistics);
+
+// ProcessRGBTBBSIMDStatistics
+// BT.601 conversion with the widest instruction set available, fused with the statistics
+// PixelOffset selects the RGB24 (3) or RGBA32 (4) kernel, other pixel sizes use the scalar ProcessRGBSerial
+void ProcessRGBTBBSIMDStatistics(void *SourceImage, void *YImage, int ImageWidth, int ImageHeight, int PixelOffset,
+								 LumaStatistics &Statistics);
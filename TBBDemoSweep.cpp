@@ -0,0 +1,223 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoSweep.h"
+
+#include <algorithm>
+#include <iomanip>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range.h>
+#include <partitioner.h>
+#include <global_control.h>
+#include <task_arena.h>
+#include <info.h>
+using namespace tbb;
+
+std::vector<SweepImplementation> GetSweepImplementations()
+{
+	std::vector<SweepImplementation> Implementations;
+	SweepImplementation Implementation;
+	// ProcessRGBTBB2 runs the scalar code of ProcessRGBSerial on each chunk of pixels
+	Implementation.Name = "TBB2";
+	Implementation.Kernel = &ProcessRGBSerial;
+	Implementation.PixelBlock = 1;
+	Implementations.push_back(Implementation);
+	// ProcessRGBTBBSIMD runs the code of ProcessRGBSIMD on each chunk of groups of 4 pixels
+	Implementation.Name = "TBB SIMD";
+	Implementation.Kernel = &ProcessRGBSIMD;
+	Implementation.PixelBlock = 4;
+	Implementations.push_back(Implementation);
+	Implementation.Name = "TBB SIMD Auto";
+	Implementation.Kernel = &ProcessRGBSIMDAuto;
+	Implementation.PixelBlock = 32;
+	Implementations.push_back(Implementation);
+	return Implementations;
+}
+
+const char *GetPartitionerName(SweepPartitioner Partitioner)
+{
+	switch (Partitioner)
+	{
+	case SWEEP_PARTITIONER_SIMPLE:
+		return "simple";
+	case SWEEP_PARTITIONER_AUTO:
+		return "auto";
+	case SWEEP_PARTITIONER_STATIC:
+		return "static";
+	default:
+		return "affinity";
+	}
+}
+
+std::vector<int> GetDefaultSweepThreadCounts()
+{
+	const int HardwareThreads = info::default_concurrency();
+	std::vector<int> ThreadCounts;
+	for (int Threads = 1; Threads < HardwareThreads; Threads *= 2)
+		ThreadCounts.push_back(Threads);
+	ThreadCounts.push_back(HardwareThreads);
+	return ThreadCounts;
+}
+
+// RunChunks
+// same split of ProcessLuma with ExecutionTBB, but with the given grain size, counted in blocks, and partitioner
+
+template <class Partitioner>
+static void RunChunks(const SweepImplementation &Implementation, unsigned char *RGBAImage, unsigned char *YImage, int PixelCount,
+					  int GrainBlocks, Partitioner &PartitionerObject)
+{
+	const int RGBA_PIXEL_SIZE = 4;
+	const int PixelBlock = Implementation.PixelBlock;
+	ProcessRGBFunction Kernel = Implementation.Kernel;
+
+	parallel_for( blocked_range<int>( 0, (PixelCount + PixelBlock - 1) / PixelBlock, GrainBlocks),
+	    [=](const blocked_range<int>& r) {
+			int StartPixel = r.begin() * PixelBlock;
+			int StopPixel = std::min(r.end() * PixelBlock, PixelCount);
+			Kernel(RGBAImage + StartPixel * RGBA_PIXEL_SIZE, YImage + StartPixel, StopPixel - StartPixel, 1, RGBA_PIXEL_SIZE);
+	      },
+	    PartitionerObject);
+}
+
+// MeasureConfiguration
+// global_control caps the number of worker threads of the whole process, the arena makes sure that exactly Threads
+// of them take part in the parallel loop; the partitioner objects are created here so that the affinity one keeps
+// its state across the warm-up runs and the measured ones, as it would when the same image size is converted repeatedly
+
+static BenchmarkStatistics MeasureConfiguration(const SweepImplementation &Implementation, const SweepSettings &Settings,
+												SweepPartitioner Partitioner, int GrainSize, int Threads,
+												unsigned char *RGBAImage, unsigned char *YImage, int PixelCount)
+{
+	global_control ThreadLimit(global_control::max_allowed_parallelism, Threads);
+	task_arena Arena(Threads);
+	const int GrainBlocks = std::max(1, (GrainSize + Implementation.PixelBlock - 1) / Implementation.PixelBlock);
+	BenchmarkStatistics Statistics;
+	Arena.execute([&]() {
+		simple_partitioner SimplePartitioner;
+		auto_partitioner AutoPartitioner;
+		static_partitioner StaticPartitioner;
+		affinity_partitioner AffinityPartitioner;
+		Statistics = RunBenchmark([&]() {
+				switch (Partitioner)
+				{
+				case SWEEP_PARTITIONER_SIMPLE:
+					RunChunks(Implementation, RGBAImage, YImage, PixelCount, GrainBlocks, SimplePartitioner);
+					break;
+				case SWEEP_PARTITIONER_AUTO:
+					RunChunks(Implementation, RGBAImage, YImage, PixelCount, GrainBlocks, AutoPartitioner);
+					break;
+				case SWEEP_PARTITIONER_STATIC:
+					RunChunks(Implementation, RGBAImage, YImage, PixelCount, GrainBlocks, StaticPartitioner);
+					break;
+				default:
+					RunChunks(Implementation, RGBAImage, YImage, PixelCount, GrainBlocks, AffinityPartitioner);
+					break;
+				}
+			}, Settings.Options);
+	});
+	return Statistics;
+}
+
+std::vector<SweepResult> RunScalingSweep(const SweepImplementation &Implementation, const SweepSettings &Settings,
+										 unsigned char *RGBAImage, unsigned char *YImage, int ImageWidth, int ImageHeight)
+{
+	std::vector<int> ThreadCounts = Settings.ThreadCounts;
+	if (std::find(ThreadCounts.begin(), ThreadCounts.end(), 1) == ThreadCounts.end())
+		ThreadCounts.insert(ThreadCounts.begin(), 1);
+	std::sort(ThreadCounts.begin(), ThreadCounts.end());
+
+	std::vector<SweepResult> Results;
+	for (auto PartitionersPtr = Settings.Partitioners.begin(); PartitionersPtr != Settings.Partitioners.end(); PartitionersPtr++)
+		for (auto GrainSizesPtr = Settings.GrainSizes.begin(); GrainSizesPtr != Settings.GrainSizes.end(); GrainSizesPtr++)
+		{
+			double SerialMedianNs = 0.0;
+			for (auto ThreadCountsPtr = ThreadCounts.begin(); ThreadCountsPtr != ThreadCounts.end(); ThreadCountsPtr++)
+			{
+				SweepResult Result;
+				Result.Implementation = Implementation.Name;
+				Result.ImageWidth = ImageWidth;
+				Result.ImageHeight = ImageHeight;
+				Result.Partitioner = *PartitionersPtr;
+				Result.GrainSize = *GrainSizesPtr;
+				Result.Threads = *ThreadCountsPtr;
+				Result.Statistics = MeasureConfiguration(Implementation, Settings, Result.Partitioner, Result.GrainSize, Result.Threads,
+														 RGBAImage, YImage, ImageWidth * ImageHeight);
+				if (Result.Threads == 1)
+					SerialMedianNs = Result.Statistics.MedianNs;
+				Result.Speedup = (Result.Statistics.MedianNs > 0.0) ? SerialMedianNs / Result.Statistics.MedianNs : 0.0;
+				Result.Efficiency = Result.Speedup / Result.Threads;
+				Results.push_back(Result);
+			}
+		}
+	return Results;
+}
+
+// IsSameTable
+// results belong to the same table when they differ only by grain size and thread count
+
+static bool IsSameTable(const SweepResult &First, const SweepResult &Second)
+{
+	return (First.Implementation == Second.Implementation) && (First.ImageWidth == Second.ImageWidth) &&
+		   (First.ImageHeight == Second.ImageHeight) && (First.Partitioner == Second.Partitioner);
+}
+
+void WriteSweepTables(std::ostream &Stream, const std::vector<SweepResult> &Results)
+{
+	std::ios::fmtflags Flags = Stream.flags();
+	std::streamsize Precision = Stream.precision();
+	size_t TableStart = 0;
+	while (TableStart < Results.size())
+	{
+		const SweepResult &First = Results[TableStart];
+		size_t TableStop = TableStart;
+		while ((TableStop < Results.size()) && IsSameTable(First, Results[TableStop]))
+			TableStop++;
+
+		// the thread counts of the first grain size are the columns of the table
+		std::vector<int> ThreadCounts;
+		for (size_t i = TableStart; (i < TableStop) && (Results[i].GrainSize == First.GrainSize); i++)
+			ThreadCounts.push_back(Results[i].Threads);
+
+		Stream << std::endl << First.Implementation << ", " << First.ImageWidth << "x" << First.ImageHeight << ", "
+			   << GetPartitionerName(First.Partitioner) << " partitioner: speedup (efficiency %)" << std::endl;
+		Stream << std::right << std::setw(10) << "grain";
+		for (size_t i = 0; i < ThreadCounts.size(); i++)
+			Stream << std::setw(16) << (std::to_string((long long)ThreadCounts[i]) + (ThreadCounts[i] == 1 ? " thread" : " threads"));
+		Stream << std::endl;
+		for (size_t i = TableStart; i < TableStop; i += ThreadCounts.size())
+		{
+			Stream << std::setw(10) << Results[i].GrainSize;
+			for (size_t j = i; (j < i + ThreadCounts.size()) && (j < TableStop); j++)
+				Stream << std::fixed << std::setprecision(2) << std::setw(10) << Results[j].Speedup
+					   << std::setprecision(0) << " (" << std::setw(3) << Results[j].Efficiency * 100.0 << ")";
+			Stream << std::endl;
+		}
+		TableStart = TableStop;
+	}
+	Stream.flags(Flags);
+	Stream.precision(Precision);
+}
+
+void WriteSweepCSV(std::ostream &Stream, const std::vector<SweepResult> &Results)
+{
+	std::ios::fmtflags Flags = Stream.flags();
+	std::streamsize Precision = Stream.precision();
+	Stream << "implementation,width,height,partitioner,grain,threads,median_ns,p95_ns,speedup,efficiency" << std::endl;
+	for (auto ResultsPtr = Results.begin(); ResultsPtr != Results.end(); ResultsPtr++)
+		Stream << ResultsPtr->Implementation << "," << ResultsPtr->ImageWidth << "," << ResultsPtr->ImageHeight << ","
+			   << GetPartitionerName(ResultsPtr->Partitioner) << "," << ResultsPtr->GrainSize << "," << ResultsPtr->Threads << ","
+			   << std::fixed << std::setprecision(0) << ResultsPtr->Statistics.MedianNs << "," << ResultsPtr->Statistics.P95Ns << ","
+			   << std::setprecision(3) << ResultsPtr->Speedup << "," << ResultsPtr->Efficiency << std::endl;
+	Stream.flags(Flags);
+	Stream.precision(Precision);
+}
@@ -0,0 +1,71 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TBBBenchmark.h"
+#include "TBBDemoRoutines.h"
+
+// scaling sweep
+// runs the body of a TBB implementation under every combination of thread count, grain size and partitioner, to find
+// where it stops scaling and which scheduling settings suit a machine
+
+enum SweepPartitioner {
+	SWEEP_PARTITIONER_SIMPLE,
+	SWEEP_PARTITIONER_AUTO,
+	SWEEP_PARTITIONER_STATIC,
+	SWEEP_PARTITIONER_AFFINITY		//< one affinity_partitioner is reused by all the runs of a configuration
+};
+
+// the serial kernel run on each chunk, PixelBlock is the number of pixels per loop, chunks are multiples of it
+struct SweepImplementation {
+	std::string Name;
+	ProcessRGBFunction Kernel;
+	int PixelBlock;
+};
+
+struct SweepSettings {
+	std::vector<int> ThreadCounts;
+	std::vector<int> GrainSizes;				//< in pixels, rounded up to a multiple of PixelBlock
+	std::vector<SweepPartitioner> Partitioners;
+	BenchmarkOptions Options;
+};
+
+struct SweepResult {
+	std::string Implementation;
+	int ImageWidth;
+	int ImageHeight;
+	SweepPartitioner Partitioner;
+	int GrainSize;
+	int Threads;
+	BenchmarkStatistics Statistics;
+	double Speedup;					//< median time with 1 thread divided by the median time with Threads threads
+	double Efficiency;				//< Speedup / Threads
+};
+
+// the implementations that can be swept: the bodies of ProcessRGBTBB2, ProcessRGBTBBSIMD and ProcessRGBTBBSIMDAuto
+std::vector<SweepImplementation> GetSweepImplementations();
+const char *GetPartitionerName(SweepPartitioner Partitioner);
+// default thread counts: powers of two up to the number of hardware threads, and the number of hardware threads
+std::vector<int> GetDefaultSweepThreadCounts();
+
+// sweeps an implementation on an RGBA image, a run with 1 thread is always measured as the reference of the speedup
+std::vector<SweepResult> RunScalingSweep(const SweepImplementation &Implementation, const SweepSettings &Settings,
+										 unsigned char *RGBAImage, unsigned char *YImage, int ImageWidth, int ImageHeight);
+
+// one table per implementation and partitioner, with a row per grain size and the speedup and efficiency of
+// each thread count in the columns
+void WriteSweepTables(std::ostream &Stream, const std::vector<SweepResult> &Results);
+void WriteSweepCSV(std::ostream &Stream, const std::vector<SweepResult> &Results);
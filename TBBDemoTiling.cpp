@@ -0,0 +1,142 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoTiling.h"
+#include "TBBDemoCPU.h"
+#include "TBBDemoKernel.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range2d.h>
+#include <partitioner.h>
+using namespace tbb;
+
+const int TILE_MAX_WIDTH = 4096;
+const int TILE_PIXEL_BLOCK = 32;
+
+TileSettings GetDefaultTileSettings(PixelFormat SourceFormat, int ImageWidth)
+{
+	const int BytesPerPixel = GetPixelSize(SourceFormat) + 1;
+	TileSettings Tiles;
+	Tiles.TileWidth = std::min((std::max(ImageWidth, 1) + TILE_PIXEL_BLOCK - 1) / TILE_PIXEL_BLOCK * TILE_PIXEL_BLOCK, TILE_MAX_WIDTH);
+	Tiles.TileHeight = std::max(1, (GetCPUCacheSizes().L2 / 2) / (Tiles.TileWidth * BytesPerPixel));
+	return Tiles;
+}
+
+size_t GetTiledImageSize(int Width, int Height, const TileSettings &Tiles)
+{
+	size_t TileColumns = (Width + Tiles.TileWidth - 1) / Tiles.TileWidth;
+	size_t TileRows = (Height + Tiles.TileHeight - 1) / Tiles.TileHeight;
+	return TileColumns * TileRows * Tiles.TileWidth * Tiles.TileHeight;
+}
+
+TiledImage MakeTiledImage(void *Data, int Width, int Height, const TileSettings &Tiles)
+{
+	TiledImage Image;
+	Image.Data = (unsigned char *)Data;
+	Image.Width = Width;
+	Image.Height = Height;
+	Image.Tiles = Tiles;
+	return Image;
+}
+
+void UntileImage(const TiledImage &Source, const ImageDescriptor &YImage)
+{
+	assert((YImage.Format == PIXEL_FORMAT_Y8) && (YImage.Width == Source.Width) && (YImage.Height == Source.Height));
+	for (int y = 0; y < Source.Height; y++)
+	{
+		const int TileRow = y / Source.Tiles.TileHeight;
+		const int RowInTile = y % Source.Tiles.TileHeight;
+		for (int x = 0; x < Source.Width; x += Source.Tiles.TileWidth)
+		{
+			const unsigned char *TilePtr = GetTile(Source, TileRow, x / Source.Tiles.TileWidth);
+			memcpy(GetImageRow(YImage, y) + x, TilePtr + RowInTile * Source.Tiles.TileWidth, std::min(Source.Tiles.TileWidth, Source.Width - x));
+		}
+	}
+}
+
+// ConvertTiles
+// calls ConvertRow(TileRow, TileColumn, y, StartX, StopX) for each row of each tile; simple_partitioner splits the range down to single
+// tiles, which are large enough to make the cost of a task negligible, and the rows of a tile are converted one
+// after the other so that its pixels stay in the cache of the core that converts it
+// returns false, without converting anything, when the tile size is not supported
+
+template <class RowFunction>
+static bool ConvertTiles(int Width, int Height, const TileSettings &Tiles, const RowFunction &ConvertRow)
+{
+	if ((Tiles.TileWidth <= 0) || (Tiles.TileWidth % TILE_PIXEL_BLOCK != 0) || (Tiles.TileHeight <= 0))
+		return false;
+	const int TileColumns = (Width + Tiles.TileWidth - 1) / Tiles.TileWidth;
+	const int TileRows = (Height + Tiles.TileHeight - 1) / Tiles.TileHeight;
+
+	parallel_for( blocked_range2d<int,int>( 0, TileRows, 1, 0, TileColumns, 1),
+	    [&](const blocked_range2d<int,int>& r) {
+			for (int TileRow = r.rows().begin(); TileRow != r.rows().end(); TileRow++)
+				for (int TileColumn = r.cols().begin(); TileColumn != r.cols().end(); TileColumn++)
+				{
+					const int StartX = TileColumn * Tiles.TileWidth;
+					const int StopX = std::min(StartX + Tiles.TileWidth, Width);
+					const int StartY = TileRow * Tiles.TileHeight;
+					const int StopY = std::min(StartY + Tiles.TileHeight, Height);
+					for (int y = StartY; y < StopY; y++)
+						ConvertRow(TileRow, TileColumn, y, StartX, StopX);
+				}
+	      },
+	    simple_partitioner()
+	    );
+	return true;
+}
+
+// CheckTiledSource
+// the images come from the caller, so they are checked in Release builds too, like the ones of the ImageDescriptor
+// versions of the kernels
+
+static bool CheckTiledSource(const ImageDescriptor &Source, int YWidth, int YHeight)
+{
+	if (!IsRGB8Format(Source.Format))
+		return false;
+	return (Source.Width == YWidth) && (Source.Height == YHeight) && (Source.Width >= 0) && (Source.Height >= 0);
+}
+
+bool ConvertToLumaTiled(const ImageDescriptor &Source, const ImageDescriptor &YImage, const TileSettings &Tiles)
+{
+	if (!CheckTiledSource(Source, YImage.Width, YImage.Height) || (YImage.Format != PIXEL_FORMAT_Y8))
+		return false;
+	const LumaFunction Kernel = GetLumaFunction(Source.Format, LUMA_BT601, false, LUMA_ISA_BEST, false);
+	if (!Kernel)
+		return false;
+	const int PixelOffset = GetPixelSize(Source.Format);
+
+	return ConvertTiles(Source.Width, Source.Height, Tiles, [&](int, int, int y, int StartX, int StopX) {
+			Kernel(GetImageRow(Source, y) + StartX * PixelOffset, GetImageRow(YImage, y) + StartX, StopX - StartX, 1, PixelOffset);
+		});
+}
+
+bool ConvertToLumaTiled(const ImageDescriptor &Source, const TiledImage &YImage)
+{
+	if (!CheckTiledSource(Source, YImage.Width, YImage.Height))
+		return false;
+	const LumaFunction Kernel = GetLumaFunction(Source.Format, LUMA_BT601, false, LUMA_ISA_BEST, false);
+	if (!Kernel)
+		return false;
+	const int PixelOffset = GetPixelSize(Source.Format);
+	const int TileWidth = YImage.Tiles.TileWidth;
+	const int TileHeight = YImage.Tiles.TileHeight;
+
+	return ConvertTiles(Source.Width, Source.Height, YImage.Tiles, [&](int TileRow, int TileColumn, int y, int StartX, int StopX) {
+			unsigned char *YImagePtr = GetTile(YImage, TileRow, TileColumn) + (y - TileRow * TileHeight) * TileWidth;
+			Kernel(GetImageRow(Source, y) + StartX * PixelOffset, YImagePtr, StopX - StartX, 1, PixelOffset);
+		});
+}
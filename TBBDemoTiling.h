@@ -0,0 +1,64 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include "TBBDemoImage.h"
+
+#include <stddef.h>
+
+// size in pixels of the tiles, each tile is the work of one task
+struct TileSettings {
+	int TileWidth;			//< multiple of 32 pixels, the block of the AVX2 kernels
+	int TileHeight;
+};
+
+// GetDefaultTileSettings
+// tiles as wide as the image up to 4096 pixels and as tall as needed for the source and luma pixels of a tile to fill
+// half of the L2 cache, leaving the other half to the processing that follows the conversion
+// narrower tiles would be more square, but rows shorter than a few pages break the streams of the hardware prefetchers
+// and add TLB misses, and the conversion alone runs slower than with 1D ranges
+TileSettings GetDefaultTileSettings(PixelFormat SourceFormat, int ImageWidth);
+
+// TiledImage
+// luma image stored tile after tile, in row-major order of the tiles; each tile takes TileWidth * TileHeight bytes
+// with rows of TileWidth bytes, and the tiles on the right and bottom edges are padded to the full size
+struct TiledImage {
+	unsigned char *Data;
+	int Width;
+	int Height;
+	TileSettings Tiles;
+};
+
+inline int GetTileColumns(const TiledImage &Image)
+{
+	return (Image.Width + Image.Tiles.TileWidth - 1) / Image.Tiles.TileWidth;
+}
+
+inline unsigned char *GetTile(const TiledImage &Image, int TileRow, int TileColumn)
+{
+	return Image.Data + ((long long)TileRow * GetTileColumns(Image) + TileColumn) * Image.Tiles.TileWidth * Image.Tiles.TileHeight;
+}
+
+size_t GetTiledImageSize(int Width, int Height, const TileSettings &Tiles);
+TiledImage MakeTiledImage(void *Data, int Width, int Height, const TileSettings &Tiles);
+
+// UntileImage
+// copies a tiled luma image to a PIXEL_FORMAT_Y8 image with the same dimensions
+void UntileImage(const TiledImage &Source, const ImageDescriptor &YImage);
+
+// ConvertToLumaTiled
+// multi-threaded BT.601 conversion of any RGB pixel format, one task per tile, with the widest SIMD kernel applied
+// to each row of a tile; the images must not overlap
+// returns false, without converting anything, when the formats, the dimensions or the tile size are not supported
+bool ConvertToLumaTiled(const ImageDescriptor &Source, const ImageDescriptor &YImage, const TileSettings &Tiles);
+// same as above, writing each tile to its own contiguous block of a tiled luma image
+bool ConvertToLumaTiled(const ImageDescriptor &Source, const TiledImage &YImage);
@@ -0,0 +1,291 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoTuner.h"
+#include "TBBDemoCPU.h"
+#include "TBBDemoRoutines.h"
+#include "TBBDemoTiling.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+
+// Intel TBB library
+#include <task_arena.h>
+using namespace tbb;
+
+// version of the cache file layout, a file with another version is ignored
+const int TUNER_CACHE_VERSION = 1;
+
+static const PixelFormat TunerFormats[] = {
+	PIXEL_FORMAT_RGB24, PIXEL_FORMAT_RGBA32, PIXEL_FORMAT_BGR24, PIXEL_FORMAT_BGRA32, PIXEL_FORMAT_ARGB32
+};
+
+struct TunerSizeClassInfo {
+	const char *Name;
+	long long MaxPixels;
+	int Width;
+	int Height;
+};
+
+static const TunerSizeClassInfo TunerSizeClasses[TUNER_SIZE_CLASSES] = {
+	{ "small", 256 * 256, 192, 192 },
+	{ "medium", 1024 * 1024, 640, 480 },
+	{ "large", 4096 * 4096, 1920, 1080 },
+	{ "huge", 0, 4096, 4096 }
+};
+
+// backends that take ImageDescriptor arguments but whose functions have other parameters
+
+static bool ConvertSerialSIMD(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ConvertToLuma(Source, YImage, LUMA_BT601, false, false);
+}
+
+static bool ConvertTBBSIMD(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ConvertToLuma(Source, YImage, LUMA_BT601, false, true);
+}
+
+static bool ConvertTiled(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return ConvertToLumaTiled(Source, YImage, GetDefaultTileSettings(Source.Format, Source.Width));
+}
+
+// CreateTunerBackends
+// the first backend is the one used before tuning, the SSSE3 kernels of ProcessRGBTBBSIMD are registered only
+// when the CPU supports them
+
+static std::vector<TunerBackend> CreateTunerBackends()
+{
+	std::vector<TunerBackend> Backends;
+	TunerBackend Backend;
+	Backend.Name = "TBB SIMD";
+	Backend.Function = &ConvertTBBSIMD;
+	Backends.push_back(Backend);
+	Backend.Name = "Serial SIMD";
+	Backend.Function = &ConvertSerialSIMD;
+	Backends.push_back(Backend);
+	if (GetCPUFeatures().SSSE3)
+	{
+		Backend.Name = "TBB SSSE3";
+		Backend.Function = &ProcessRGBTBBSIMD;
+		Backends.push_back(Backend);
+	}
+	Backend.Name = "Tiled";
+	Backend.Function = &ConvertTiled;
+	Backends.push_back(Backend);
+	return Backends;
+}
+
+const std::vector<TunerBackend> &GetTunerBackends()
+{
+	static const std::vector<TunerBackend> Backends = CreateTunerBackends();
+	return Backends;
+}
+
+const char *GetTunerSizeClassName(TunerSizeClass SizeClass)
+{
+	return TunerSizeClasses[SizeClass].Name;
+}
+
+TunerSizeClass GetTunerSizeClass(int Width, int Height)
+{
+	long long Pixels = (long long)Width * Height;
+	int SizeClass = TUNER_SIZE_SMALL;
+	while ((SizeClass < TUNER_SIZE_HUGE) && (Pixels > TunerSizeClasses[SizeClass].MaxPixels))
+		SizeClass++;
+	return (TunerSizeClass)SizeClass;
+}
+
+// GetTunerKey
+// the CPU and the number of threads of the current arena, the two values that a cache file must match
+
+static std::string GetTunerKey()
+{
+	return std::string("cpu ") + GetCPUBrandString() + "\nthreads " + std::to_string((long long)this_task_arena::max_concurrency());
+}
+
+// ConversionTuner::ConversionTuner
+// until tuned or loaded, every image is converted by the multi-threaded SIMD backend
+
+ConversionTuner::ConversionTuner() : Tuned(false)
+{
+	for (int i = 0; i <= PIXEL_FORMAT_ARGB32; i++)
+		for (int j = 0; j < TUNER_SIZE_CLASSES; j++)
+			Selection[i][j] = 0;
+}
+
+// ConversionTuner::Tune
+// each format is tuned on a single source image of the largest size, filled with random values, the smaller size
+// classes use its first pixels; a backend is timed only after its output has been compared with the serial kernel
+
+void ConversionTuner::Tune(const BenchmarkOptions &Options, std::vector<TunerMeasurement> *Measurements)
+{
+	const std::vector<TunerBackend> &Backends = GetTunerBackends();
+	const int MaxPixels = TunerSizeClasses[TUNER_SIZE_HUGE].Width * TunerSizeClasses[TUNER_SIZE_HUGE].Height;
+	unsigned char *RGBImage = new unsigned char[MaxPixels * 4];
+	unsigned char *GrayImage = new unsigned char[MaxPixels];
+	unsigned char *ReferenceImage = new unsigned char[MaxPixels];
+	FillRandomImage(RGBImage, MaxPixels * 4);
+
+	for (int i = 0; i < (int)(sizeof(TunerFormats) / sizeof(TunerFormats[0])); i++)
+		for (int SizeClass = 0; SizeClass < TUNER_SIZE_CLASSES; SizeClass++)
+		{
+			const int ImageWidth = TunerSizeClasses[SizeClass].Width;
+			const int ImageHeight = TunerSizeClasses[SizeClass].Height;
+			const ImageDescriptor Source = MakeImageDescriptor(RGBImage, ImageWidth, ImageHeight, TunerFormats[i]);
+			const ImageDescriptor YImage = MakeImageDescriptor(GrayImage, ImageWidth, ImageHeight, PIXEL_FORMAT_Y8);
+			const ImageDescriptor ReferenceYImage = MakeImageDescriptor(ReferenceImage, ImageWidth, ImageHeight, PIXEL_FORMAT_Y8);
+			ProcessRGBSerial(Source, ReferenceYImage);
+
+			double BestMedianNs = 0.0;
+			for (int Backend = 0; Backend < (int)Backends.size(); Backend++)
+			{
+				TunerMeasurement Measurement;
+				Measurement.Format = TunerFormats[i];
+				Measurement.SizeClass = (TunerSizeClass)SizeClass;
+				Measurement.ImageWidth = ImageWidth;
+				Measurement.ImageHeight = ImageHeight;
+				Measurement.Backend = Backends[Backend].Name;
+				memset(GrayImage, 0, ImageWidth * ImageHeight);
+				Backends[Backend].Function(Source, YImage);
+				Measurement.Verified = (memcmp(GrayImage, ReferenceImage, ImageWidth * ImageHeight) == 0);
+				memset(&Measurement.Statistics, 0, sizeof(Measurement.Statistics));
+				if (Measurement.Verified)
+				{
+					ImageFunction Function = Backends[Backend].Function;
+					Measurement.Statistics = RunBenchmark([=]() { Function(Source, YImage); }, Options);
+					if ((BestMedianNs == 0.0) || (Measurement.Statistics.MedianNs < BestMedianNs))
+					{
+						BestMedianNs = Measurement.Statistics.MedianNs;
+						Selection[TunerFormats[i]][SizeClass] = Backend;
+					}
+				}
+				if (Measurements)
+					Measurements->push_back(Measurement);
+			}
+		}
+	Tuned = true;
+
+	delete[] RGBImage;
+	delete[] GrayImage;
+	delete[] ReferenceImage;
+}
+
+// ConversionTuner::LoadCache
+// the file starts with the key and the version, followed by a line per format and size class:
+// <format> <size class> <backend name>
+
+bool ConversionTuner::LoadCache(const std::string &FileName)
+{
+	std::ifstream File(FileName.c_str());
+	if (!File)
+		return false;
+	std::string Line, Header;
+	const std::string ExpectedHeader = GetTunerKey() + "\nversion " + std::to_string((long long)TUNER_CACHE_VERSION) + "\n";
+	for (int i = 0; (i < 3) && std::getline(File, Line); i++)
+		Header += Line + "\n";
+	if (Header != ExpectedHeader)
+		return false;
+
+	const std::vector<TunerBackend> &Backends = GetTunerBackends();
+	int Loaded[PIXEL_FORMAT_ARGB32 + 1][TUNER_SIZE_CLASSES];
+	memcpy(Loaded, Selection, sizeof(Loaded));
+	int Entries = 0;
+	while (std::getline(File, Line))
+	{
+		size_t FirstSpace = Line.find(' ');
+		size_t SecondSpace = (FirstSpace == std::string::npos) ? std::string::npos : Line.find(' ', FirstSpace + 1);
+		if (SecondSpace == std::string::npos)
+			return false;
+		std::string FormatName = Line.substr(0, FirstSpace);
+		std::string SizeClassName = Line.substr(FirstSpace + 1, SecondSpace - FirstSpace - 1);
+		std::string BackendName = Line.substr(SecondSpace + 1);
+		int Format = 0, SizeClass = 0, Backend = 0;
+		while ((Format < (int)(sizeof(TunerFormats) / sizeof(TunerFormats[0]))) && (FormatName != GetPixelFormatName(TunerFormats[Format])))
+			Format++;
+		while ((SizeClass < TUNER_SIZE_CLASSES) && (SizeClassName != TunerSizeClasses[SizeClass].Name))
+			SizeClass++;
+		while ((Backend < (int)Backends.size()) && (BackendName != Backends[Backend].Name))
+			Backend++;
+		if ((Format == (int)(sizeof(TunerFormats) / sizeof(TunerFormats[0]))) || (SizeClass == TUNER_SIZE_CLASSES) || (Backend == (int)Backends.size()))
+			return false;
+		Loaded[TunerFormats[Format]][SizeClass] = Backend;
+		Entries++;
+	}
+	// every combination must be present, a partial file is not used
+	if (Entries != (int)(sizeof(TunerFormats) / sizeof(TunerFormats[0])) * TUNER_SIZE_CLASSES)
+		return false;
+	memcpy(Selection, Loaded, sizeof(Selection));
+	Tuned = true;
+	return true;
+}
+
+bool ConversionTuner::SaveCache(const std::string &FileName) const
+{
+	std::ofstream File(FileName.c_str());
+	if (!File)
+		return false;
+	File << GetTunerKey() << "\nversion " << TUNER_CACHE_VERSION << "\n";
+	const std::vector<TunerBackend> &Backends = GetTunerBackends();
+	for (int i = 0; i < (int)(sizeof(TunerFormats) / sizeof(TunerFormats[0])); i++)
+		for (int SizeClass = 0; SizeClass < TUNER_SIZE_CLASSES; SizeClass++)
+			File << GetPixelFormatName(TunerFormats[i]) << " " << TunerSizeClasses[SizeClass].Name << " "
+				 << Backends[Selection[TunerFormats[i]][SizeClass]].Name << "\n";
+	return (bool)File;
+}
+
+const TunerBackend &ConversionTuner::GetBackend(PixelFormat Format, int Width, int Height) const
+{
+	return GetTunerBackends()[Selection[Format][GetTunerSizeClass(Width, Height)]];
+}
+
+bool ConversionTuner::Convert(const ImageDescriptor &Source, const ImageDescriptor &YImage) const
+{
+	// Selection has no entries for the high bit depth formats
+	if (!IsRGB8Format(Source.Format))
+		return false;
+	return GetBackend(Source.Format, Source.Width, Source.Height).Function(Source, YImage);
+}
+
+const char *GetDefaultTunerCacheName()
+{
+	return "TBBDemoTuning.txt";
+}
+
+// CreateDefaultTuner
+// tuning takes a few seconds, so it uses fewer repetitions than the benchmarks
+
+static ConversionTuner CreateDefaultTuner()
+{
+	ConversionTuner Tuner;
+	if (!Tuner.LoadCache(GetDefaultTunerCacheName()))
+	{
+		BenchmarkOptions Options;
+		Options.WarmupRuns = 1;
+		Options.Repetitions = 5;
+		Tuner.Tune(Options);
+		Tuner.SaveCache(GetDefaultTunerCacheName());
+	}
+	return Tuner;
+}
+
+const ConversionTuner &GetDefaultTuner()
+{
+	static const ConversionTuner Tuner = CreateDefaultTuner();
+	return Tuner;
+}
+
+bool ConvertToLumaTuned(const ImageDescriptor &Source, const ImageDescriptor &YImage)
+{
+	return GetDefaultTuner().Convert(Source, YImage);
+}
@@ -0,0 +1,92 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include "TBBBenchmark.h"
+#include "TBBDemoImage.h"
+
+#include <string>
+#include <vector>
+
+// ImageFunction
+// signature of the implementations that the tuner chooses from, they all produce the BT.601 luma of the serial kernel
+// and return false when they do not support the images
+typedef bool (*ImageFunction)(const ImageDescriptor &Source, const ImageDescriptor &YImage);
+
+struct TunerBackend {
+	const char *Name;
+	ImageFunction Function;
+};
+
+// the implementations available on this CPU
+const std::vector<TunerBackend> &GetTunerBackends();
+
+// size classes of the images, by number of pixels, each one is tuned on a representative size
+enum TunerSizeClass {
+	TUNER_SIZE_SMALL,		//< up to 256x256 pixels, tuned on 192x192
+	TUNER_SIZE_MEDIUM,		//< up to 1024x1024 pixels, tuned on 640x480
+	TUNER_SIZE_LARGE,		//< up to 4096x4096 pixels, tuned on 1920x1080
+	TUNER_SIZE_HUGE,		//< tuned on 4096x4096
+	TUNER_SIZE_CLASSES
+};
+
+const char *GetTunerSizeClassName(TunerSizeClass SizeClass);
+TunerSizeClass GetTunerSizeClass(int Width, int Height);
+
+// timing of one backend on one pixel format and size class
+struct TunerMeasurement {
+	PixelFormat Format;
+	TunerSizeClass SizeClass;
+	int ImageWidth;
+	int ImageHeight;
+	std::string Backend;
+	bool Verified;			//< false when the output differs from the serial kernel, the backend is then never selected
+	BenchmarkStatistics Statistics;
+};
+
+// ConversionTuner
+// chooses the fastest verified backend for each RGB pixel format and size class, until it is tuned or loaded every
+// image is converted by the multi-threaded SIMD backend
+// the choices depend on the CPU and on the number of threads, which are stored in the cache file together with
+// them: a cache written on another machine, or with another thread count, is not loaded
+class ConversionTuner {
+public:
+	ConversionTuner();
+
+	// times every backend on every format and size class, the measurements are appended to Measurements when not NULL
+	void Tune(const BenchmarkOptions &Options, std::vector<TunerMeasurement> *Measurements = NULL);
+	// returns false when the file is missing, invalid or written for another CPU or thread count
+	bool LoadCache(const std::string &FileName);
+	bool SaveCache(const std::string &FileName) const;
+	bool IsTuned() const { return Tuned; }
+
+	const TunerBackend &GetBackend(PixelFormat Format, int Width, int Height) const;
+	bool Convert(const ImageDescriptor &Source, const ImageDescriptor &YImage) const;
+
+private:
+	bool Tuned;
+	// index in GetTunerBackends() of the winner of each format and size class
+	int Selection[PIXEL_FORMAT_ARGB32 + 1][TUNER_SIZE_CLASSES];
+};
+
+// name of the cache file used by ConvertToLumaTuned, in the current directory
+const char *GetDefaultTunerCacheName();
+
+// GetDefaultTuner
+// tuner shared by the whole process, created on first use from the cache file, or by tuning and then writing the
+// cache file when it cannot be loaded
+const ConversionTuner &GetDefaultTuner();
+
+// ConvertToLumaTuned
+// BT.601 conversion of any RGB pixel format with the backend chosen by the default tuner for the image
+// returns false, without converting anything, when the formats or the dimensions of the images are not supported
+bool ConvertToLumaTuned(const ImageDescriptor &Source, const ImageDescriptor &YImage);
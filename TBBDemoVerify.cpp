@@ -0,0 +1,269 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "TBBDemoVerify.h"
+
+#include <random>
+#include <sstream>
+
+// bytes of the luma buffer checked for stray writes before and after the image
+const int VERIFY_GUARD_SIZE = 64;
+
+std::vector<PixelFormat> GetRGBPixelFormats()
+{
+	std::vector<PixelFormat> Formats;
+	for (int Format = PIXEL_FORMAT_RGB24; Format <= PIXEL_FORMAT_ARGB32; Format++)
+		Formats.push_back((PixelFormat)Format);
+	return Formats;
+}
+
+// VerifyCase
+// geometry of a random case, drawn by MakeVerifyCase
+
+struct VerifyCase {
+	PixelFormat Format;
+	int Width;
+	int Height;
+	int SourceStride;
+	int YStride;
+	int SourceOffset;			//< distance of the buffer from a 64-byte boundary
+	int YOffset;
+	bool Extremes;				//< channels are either 0 or 255, so that the clamping and the largest sums are exercised
+};
+
+// MakeVerifyCase
+// a quarter of the cases are narrower than 64 pixels, shorter than the blocks of the SIMD loops, and a quarter are
+// at most 4 rows tall, so that the tails and the splits of the parallel loops fall in many different places
+// rows are padded by a number of bytes that is often not a multiple of the pixel size, and one case in 8 is bottom-up
+
+static VerifyCase MakeVerifyCase(std::mt19937 &Random, const VerifyTarget &Target, const VerifyOptions &Options)
+{
+	VerifyCase Case;
+	Case.Format = Target.Formats[Random() % Target.Formats.size()];
+	Case.Width = 1 + (int)(Random() % ((Random() % 4) ? Options.MaxWidth : std::min(Options.MaxWidth, 64)));
+	Case.Height = 1 + (int)(Random() % ((Random() % 4) ? Options.MaxHeight : std::min(Options.MaxHeight, 4)));
+	if (Target.PixelGranularity > 1)
+		Case.Width = (Case.Width + Target.PixelGranularity - 1) / Target.PixelGranularity * Target.PixelGranularity;
+	int SourcePadding = (Random() % 3) ? (int)(Random() % 67) : 0;
+	int YPadding = (Random() % 3) ? (int)(Random() % 41) : 0;
+	bool BottomUp = (Random() % 8) == 0;
+	if (Target.PackedOnly)
+	{
+		SourcePadding = 0;
+		YPadding = 0;
+		BottomUp = false;
+	}
+	Case.SourceStride = Case.Width * GetPixelSize(Case.Format) + SourcePadding;
+	Case.YStride = Case.Width + YPadding;
+	if (BottomUp)
+	{
+		Case.SourceStride = -Case.SourceStride;
+		Case.YStride = -Case.YStride;
+	}
+	Case.SourceOffset = (int)(Random() % 64);
+	Case.YOffset = (int)(Random() % 64);
+	Case.Extremes = (Random() % 4) == 0;
+	return Case;
+}
+
+// AlignBuffer
+// returns the first byte of Buffer that is Offset bytes past a 64-byte boundary, Buffer must have 63 spare bytes
+
+static unsigned char *AlignBuffer(std::vector<unsigned char> &Buffer, int Offset)
+{
+	unsigned char *Data = Buffer.data();
+	return Data + ((64 - ((uintptr_t)Data & 63)) & 63) + Offset;
+}
+
+// MakeCaseImage
+// descriptor of an image whose rows start at Data, which is the address of the bottom row when the stride is negative
+
+static ImageDescriptor MakeCaseImage(unsigned char *Data, int Width, int Height, PixelFormat Format, int Stride)
+{
+	ImageDescriptor Image;
+	Image.Data = (Stride < 0) ? Data + (long long)(Height - 1) * -Stride : Data;
+	Image.Width = Width;
+	Image.Height = Height;
+	Image.Stride = Stride;
+	Image.Format = Format;
+	return Image;
+}
+
+// DescribeCase
+
+static std::string DescribeCase(const VerifyCase &Case)
+{
+	std::ostringstream Description;
+	Description << GetPixelFormatName(Case.Format) << " " << Case.Width << "x" << Case.Height
+				<< ", strides " << Case.SourceStride << "/" << Case.YStride
+				<< ", offsets " << Case.SourceOffset << "/" << Case.YOffset << (Case.Extremes ? ", extreme values" : "");
+	return Description.str();
+}
+
+// VerifyImplementation
+// the generator is reseeded for each case, so that case i has the same geometry for every target with the same
+// pixel formats and granularity
+
+VerifyResult VerifyImplementation(const VerifyTarget &Target, const VerifyOptions &Options)
+{
+	VerifyResult Result;
+	Result.Name = Target.Name;
+	Result.Cases = 0;
+	Result.FailedCases = 0;
+	Result.MaxError = 0;
+	Result.AllowedError = Target.AllowedError;
+	Result.Pixels = 0;
+	Result.DifferentPixels = 0;
+
+	for (int CaseIndex = 0; CaseIndex < Options.CaseCount; CaseIndex++)
+	{
+		std::mt19937 Random(Options.Seed * 7919u + (unsigned int)CaseIndex);
+		const VerifyCase Case = MakeVerifyCase(Random, Target, Options);
+		const int PixelSize = GetPixelSize(Case.Format);
+		const size_t SourceRowsSize = (size_t)Case.Height * abs(Case.SourceStride);
+		const size_t YRowsSize = (size_t)Case.Height * abs(Case.YStride);
+
+		// the source buffer ends with the image, so that reads past its end can be caught by memory checkers
+		std::vector<unsigned char> SourceBuffer(63 + Case.SourceOffset + SourceRowsSize);
+		unsigned char *SourceData = AlignBuffer(SourceBuffer, Case.SourceOffset);
+		for (size_t i = 0; i < SourceRowsSize; i++)
+			SourceData[i] = Case.Extremes ? ((Random() & 1) ? 255 : 0) : (unsigned char)Random();
+		// the luma buffer is filled with random bytes, so that any byte written outside the image is likely to change
+		std::vector<unsigned char> YBuffer(63 + Case.YOffset + VERIFY_GUARD_SIZE + YRowsSize + VERIFY_GUARD_SIZE);
+		unsigned char *YGuard = AlignBuffer(YBuffer, Case.YOffset);
+		for (size_t i = 0; i < VERIFY_GUARD_SIZE + YRowsSize + VERIFY_GUARD_SIZE; i++)
+			YGuard[i] = (unsigned char)Random();
+		const std::vector<unsigned char> YInitial(YGuard, YGuard + VERIFY_GUARD_SIZE + YRowsSize + VERIFY_GUARD_SIZE);
+		unsigned char *YData = YGuard + VERIFY_GUARD_SIZE;
+
+		const ImageDescriptor Source = MakeCaseImage(SourceData, Case.Width, Case.Height, Case.Format, Case.SourceStride);
+		const ImageDescriptor YImage = MakeCaseImage(YData, Case.Width, Case.Height, PIXEL_FORMAT_Y8, Case.YStride);
+		std::vector<unsigned char> Reference((size_t)Case.Width * Case.Height);
+		LumaFunction ReferenceFunction = GetLumaFunction(Case.Format, Target.Coefficients, false, LUMA_ISA_SCALAR, false);
+		for (int Row = 0; Row < Case.Height; Row++)
+			ReferenceFunction(GetImageRow(Source, Row), &Reference[(size_t)Row * Case.Width], Case.Width, 1, PixelSize);
+
+		Target.Function(Source, YImage);
+
+		int CaseError = 0;
+		for (int Row = 0; Row < Case.Height; Row++)
+		{
+			const unsigned char *YRow = GetImageRow(YImage, Row);
+			const unsigned char *ReferenceRow = &Reference[(size_t)Row * Case.Width];
+			for (int Column = 0; Column < Case.Width; Column++)
+			{
+				int Error = abs((int)YRow[Column] - (int)ReferenceRow[Column]);
+				if (Error)
+				{
+					Result.DifferentPixels++;
+					CaseError = std::max(CaseError, Error);
+				}
+			}
+		}
+		// only the pixels of the luma rows may change, the row padding and the guard bytes must keep their random values
+		std::vector<bool> InImage(YInitial.size(), false);
+		for (int Row = 0; Row < Case.Height; Row++)
+		{
+			const size_t RowStart = GetImageRow(YImage, Row) - YGuard;
+			for (int Column = 0; Column < Case.Width; Column++)
+				InImage[RowStart + Column] = true;
+		}
+		bool StrayWrites = false;
+		for (size_t i = 0; i < YInitial.size(); i++)
+			StrayWrites |= !InImage[i] && (YGuard[i] != YInitial[i]);
+
+		Result.Cases++;
+		Result.Pixels += (long long)Case.Width * Case.Height;
+		Result.MaxError = std::max(Result.MaxError, CaseError);
+		if ((CaseError > Target.AllowedError) || StrayWrites)
+		{
+			if (Result.FailedCases == 0)
+				Result.FirstFailure = DescribeCase(Case) + (StrayWrites ? ": wrote outside the luma image" :
+									  ": error " + std::to_string((long long)CaseError));
+			Result.FailedCases++;
+		}
+	}
+	return Result;
+}
+
+// VerifyExhaustively
+// the three color bytes of pixel i are the bytes of i, so with any channel order every color appears once; the alpha
+// byte of the 32-bit formats changes from pixel to pixel, so that a kernel that does not ignore it is caught too
+// the reference is computed over the whole image at once, the scalar kernel has no tail or split to get wrong
+
+bool VerifyExhaustively(const VerifyTarget &Target, PixelFormat Format, ExhaustiveResult &Result)
+{
+	const int IMAGE_SIZE = 4096;
+	const int PixelSize = GetPixelSize(Format);
+	const size_t PixelCount = (size_t)IMAGE_SIZE * IMAGE_SIZE;
+
+	Result.Name = Target.Name;
+	Result.Format = Format;
+	Result.AllowedError = Target.AllowedError;
+	Result.MinError = 0;
+	Result.MaxError = 0;
+	Result.MeanError = 0.0;
+	Result.Pixels = 0;
+	Result.ExactPixels = 0;
+	Result.OffByOnePixels = 0;
+
+	std::vector<unsigned char> SourceImage;
+	std::vector<unsigned char> YImage;
+	std::vector<unsigned char> Reference;
+	try
+	{
+		SourceImage.resize(PixelCount * PixelSize);
+		YImage.resize(PixelCount);
+		Reference.resize(PixelCount);
+	}
+	catch (const std::bad_alloc &)
+	{
+		return false;
+	}
+	const int AlphaOffset = (Format == PIXEL_FORMAT_ARGB32) ? 0 : 3;
+	unsigned char *PixelPtr = &SourceImage[0];
+	for (size_t Color = 0; Color < PixelCount; Color++)
+	{
+		int Shift = 16;
+		for (int i = 0; i < PixelSize; i++)
+		{
+			if ((PixelSize == 4) && (i == AlphaOffset))
+				PixelPtr[i] = (unsigned char)(Color * 167);
+			else
+			{
+				PixelPtr[i] = (unsigned char)(Color >> Shift);
+				Shift -= 8;
+			}
+		}
+		PixelPtr += PixelSize;
+	}
+
+	const ImageDescriptor Source = MakeImageDescriptor(&SourceImage[0], IMAGE_SIZE, IMAGE_SIZE, Format);
+	GetLumaFunction(Format, Target.Coefficients, false, LUMA_ISA_SCALAR, false)(&SourceImage[0], &Reference[0], IMAGE_SIZE, IMAGE_SIZE, PixelSize);
+	Target.Function(Source, MakeImageDescriptor(&YImage[0], IMAGE_SIZE, IMAGE_SIZE, PIXEL_FORMAT_Y8));
+
+	long long ErrorSum = 0;
+	for (size_t i = 0; i < PixelCount; i++)
+	{
+		const int Error = (int)YImage[i] - (int)Reference[i];
+		Result.MinError = std::min(Result.MinError, Error);
+		Result.MaxError = std::max(Result.MaxError, Error);
+		ErrorSum += Error;
+		Result.ExactPixels += (Error == 0);
+		Result.OffByOnePixels += (abs(Error) == 1);
+	}
+	Result.Pixels = (long long)PixelCount;
+	Result.MeanError = (double)ErrorSum / PixelCount;
+	return true;
+}
@@ -0,0 +1,85 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+#pragma once
+
+#include "TBBDemoImage.h"
+#include "TBBDemoKernel.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// VerifyFunction
+// converts Source into YImage, a PIXEL_FORMAT_Y8 image with the same dimensions
+typedef std::function<void(const ImageDescriptor &Source, const ImageDescriptor &YImage)> VerifyFunction;
+
+// an implementation checked by VerifyImplementation, and the cases it supports
+struct VerifyTarget {
+	std::string Name;
+	VerifyFunction Function;
+	std::vector<PixelFormat> Formats;	//< source pixel formats it is checked on
+	bool PackedOnly;					//< the function takes no stride, e.g. the ones with the (void *, void *, ...) signature
+	int PixelGranularity;				//< the number of pixels must be a multiple of it
+	LumaCoefficients Coefficients;		//< coefficients of the reference
+	int AllowedError;					//< largest difference from the reference, 0 for exact implementations
+
+	VerifyTarget(const std::string &Name, const VerifyFunction &Function, const std::vector<PixelFormat> &Formats,
+				 int AllowedError = 0, LumaCoefficients Coefficients = LUMA_BT601) :
+		Name(Name), Function(Function), Formats(Formats), PackedOnly(false), PixelGranularity(1),
+		Coefficients(Coefficients), AllowedError(AllowedError) {}
+};
+
+struct VerifyOptions {
+	int CaseCount;				//< random cases per implementation
+	unsigned int Seed;			//< every implementation gets the same cases for a given seed
+	int MaxWidth;
+	int MaxHeight;
+};
+
+struct VerifyResult {
+	std::string Name;
+	int Cases;
+	int FailedCases;			//< cases with an error above AllowedError, or with bytes written outside the luma image
+	int MaxError;				//< largest difference from the reference over all the cases
+	int AllowedError;
+	long long Pixels;
+	long long DifferentPixels;	//< pixels that are not bit-exact, also when within AllowedError
+	std::string FirstFailure;	//< description of the first failed case, empty when all of them passed
+};
+
+// RGB pixel formats, in the order of the PixelFormat enumeration
+std::vector<PixelFormat> GetRGBPixelFormats();
+
+// VerifyImplementation
+// runs Target on random images and compares each of them with the scalar kernel of the same pixel format and
+// coefficients, which is applied row by row so that it does not share any code with the stride handling under test
+// the cases vary the size, the pixel format, the padding of the source and luma rows, bottom-up images and the
+// alignment of the first pixel, and the bytes around the luma image are checked for stray writes
+VerifyResult VerifyImplementation(const VerifyTarget &Target, const VerifyOptions &Options);
+
+// error distribution of an implementation over every RGB color, see VerifyExhaustively
+struct ExhaustiveResult {
+	std::string Name;
+	PixelFormat Format;
+	int AllowedError;
+	int MinError;				//< most negative difference from the reference
+	int MaxError;				//< most positive difference from the reference
+	double MeanError;			//< average signed difference, biased coefficients show up here even when the errors are small
+	long long Pixels;
+	long long ExactPixels;
+	long long OffByOnePixels;	//< pixels that differ from the reference by 1 in either direction
+};
+
+// VerifyExhaustively
+// runs Target on a packed 4096x4096 image of the given RGB format that holds each of the 2^24 colors once, and
+// compares it with the scalar kernel of the same format and coefficients
+// returns false if the images cannot be allocated
+bool VerifyExhaustively(const VerifyTarget &Target, PixelFormat Format, ExhaustiveResult &Result);
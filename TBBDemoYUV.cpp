@@ -0,0 +1,457 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#include "TBBDemoYUV.h"
+#include "TBBDemoCPU.h"
+#include "TBBDemoKernel.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Intel TBB library
+#include <parallel_for.h>
+#include <blocked_range2d.h>
+using namespace tbb;
+
+// SIMD intrinsics
+#include <tmmintrin.h>
+
+// fixed point precision of the coefficients, chroma is computed from the sum of 4 pixels so its results are shifted
+// by 2 more bits
+const int YUV_SCALING_LOG = 15;
+const int YUV_CHROMA_SCALING_LOG = YUV_SCALING_LOG + 2;
+
+// pixels per row converted by each step of the SIMD loop, which produces 8 chroma samples per row pair
+const int YUV_BLOCK_PIXELS = 16;
+
+// YUVCoefficients
+// rows of the conversion matrix in fixed point, with the range scaling folded in
+// the green coefficients are derived from the other two so that each luma row adds up exactly to the range of Y
+// and each chroma row to zero: white maps to 255 (or 235) and every gray to a chroma of 128
+
+struct YUVCoefficients {
+	int YRed, YGreen, YBlue;
+	int URed, UGreen, UBlue;
+	int VRed, VGreen, VBlue;
+	int YOffset;		//< black level and rounding of luma
+	int ChromaOffset;	//< 128 and rounding of chroma
+};
+
+static YUVCoefficients GetYUVCoefficients(YUVMatrix Matrix, YUVRange Range)
+{
+	const double Kr = (Matrix == YUV_MATRIX_BT709) ? CoefficientsBT709::Red : CoefficientsBT601::Red;
+	const double Kb = (Matrix == YUV_MATRIX_BT709) ? CoefficientsBT709::Blue : CoefficientsBT601::Blue;
+	const double YScale = ((Range == YUV_RANGE_LIMITED) ? 219.0 / 255.0 : 1.0) * (1 << YUV_SCALING_LOG);
+	const double ChromaScale = ((Range == YUV_RANGE_LIMITED) ? 224.0 / 255.0 : 1.0) * (1 << YUV_SCALING_LOG);
+
+	YUVCoefficients Coefficients;
+	Coefficients.YRed = (int)floor(Kr * YScale + 0.5);
+	Coefficients.YBlue = (int)floor(Kb * YScale + 0.5);
+	Coefficients.YGreen = (int)floor(YScale + 0.5) - Coefficients.YRed - Coefficients.YBlue;
+	Coefficients.URed = (int)floor(-Kr / (2.0 * (1.0 - Kb)) * ChromaScale + 0.5);
+	Coefficients.UBlue = (int)floor(0.5 * ChromaScale + 0.5);
+	Coefficients.UGreen = -Coefficients.URed - Coefficients.UBlue;
+	Coefficients.VRed = Coefficients.UBlue;
+	Coefficients.VBlue = (int)floor(-Kb / (2.0 * (1.0 - Kr)) * ChromaScale + 0.5);
+	Coefficients.VGreen = -Coefficients.VRed - Coefficients.VBlue;
+	Coefficients.YOffset = (((Range == YUV_RANGE_LIMITED) ? 16 : 0) << YUV_SCALING_LOG) + (1 << (YUV_SCALING_LOG - 1));
+	Coefficients.ChromaOffset = (128 << YUV_CHROMA_SCALING_LOG) + (1 << (YUV_CHROMA_SCALING_LOG - 1));
+	return Coefficients;
+}
+
+// YUVConversion
+// everything the row pair functions need, the channel offsets are those of the source format
+
+struct YUVConversion {
+	ImageDescriptor Source;
+	YUVImage Destination;
+	YUVCoefficients Coefficients;
+	int PixelSize;
+	int RedOffset, GreenOffset, BlueOffset;
+	int ChromaWidth, ChromaHeight;
+};
+
+// CheckYUVImages
+// the images come from the caller, so they are checked in Release builds too: the source must have one of the 8-bit
+// RGB formats, and the rows of the planes must hold the samples of the source width
+
+static bool CheckYUVImages(const ImageDescriptor &Source, const YUVImage &Destination)
+{
+	if (!IsRGB8Format(Source.Format))
+		return false;
+	if ((Source.Width < 0) || (Source.Height < 0))
+		return false;
+	const int ChromaWidth = (Source.Width + 1) / 2;
+	if ((Destination.YPlane == 0) || (Destination.UPlane == 0) || (Destination.YStride < Source.Width))
+		return false;
+	if (Destination.Format == YUV_FORMAT_NV12)
+		return Destination.ChromaStride >= 2 * ChromaWidth;
+	return (Destination.VPlane != 0) && (Destination.ChromaStride >= ChromaWidth);
+}
+
+static YUVConversion MakeYUVConversion(const ImageDescriptor &Source, const YUVImage &Destination, YUVMatrix Matrix, YUVRange Range)
+{
+	YUVConversion Conversion;
+	Conversion.Source = Source;
+	Conversion.Destination = Destination;
+	Conversion.Coefficients = GetYUVCoefficients(Matrix, Range);
+	Conversion.PixelSize = GetPixelSize(Source.Format);
+	switch (Source.Format)
+	{
+	case PIXEL_FORMAT_BGR24:
+	case PIXEL_FORMAT_BGRA32:
+		Conversion.RedOffset = 2;
+		Conversion.GreenOffset = 1;
+		Conversion.BlueOffset = 0;
+		break;
+	case PIXEL_FORMAT_ARGB32:
+		Conversion.RedOffset = 1;
+		Conversion.GreenOffset = 2;
+		Conversion.BlueOffset = 3;
+		break;
+	default:
+		Conversion.RedOffset = 0;
+		Conversion.GreenOffset = 1;
+		Conversion.BlueOffset = 2;
+		break;
+	}
+	Conversion.ChromaWidth = (Source.Width + 1) / 2;
+	Conversion.ChromaHeight = (Source.Height + 1) / 2;
+	return Conversion;
+}
+
+static inline unsigned char ClampToByte(int Value)
+{
+	return (unsigned char)((Value < 0) ? 0 : ((Value > 255) ? 255 : Value));
+}
+
+// StoreChroma
+// writes a chroma sample pair in the layout of the destination
+
+static inline void StoreChroma(const YUVImage &Destination, int ChromaRow, int ChromaColumn, unsigned char UValue, unsigned char VValue)
+{
+	unsigned char *URow = Destination.UPlane + (long long)ChromaRow * Destination.ChromaStride;
+	if (Destination.Format == YUV_FORMAT_NV12)
+	{
+		URow[2 * ChromaColumn] = UValue;
+		URow[2 * ChromaColumn + 1] = VValue;
+	}
+	else
+	{
+		unsigned char *VRow = Destination.VPlane + (long long)ChromaRow * Destination.ChromaStride;
+		URow[ChromaColumn] = UValue;
+		VRow[ChromaColumn] = VValue;
+	}
+}
+
+// ConvertRowPairScalar
+// converts the chroma samples from StartColumn to StopColumn of a chroma row, together with the luma of the 2x2
+// pixels they cover; the last pixel row and column are repeated for the chroma of odd sized images
+// the shifts of negative sums are arithmetic, as those of _mm_srai_epi32
+
+static void ConvertRowPairScalar(const YUVConversion &Conversion, int ChromaRow, int StartColumn, int StopColumn)
+{
+	const YUVCoefficients &C = Conversion.Coefficients;
+	const int Width = Conversion.Source.Width;
+	const int Row0 = 2 * ChromaRow;
+	const int Row1 = std::min(Row0 + 1, Conversion.Source.Height - 1);
+	const unsigned char *SourceRows[2] = { GetImageRow(Conversion.Source, Row0), GetImageRow(Conversion.Source, Row1) };
+	unsigned char *YRows[2] = {
+		Conversion.Destination.YPlane + (long long)Row0 * Conversion.Destination.YStride,
+		(Row1 != Row0) ? Conversion.Destination.YPlane + (long long)Row1 * Conversion.Destination.YStride : NULL
+	};
+
+	for (int ChromaColumn = StartColumn; ChromaColumn < StopColumn; ChromaColumn++)
+	{
+		const int Columns[2] = { 2 * ChromaColumn, std::min(2 * ChromaColumn + 1, Width - 1) };
+		int RedSum = 0, GreenSum = 0, BlueSum = 0;
+		for (int i = 0; i < 2; i++)
+			for (int j = 0; j < 2; j++)
+			{
+				const unsigned char *Pixel = SourceRows[i] + Columns[j] * Conversion.PixelSize;
+				int Red = Pixel[Conversion.RedOffset];
+				int Green = Pixel[Conversion.GreenOffset];
+				int Blue = Pixel[Conversion.BlueOffset];
+				RedSum += Red;
+				GreenSum += Green;
+				BlueSum += Blue;
+				// the repeated pixels of odd sized images are counted in the chroma sum but their luma is written once
+				if (YRows[i] && ((j == 0) || (Columns[1] != Columns[0])))
+					YRows[i][Columns[j]] = ClampToByte((Red * C.YRed + Green * C.YGreen + Blue * C.YBlue + C.YOffset) >> YUV_SCALING_LOG);
+			}
+		int UValue = (RedSum * C.URed + GreenSum * C.UGreen + BlueSum * C.UBlue + C.ChromaOffset) >> YUV_CHROMA_SCALING_LOG;
+		int VValue = (RedSum * C.VRed + GreenSum * C.VGreen + BlueSum * C.VBlue + C.ChromaOffset) >> YUV_CHROMA_SCALING_LOG;
+		StoreChroma(Conversion.Destination, ChromaRow, ChromaColumn, ClampToByte(UValue), ClampToByte(VValue));
+	}
+}
+
+// YUVConstantsSSSE3
+// 24-bit pixels are spread to RGB0 order as in SSSE3Constants, 32-bit pixels keep their layout and the channel order
+// is folded into the scales, which hold the coefficients of 2 pixels as 16-bit values for _mm_madd_epi16
+
+struct YUVConstantsSSSE3 {
+	__m128i ShuffleMask;
+	__m128i YScale;
+	__m128i UScale;
+	__m128i VScale;
+	__m128i YOffset;
+	__m128i ChromaOffset;
+	__m128i ChromaOrder;
+
+	TARGET_SSSE3 YUVConstantsSSSE3(const YUVConversion &Conversion)
+	{
+		const YUVCoefficients &C = Conversion.Coefficients;
+		const bool Packed24 = (Conversion.PixelSize == 3);
+		const int Offsets[3] = {
+			Packed24 ? 0 : Conversion.RedOffset, Packed24 ? 1 : Conversion.GreenOffset, Packed24 ? 2 : Conversion.BlueOffset
+		};
+		short Scales[3][8] = { { 0 } };
+		for (int i = 0; i < 2; i++)
+		{
+			Scales[0][4 * i + Offsets[0]] = (short)C.YRed;
+			Scales[0][4 * i + Offsets[1]] = (short)C.YGreen;
+			Scales[0][4 * i + Offsets[2]] = (short)C.YBlue;
+			Scales[1][4 * i + Offsets[0]] = (short)C.URed;
+			Scales[1][4 * i + Offsets[1]] = (short)C.UGreen;
+			Scales[1][4 * i + Offsets[2]] = (short)C.UBlue;
+			Scales[2][4 * i + Offsets[0]] = (short)C.VRed;
+			Scales[2][4 * i + Offsets[1]] = (short)C.VGreen;
+			Scales[2][4 * i + Offsets[2]] = (short)C.VBlue;
+		}
+		YScale = _mm_loadu_si128((const __m128i *)Scales[0]);
+		UScale = _mm_loadu_si128((const __m128i *)Scales[1]);
+		VScale = _mm_loadu_si128((const __m128i *)Scales[2]);
+		ShuffleMask = _mm_setr_epi8(
+			(char)Conversion.RedOffset, (char)Conversion.GreenOffset, (char)Conversion.BlueOffset, (char)0x80,
+			(char)(3 + Conversion.RedOffset), (char)(3 + Conversion.GreenOffset), (char)(3 + Conversion.BlueOffset), (char)0x80,
+			(char)(6 + Conversion.RedOffset), (char)(6 + Conversion.GreenOffset), (char)(6 + Conversion.BlueOffset), (char)0x80,
+			(char)(9 + Conversion.RedOffset), (char)(9 + Conversion.GreenOffset), (char)(9 + Conversion.BlueOffset), (char)0x80);
+		YOffset = _mm_set1_epi32(C.YOffset);
+		ChromaOffset = _mm_set1_epi32(C.ChromaOffset);
+		// the packed chroma bytes are U0 U1 V0 V1 U2 U3 V2 V3 ..., I420 gathers U0..U7 and V0..V7, NV12 interleaves them
+		if (Conversion.Destination.Format == YUV_FORMAT_NV12)
+			ChromaOrder = _mm_setr_epi8(0, 2, 1, 3, 4, 6, 5, 7, 8, 10, 9, 11, 12, 14, 13, 15);
+		else
+			ChromaOrder = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+	}
+};
+
+// Load16PixelsSSSE3
+// loads 16 pixels in 4 registers of 4 pixels, one per 32-bit element, see Load4PixelsSSSE3
+
+static inline TARGET_SSSE3 void Load16PixelsSSSE3(const unsigned char *SourceImagePtr, int PixelSize, const YUVConstantsSSSE3 &Constants,
+												 __m128i RGBValue[4])
+{
+	const __m128i *SourcePtr = (const __m128i *)SourceImagePtr;
+	if (PixelSize == 4)
+	{
+		for (int i = 0; i < 4; i++)
+			RGBValue[i] = _mm_loadu_si128(SourcePtr + i);
+		return;
+	}
+	__m128i RGBValue0 = _mm_loadu_si128(SourcePtr);
+	__m128i RGBValue1 = _mm_loadu_si128(SourcePtr + 1);
+	__m128i RGBValue2 = _mm_loadu_si128(SourcePtr + 2);
+	RGBValue[0] = _mm_shuffle_epi8(RGBValue0, Constants.ShuffleMask);
+	RGBValue[1] = _mm_shuffle_epi8(_mm_alignr_epi8(RGBValue1, RGBValue0, 12), Constants.ShuffleMask);
+	RGBValue[2] = _mm_shuffle_epi8(_mm_alignr_epi8(RGBValue2, RGBValue1, 8), Constants.ShuffleMask);
+	RGBValue[3] = _mm_shuffle_epi8(_mm_srli_si128(RGBValue2, 4), Constants.ShuffleMask);
+}
+
+// ConvertLumaSSSE3
+// luma of the 4 pixels of a register unpacked to 16-bit values in two halves, computed as in ProcessRGBSIMD2
+
+static inline TARGET_SSSE3 __m128i ConvertLumaSSSE3(__m128i LowRGBValue, __m128i HighRGBValue, const YUVConstantsSSSE3 &Constants)
+{
+	__m128i YValue = _mm_hadd_epi32(_mm_madd_epi16(LowRGBValue, Constants.YScale), _mm_madd_epi16(HighRGBValue, Constants.YScale));
+	YValue = _mm_add_epi32(YValue, Constants.YOffset);
+	return _mm_srai_epi32(YValue, YUV_SCALING_LOG);
+}
+
+// ConvertChromaSSSE3
+// U0 U1 V0 V1 as 32-bit integers for the 2 chroma samples covered by 4 pixels of each row
+// the vertical sums of the unpacked pixels are added to their own upper half, which holds the horizontal neighbour,
+// so that the 2x2 sums stay in registers and go through _mm_madd_epi16 and _mm_hadd_epi32 like the luma
+
+static inline TARGET_SSSE3 __m128i ConvertChromaSSSE3(__m128i LowSum, __m128i HighSum, const YUVConstantsSSSE3 &Constants)
+{
+	LowSum = _mm_add_epi16(LowSum, _mm_srli_si128(LowSum, 8));
+	HighSum = _mm_add_epi16(HighSum, _mm_srli_si128(HighSum, 8));
+	__m128i RGBSum = _mm_unpacklo_epi64(LowSum, HighSum);
+	__m128i UVValue = _mm_hadd_epi32(_mm_madd_epi16(RGBSum, Constants.UScale), _mm_madd_epi16(RGBSum, Constants.VScale));
+	UVValue = _mm_add_epi32(UVValue, Constants.ChromaOffset);
+	return _mm_srai_epi32(UVValue, YUV_CHROMA_SCALING_LOG);
+}
+
+// ConvertBlockSSSE3
+// converts 16 pixels of a row pair into 16 luma values per row and 8 chroma samples
+// YImagePtr1 is NULL for the last row of an image with odd height, whose row is then passed twice as source
+
+static inline TARGET_SSSE3 void ConvertBlockSSSE3(const unsigned char *SourceImagePtr0, const unsigned char *SourceImagePtr1, int PixelSize,
+												 unsigned char *YImagePtr0, unsigned char *YImagePtr1, unsigned char *UImagePtr, unsigned char *VImagePtr,
+												 bool Interleaved, const YUVConstantsSSSE3 &Constants)
+{
+	const __m128i ZeroConst = _mm_setzero_si128();
+	__m128i RGBValue0[4], RGBValue1[4];
+	__m128i YValue0[4], YValue1[4], UVValue[4];
+	Load16PixelsSSSE3(SourceImagePtr0, PixelSize, Constants, RGBValue0);
+	Load16PixelsSSSE3(SourceImagePtr1, PixelSize, Constants, RGBValue1);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i LowRGBValue0 = _mm_unpacklo_epi8(RGBValue0[i], ZeroConst);
+		__m128i HighRGBValue0 = _mm_unpackhi_epi8(RGBValue0[i], ZeroConst);
+		__m128i LowRGBValue1 = _mm_unpacklo_epi8(RGBValue1[i], ZeroConst);
+		__m128i HighRGBValue1 = _mm_unpackhi_epi8(RGBValue1[i], ZeroConst);
+		YValue0[i] = ConvertLumaSSSE3(LowRGBValue0, HighRGBValue0, Constants);
+		YValue1[i] = ConvertLumaSSSE3(LowRGBValue1, HighRGBValue1, Constants);
+		UVValue[i] = ConvertChromaSSSE3(_mm_add_epi16(LowRGBValue0, LowRGBValue1), _mm_add_epi16(HighRGBValue0, HighRGBValue1), Constants);
+	}
+	// if (YValue > 255)
+	//	YValue = 255;
+	__m128i YValue = _mm_packus_epi16(_mm_packs_epi32(YValue0[0], YValue0[1]), _mm_packs_epi32(YValue0[2], YValue0[3]));
+	_mm_storeu_si128((__m128i *)YImagePtr0, YValue);
+	if (YImagePtr1)
+	{
+		YValue = _mm_packus_epi16(_mm_packs_epi32(YValue1[0], YValue1[1]), _mm_packs_epi32(YValue1[2], YValue1[3]));
+		_mm_storeu_si128((__m128i *)YImagePtr1, YValue);
+	}
+	__m128i ChromaValue = _mm_packus_epi16(_mm_packs_epi32(UVValue[0], UVValue[1]), _mm_packs_epi32(UVValue[2], UVValue[3]));
+	ChromaValue = _mm_shuffle_epi8(ChromaValue, Constants.ChromaOrder);
+	if (Interleaved)
+	{
+		_mm_storeu_si128((__m128i *)UImagePtr, ChromaValue);
+	}
+	else
+	{
+		_mm_storel_epi64((__m128i *)UImagePtr, ChromaValue);
+		_mm_storel_epi64((__m128i *)VImagePtr, _mm_srli_si128(ChromaValue, 8));
+	}
+}
+
+// ConvertRowPairSSSE3
+// converts the blocks of 16 pixels from StartBlock to StopBlock of a row pair, a block that extends past the right
+// edge of the image is converted by the scalar code
+
+static TARGET_SSSE3 void ConvertRowPairSSSE3(const YUVConversion &Conversion, const YUVConstantsSSSE3 &Constants, int ChromaRow,
+											 int StartBlock, int StopBlock)
+{
+	const YUVImage &Destination = Conversion.Destination;
+	const bool Interleaved = (Destination.Format == YUV_FORMAT_NV12);
+	const int Row0 = 2 * ChromaRow;
+	const int Row1 = std::min(Row0 + 1, Conversion.Source.Height - 1);
+	const int FullBlocks = Conversion.Source.Width / YUV_BLOCK_PIXELS;
+	const int ChromaBlock = YUV_BLOCK_PIXELS / 2;
+
+	const unsigned char *SourceImagePtr0 = GetImageRow(Conversion.Source, Row0);
+	const unsigned char *SourceImagePtr1 = GetImageRow(Conversion.Source, Row1);
+	unsigned char *YImagePtr0 = Destination.YPlane + (long long)Row0 * Destination.YStride;
+	unsigned char *YImagePtr1 = (Row1 != Row0) ? Destination.YPlane + (long long)Row1 * Destination.YStride : NULL;
+	unsigned char *UImagePtr = Destination.UPlane + (long long)ChromaRow * Destination.ChromaStride;
+	unsigned char *VImagePtr = Interleaved ? NULL : Destination.VPlane + (long long)ChromaRow * Destination.ChromaStride;
+
+	int Block = StartBlock;
+	for (; Block < std::min(StopBlock, FullBlocks); Block++)
+	{
+		const int x = Block * YUV_BLOCK_PIXELS;
+		const int ChromaX = Block * ChromaBlock;
+		ConvertBlockSSSE3(SourceImagePtr0 + x * Conversion.PixelSize, SourceImagePtr1 + x * Conversion.PixelSize, Conversion.PixelSize,
+						  YImagePtr0 + x, YImagePtr1 ? YImagePtr1 + x : NULL,
+						  UImagePtr + (Interleaved ? 2 * ChromaX : ChromaX), Interleaved ? NULL : VImagePtr + ChromaX,
+						  Interleaved, Constants);
+	}
+	if (Block < StopBlock)
+		ConvertRowPairScalar(Conversion, ChromaRow, Block * ChromaBlock, std::min(StopBlock * ChromaBlock, Conversion.ChromaWidth));
+}
+
+size_t GetYUV420Size(int Width, int Height)
+{
+	return (size_t)Width * Height + 2 * (size_t)((Width + 1) / 2) * ((Height + 1) / 2);
+}
+
+YUVImage MakeYUVImage(void *Buffer, int Width, int Height, YUVFormat Format)
+{
+	const int ChromaWidth = (Width + 1) / 2;
+	const int ChromaHeight = (Height + 1) / 2;
+
+	YUVImage Image;
+	Image.Format = Format;
+	Image.YPlane = (unsigned char *)Buffer;
+	Image.YStride = Width;
+	Image.UPlane = Image.YPlane + (size_t)Width * Height;
+	if (Format == YUV_FORMAT_NV12)
+	{
+		Image.VPlane = NULL;
+		Image.ChromaStride = 2 * ChromaWidth;
+	}
+	else
+	{
+		Image.VPlane = Image.UPlane + (size_t)ChromaWidth * ChromaHeight;
+		Image.ChromaStride = ChromaWidth;
+	}
+	return Image;
+}
+
+const char *GetYUVFormatName(YUVFormat Format)
+{
+	return (Format == YUV_FORMAT_NV12) ? "NV12" : "I420";
+}
+
+const char *GetYUVMatrixName(YUVMatrix Matrix)
+{
+	return (Matrix == YUV_MATRIX_BT709) ? "BT.709" : "BT.601";
+}
+
+const char *GetYUVRangeName(YUVRange Range)
+{
+	return (Range == YUV_RANGE_LIMITED) ? "limited" : "full";
+}
+
+bool ConvertToYUV420Reference(const ImageDescriptor &Source, const YUVImage &Destination, YUVMatrix Matrix, YUVRange Range)
+{
+	if (!CheckYUVImages(Source, Destination))
+		return false;
+	const YUVConversion Conversion = MakeYUVConversion(Source, Destination, Matrix, Range);
+	for (int ChromaRow = 0; ChromaRow < Conversion.ChromaHeight; ChromaRow++)
+		ConvertRowPairScalar(Conversion, ChromaRow, 0, Conversion.ChromaWidth);
+	return true;
+}
+
+// ConvertToYUV420
+// the image is split in tiles of row pairs and blocks of 16 pixels, so that chunk boundaries never fall inside a
+// 2x2 group or a SIMD register; without SSSE3 the tiles are converted by the scalar code
+
+bool ConvertToYUV420(const ImageDescriptor &Source, const YUVImage &Destination, YUVMatrix Matrix, YUVRange Range)
+{
+	if (!CheckYUVImages(Source, Destination))
+		return false;
+	const YUVConversion Conversion = MakeYUVConversion(Source, Destination, Matrix, Range);
+	const int ColumnBlocks = (Source.Width + YUV_BLOCK_PIXELS - 1) / YUV_BLOCK_PIXELS;
+	const bool UseSSSE3 = GetCPUFeatures().SSSE3;
+
+	parallel_for( blocked_range2d<int,int>( 0, Conversion.ChromaHeight, 0, ColumnBlocks),
+	    [&](const blocked_range2d<int,int>& r) {
+			if (UseSSSE3)
+			{
+				const YUVConstantsSSSE3 Constants(Conversion);
+				for (int ChromaRow = r.rows().begin(); ChromaRow != r.rows().end(); ChromaRow++)
+					ConvertRowPairSSSE3(Conversion, Constants, ChromaRow, r.cols().begin(), r.cols().end());
+			}
+			else
+			{
+				const int ChromaBlock = YUV_BLOCK_PIXELS / 2;
+				for (int ChromaRow = r.rows().begin(); ChromaRow != r.rows().end(); ChromaRow++)
+					ConvertRowPairScalar(Conversion, ChromaRow, r.cols().begin() * ChromaBlock,
+										 std::min(r.cols().end() * ChromaBlock, Conversion.ChromaWidth));
+			}
+	      }
+	    );
+	return true;
+}
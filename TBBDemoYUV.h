@@ -0,0 +1,69 @@
+// Intel TBB Demo
+// by Stefano Tommesani (www.tommesani.com) 2013
+// this code is release under the Code Project Open License (CPOL) http://www.codeproject.com/info/cpol10.aspx
+// The main points subject to the terms of the License are:
+// -   Source Code and Executable Files can be used in commercial applications;
+// -   Source Code and Executable Files can be redistributed; and
+// -   Source Code can be modified to create derivative works.
+// -   No claim of suitability, guarantee, or any warranty whatsoever is provided. The software is provided "as-is".
+// -   The Article(s) accompanying the Work may not be distributed or republished without the Author's consent
+
+
+#pragma once
+
+#include "TBBDemoImage.h"
+
+#include <stddef.h>
+
+// 4:2:0 layouts: a full resolution luma plane followed by chroma at half resolution in both directions
+enum YUVFormat {
+	YUV_FORMAT_I420,		//< separate U and V planes
+	YUV_FORMAT_NV12			//< a single plane of interleaved U and V samples
+};
+
+enum YUVMatrix {
+	YUV_MATRIX_BT601,
+	YUV_MATRIX_BT709
+};
+
+enum YUVRange {
+	YUV_RANGE_FULL,			//< Y, U and V in 0..255
+	YUV_RANGE_LIMITED		//< Y in 16..235, U and V in 16..240
+};
+
+// YUVImage
+// describes the planes of a 4:2:0 image of Width x Height pixels, the chroma planes have (Width + 1) / 2 x
+// (Height + 1) / 2 samples, an odd last row or column of pixels has its own chroma samples
+// with YUV_FORMAT_NV12 UPlane points to the interleaved plane, whose rows hold 2 bytes per sample, and VPlane is unused
+
+struct YUVImage {
+	YUVFormat Format;
+	unsigned char *YPlane;
+	unsigned char *UPlane;
+	unsigned char *VPlane;
+	int YStride;
+	int ChromaStride;
+};
+
+// GetYUV420Size
+// size of the buffer that holds the tightly packed planes of a 4:2:0 image
+size_t GetYUV420Size(int Width, int Height);
+
+// MakeYUVImage
+// lays the planes out one after the other in Buffer, which must hold GetYUV420Size(Width, Height) bytes
+YUVImage MakeYUVImage(void *Buffer, int Width, int Height, YUVFormat Format);
+
+const char *GetYUVFormatName(YUVFormat Format);
+const char *GetYUVMatrixName(YUVMatrix Matrix);
+const char *GetYUVRangeName(YUVRange Range);
+
+// ConvertToYUV420Reference
+// serial scalar conversion of an RGB24, RGBA32, BGR24, BGRA32 or ARGB32 image, the reference of ConvertToYUV420
+// each chroma sample is computed from the sum of the 2x2 pixels it covers, the last row and column being repeated
+// when the image size is odd
+// returns false, without converting anything, when the source format is not supported or the planes are too narrow
+bool ConvertToYUV420Reference(const ImageDescriptor &Source, const YUVImage &Destination, YUVMatrix Matrix, YUVRange Range);
+
+// ConvertToYUV420
+// multi-threaded conversion with the same results as ConvertToYUV420Reference, SSSE3 code is used when available
+bool ConvertToYUV420(const ImageDescriptor &Source, const YUVImage &Destination, YUVMatrix Matrix, YUVRange Range);
@@ -5,10 +5,25 @@
 
 #pragma once
 
+#if defined(_WIN32)
 #include "targetver.h"
+#endif
 
 #include <stdio.h>
+
+#if defined(_WIN32)
 #include <tchar.h>
+#else
+// narrow-character mapping of the generic-text routines used by the demo
+#include <stdlib.h>
+#include <string.h>
+typedef char _TCHAR;
+#define _tmain main
+#define _T(x) x
+#define _tcscmp strcmp
+#define _ttoi atoi
+#define _tfopen fopen
+#endif
 
 
 